@@ -1,11 +1,38 @@
 #include "argparse.hpp"
+#include <algorithm>
 #include <getopt.h>
+#include <limits>
+#include <string_view>
 #include <unistd.h>
 
 namespace {
 constexpr const struct option LONG_FLAGS[] = {
     {"ignore", required_argument, nullptr, 'i'},
     {"ignore-category", required_argument, nullptr, 'c'},
+    {"jobs", required_argument, nullptr, 'j'},
+    {"serve", required_argument, nullptr, 's'},
+    {"lsp", no_argument, nullptr, 'l'},
+    {"cache-dir", required_argument, nullptr, 'C'},
+    {"watch", no_argument, nullptr, 'w'},
+    {"instances", no_argument, nullptr, 'n'},
+    {"project", no_argument, nullptr, 'P'},
+    {"shard", required_argument, nullptr, 'S'},
+    {"save-results", required_argument, nullptr, 'o'},
+    {"merge", no_argument, nullptr, 'm'},
+    {"rule-timeout", required_argument, nullptr, 't'},
+    {"max-results", required_argument, nullptr, 'M'},
+    {"timings", optional_argument, nullptr, 'T'},
+    {"search-stats", no_argument, nullptr, 'X'},
+    {"trace", required_argument, nullptr, 'r'},
+    {"mem-stats", no_argument, nullptr, 'e'},
+    {"perf-counters", no_argument, nullptr, 'H'},
+    {"item-costs", optional_argument, nullptr, 'I'},
+    {"stats", optional_argument, nullptr, 'Z'},
+    {"format", required_argument, nullptr, 'F'},
+    {"snippets", no_argument, nullptr, 'K'},
+    {"parse-only", no_argument, nullptr, 'p'},
+    {"changed-lines", required_argument, nullptr, 'L'},
+    {"git-diff", required_argument, nullptr, 'g'},
     {"help", no_argument, nullptr, 'h'},
     {0, 0, 0, 0},
 };
@@ -34,13 +61,106 @@ bool add_ignored_category(LZN::Arguments &results, const char *arg) {
   }
   return false;
 }
+
+// `--connect socket` may appear anywhere before a "--", every other argument is forwarded to the
+// server untouched. Returns false if there is no `--connect`.
+bool parse_connect(int argc, char *argv[], LZN::Arguments &results) {
+  constexpr std::string_view flag = "--connect";
+  int found = -1;
+  for (int i = 1; i < argc && found < 0; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--")
+      break;
+    if (arg == flag || (arg.substr(0, flag.size()) == flag && arg[flag.size()] == '='))
+      found = i;
+  }
+  if (found < 0)
+    return false;
+
+  const std::string_view arg = argv[found];
+  int skip = 1;
+  if (arg.size() > flag.size()) {
+    results.connect_socket = arg.substr(flag.size() + 1);
+  } else if (found + 1 < argc) {
+    results.connect_socket = argv[found + 1];
+    skip = 2;
+  }
+  for (int i = 1; i < argc; ++i) {
+    if (i < found || i >= found + skip)
+      results.forwarded_args.push_back(argv[i]);
+  }
+  return true;
+}
+
+bool parse_positive(const char *arg, unsigned int &out) {
+  try {
+    std::size_t end;
+    const long value = std::stol(arg, &end);
+    if (arg[end] != '\0' || value <= 0 || value > std::numeric_limits<unsigned int>::max())
+      return false;
+    out = static_cast<unsigned int>(value);
+    return true;
+  } catch (const std::invalid_argument &) {
+  } catch (const std::out_of_range &) {}
+  return false;
+}
+
+// Parses "i/n" with 1 <= i <= n into the shard of `results`.
+bool parse_shard(LZN::Arguments &results, const char *arg) {
+  const std::string_view s = arg;
+  const std::size_t slash = s.find('/');
+  if (slash == std::string_view::npos)
+    return false;
+  if (!parse_positive(std::string(s.substr(0, slash)).c_str(), results.shard_index) ||
+      !parse_positive(std::string(s.substr(slash + 1)).c_str(), results.shard_count))
+    return false;
+  return results.shard_index <= results.shard_count;
+}
+
+// Parses "file:first-last" or "file:line" and adds it to the changed lines.
+bool add_changed_lines(LZN::Arguments &results, const char *arg) {
+  const std::string_view s = arg;
+  const std::size_t colon = s.rfind(':');
+  if (colon == std::string_view::npos || colon == 0)
+    return false;
+  const std::string lines(s.substr(colon + 1));
+  const std::size_t dash = lines.find('-');
+  unsigned int first = 0;
+  unsigned int last = 0;
+  if (!parse_positive(lines.substr(0, dash).c_str(), first))
+    return false;
+  if (dash == std::string::npos)
+    last = first;
+  else if (!parse_positive(lines.substr(dash + 1).c_str(), last) || last < first)
+    return false;
+
+  if (!results.changed_lines)
+    results.changed_lines.emplace();
+  results.changed_lines->push_back({std::string(s.substr(0, colon)), first, last});
+  return true;
+}
 } // namespace
 
 namespace LZN {
 void print_help_msg() {
   std::cout << //
       "Usage:\n"
-      "  lzn [--help] [--ignore idOrName] [--ignore-category name] [--] modelfile [datafiles...]\n"
+      "  lzn [--help] [--ignore idOrName] [--ignore-category name] [--cache-dir dir]\n"
+      "      [--parse-only] [--changed-lines file:first-last] [--git-diff rev]\n"
+      "      [--rule-timeout ms] [--max-results N] [--timings[=json]]\n"
+      "      [--search-stats] [--trace file] [--mem-stats] [--perf-counters]\n"
+      "      [--item-costs[=N]] [--format text|json|sarif|ndjson] [--snippets] [--]\n"
+      "      modelfile [datafiles...]\n"
+      "  lzn --stats[=table|json] [--] modelfile [datafiles...]\n"
+      "  lzn --jobs N [flags...] [--] modelfiles...\n"
+      "  lzn --watch [flags...] [--] modelfile [datafiles...]\n"
+      "  lzn --instances [--jobs N] [flags...] [--] modelfile datafiles...\n"
+      "  lzn --project [--jobs N] [flags...] [--] modelfiles...\n"
+      "  lzn [--shard i/n] [--save-results file] [--jobs N] [flags...] [--] modelfiles...\n"
+      "  lzn --merge [--] resultfiles...\n"
+      "  lzn --serve socket\n"
+      "  lzn --connect socket [arguments...]\n"
+      "  lzn --lsp [--ignore idOrName] [--ignore-category name] [--parse-only]\n"
       "\n"
       "Flags:\n"
       "  --help/-h                  Print this help message.\n"
@@ -57,7 +177,96 @@ void print_help_msg() {
       std::cout << ", ";
     std::cout << CATEGORY_NAMES[i];
   }
-  std::cout << "." << std::endl;
+  std::cout << ".\n";
+
+  std::cout << //
+      "  --jobs/-j N                Lint several models, without data files, in N worker\n"
+      "                             processes. The output is printed in the same order as the\n"
+      "                             models are given.\n"
+      "  --serve socket             Keep running and lint requests from clients that connect to\n"
+      "                             the Unix domain socket `socket`.\n"
+      "  --connect socket           Let the server on `socket` lint with the other arguments and\n"
+      "                             print its output. The model may be \"-\" to send it from\n"
+      "                             stdin. Setting LZN_SERVER=socket in the environment does the\n"
+      "                             same for every invocation, falling back to linting locally\n"
+      "                             if there is no server.\n"
+      "  --lsp                      Run a language server on stdin and stdout, for editors.\n"
+      "  --cache-dir dir            Store results in `dir` and reuse them as long as the model,\n"
+      "                             the files it includes, the data files, the rules and the\n"
+      "                             linter are unchanged, and keep the reduced copies of the\n"
+      "                             standard library there.\n"
+      "  --watch                    Lint again whenever the model, a file it includes or a data\n"
+      "                             file changes, and print the results that are new or gone.\n"
+      "  --instances                Lint the model once for every data file, with --jobs N in\n"
+      "                             parallel. Results that don't depend on the data are only\n"
+      "                             found once. Prints the results of all instances and then\n"
+      "                             those of only some of them.\n"
+      "  --project                  Lint several models, without data files, as one project,\n"
+      "                             with --jobs N in parallel. Files that several models include\n"
+      "                             are linted once where possible and every result is printed\n"
+      "                             once.\n"
+      "  --shard i/n                Only lint the i-th of n equal parts of the models, for\n"
+      "                             spreading a run over several machines. The models are\n"
+      "                             sorted first, so each machine may list them in any order.\n"
+      "  --save-results file        Write the results of the models to `file` instead of\n"
+      "                             printing them, to print them later with --merge.\n"
+      "  --merge                    Print the results in the files written by --save-results,\n"
+      "                             e.g. one per shard, sorted and every result once.\n"
+      "  --format text|json|sarif|ndjson\n"
+      "                             Print the results as text for people, the default, as one\n"
+      "                             JSON object, as a SARIF 2.1.0 log or as one line of JSON\n"
+      "                             per result, each printed as soon as it is found. Results\n"
+      "                             carry their rule, region, message, subresults and rewrite.\n"
+      "                             With --jobs, one document is printed per model.\n"
+      "  --snippets                 Add the source lines of each result to the JSON, SARIF and\n"
+      "                             NDJSON output. Without it, these formats read no source\n"
+      "                             files.\n"
+      "  --parse-only               Only run the rules that don't need types, straight after\n"
+      "                             parsing. The model isn't typechecked. Without this flag, a\n"
+      "                             model with type errors still gets the results of these\n"
+      "                             rules.\n"
+      "  --changed-lines file:first-last\n"
+      "                             Only report what overlaps these lines, e.g. the ones changed\n"
+      "                             in a commit. Rules that look at single items only look at\n"
+      "                             the items there. Repeatable, a single line may be given as\n"
+      "                             file:line.\n"
+      "  --git-diff rev             As --changed-lines, for the lines that changed in the git\n"
+      "                             working tree since the revision `rev`.\n"
+      "  --rule-timeout ms          Stop each rule after `ms` milliseconds. Its results so far\n"
+      "                             are kept and the rule is reported as stopped early.\n"
+      "  --max-results N            Stop linting after N results. The rules that couldn't run\n"
+      "                             to the end are reported as stopped early.\n"
+      "  --timings[=table|json]     Print the wall and CPU time of parsing, typechecking, each\n"
+      "                             cached analysis, each rule and printing to stderr, with the\n"
+      "                             number of results of each rule. As a table, or with =json\n"
+      "                             as one line of JSON per model.\n"
+      "  --search-stats             Print how much work the searches of each rule do to stderr:\n"
+      "                             expressions expanded, children queued and filtered, matches,\n"
+      "                             backtracks and top-level items skipped. Needs a build with\n"
+      "                             -DLZN_SEARCH_STATS=ON.\n"
+      "  --trace file               Write trace events of parsing, typechecking, each cached\n"
+      "                             analysis, each rule, each top-level item a rule looks at\n"
+      "                             and printing to `file`, for chrome://tracing or Perfetto.\n"
+      "                             Only when linting a single model.\n"
+      "  --mem-stats                Print how much memory parsing, typechecking, each cached\n"
+      "                             analysis, each rule and printing needed to stderr, as the\n"
+      "                             growth of the maximum resident set size. Builds with\n"
+      "                             -DLZN_MEM_STATS=ON also count the allocations, the bytes\n"
+      "                             allocated and the peak of live bytes. With --timings=json\n"
+      "                             the memory is part of the JSON instead.\n"
+      "  --perf-counters            Print the CPU cycles, instructions, cache misses and branch\n"
+      "                             misses of parsing, typechecking, each cached analysis, each\n"
+      "                             rule and printing to stderr. Linux only, the counters that\n"
+      "                             can't be opened, e.g. in containers, are left out. With\n"
+      "                             --timings=json the counts are part of the JSON instead.\n"
+      "  --item-costs[=N]           Print the N top-level items, 20 by default, that the rules\n"
+      "                             and cached analyses spent the most time in to stderr, with\n"
+      "                             the number of expressions searched in each one.\n"
+      "  --stats[=table|json]       Print a census of the model instead of linting it: items by\n"
+      "                             kind, expressions by kind and operator, their depth,\n"
+      "                             comprehensions and generators, var and par declarations,\n"
+      "                             the sizes of literal arrays and how many items come from\n"
+      "                             the user files and the standard library.\n";
 }
 
 ArgRes parse_args(int argc, char *argv[]) {
@@ -65,8 +274,16 @@ ArgRes parse_args(int argc, char *argv[]) {
     return ArgError{"no arguments given"};
 
   Arguments results;
+  if (parse_connect(argc, argv, results)) {
+    if (results.connect_socket.empty())
+      return ArgError{"missing argument for flag: --connect"};
+    return results;
+  }
+
+  // Start over, the server parses the arguments of every request in a forked copy of itself.
+  optind = 0;
   while (true) {
-    int opt = getopt_long(argc, argv, "+:i:c:h", LONG_FLAGS, nullptr);
+    int opt = getopt_long(argc, argv, "+:i:c:j:h", LONG_FLAGS, nullptr);
     if (opt == -1)
       break;
 
@@ -77,6 +294,83 @@ ArgRes parse_args(int argc, char *argv[]) {
         return ArgError{"invalid category name"};
       };
       break;
+    case 'j':
+      if (!parse_positive(optarg, results.jobs)) {
+        return ArgError{"invalid number of jobs"};
+      }
+      break;
+    case 's': results.serve_socket = optarg; break;
+    case 'l': results.lsp = true; break;
+    case 'C': results.cache_dir = optarg; break;
+    case 'w': results.watch = true; break;
+    case 'n': results.instances = true; break;
+    case 'P': results.project = true; break;
+    case 'S':
+      if (!parse_shard(results, optarg)) {
+        return ArgError{"invalid shard, expected i/n with 1 <= i <= n"};
+      }
+      break;
+    case 'o': results.save_results = optarg; break;
+    case 'm': results.merge = true; break;
+    case 't':
+      if (!parse_positive(optarg, results.rule_timeout)) {
+        return ArgError{"invalid rule timeout"};
+      }
+      break;
+    case 'M':
+      if (!parse_positive(optarg, results.max_results)) {
+        return ArgError{"invalid maximum number of results"};
+      }
+      break;
+    case 'T':
+      results.timings = optarg != nullptr ? optarg : "table";
+      if (results.timings != "table" && results.timings != "json") {
+        return ArgError{"invalid timings format, expected table or json"};
+      }
+      break;
+    case 'X':
+#ifdef LZN_SEARCH_STATS
+      results.search_stats = true;
+      break;
+#else
+      return ArgError{"--search-stats needs a build with -DLZN_SEARCH_STATS=ON"};
+#endif
+    case 'r': results.trace = optarg; break;
+    case 'e': results.mem_stats = true; break;
+    case 'H': results.perf_counters = true; break;
+    case 'I':
+      results.item_costs = 20;
+      if (optarg != nullptr && !parse_positive(optarg, results.item_costs)) {
+        return ArgError{"invalid number of items"};
+      }
+      break;
+    case 'Z':
+      results.stats = optarg != nullptr ? optarg : "table";
+      if (results.stats != "table" && results.stats != "json") {
+        return ArgError{"invalid stats format, expected table or json"};
+      }
+      break;
+    case 'F':
+      results.format = optarg;
+      if (results.format != "text" && results.format != "json" && results.format != "sarif" &&
+          results.format != "ndjson") {
+        return ArgError{"invalid format, expected text, json, sarif or ndjson"};
+      }
+      break;
+    case 'K': results.snippets = true; break;
+    case 'p': results.parse_only = true; break;
+    case 'L':
+      if (!add_changed_lines(results, optarg)) {
+        return ArgError{"invalid changed lines, expected file:first-last"};
+      }
+      break;
+    case 'g':
+      // Anything else would be taken as an option by git.
+      if (optarg[0] == '-' || optarg[0] == '\0') {
+        return ArgError{"invalid git revision"};
+      }
+      results.git_diff = optarg;
+      break;
     case 'h': return PrintHelp{};
     case ':': {
       std::string msg = "missing argument for flag: ";
@@ -91,9 +385,64 @@ ArgRes parse_args(int argc, char *argv[]) {
     }
   }
 
+  if (!results.serve_socket.empty() || results.lsp)
+    return results;
+
   if (optind >= argc) {
     return ArgError{"missing required positional argument, namely the model file"};
   }
+
+  if (results.watch && (results.jobs > 0 || std::string_view(argv[optind]) == "-"))
+    return ArgError{"--watch needs a model file and can't be combined with --jobs"};
+
+  if (results.instances && results.watch)
+    return ArgError{"--instances can't be combined with --watch"};
+
+  if (results.format != "text" && (results.watch || results.instances))
+    return ArgError{"--format can't be combined with --watch or --instances"};
+
+  if (results.project && (results.watch || results.instances))
+    return ArgError{"--project can't be combined with --watch or --instances"};
+
+  if ((results.changed_lines || !results.git_diff.empty()) &&
+      (results.watch || results.instances || results.project))
+    return ArgError{
+        "--changed-lines and --git-diff can't be combined with --watch, --instances or --project"};
+
+  const bool sharded = results.shard_count > 0 || !results.save_results.empty();
+  if (sharded && (results.watch || results.instances || results.project || results.merge))
+    return ArgError{"--shard and --save-results can't be combined with --watch, --instances, "
+                    "--project or --merge"};
+
+  if (results.merge && (results.watch || results.instances || results.project))
+    return ArgError{"--merge can't be combined with --watch, --instances or --project"};
+
+  if (!results.trace.empty() && (results.jobs > 0 || results.watch || results.instances ||
+                                 results.project || sharded || results.merge))
+    return ArgError{"--trace can only be used when linting a single model"};
+
+  if (!results.stats.empty() && (results.jobs > 0 || results.watch || results.instances ||
+                                 results.project || sharded || results.merge))
+    return ArgError{"--stats can only be used for a single model"};
+
+  if ((results.jobs > 0 || results.project || sharded || results.merge) && !results.instances) {
+    for (int i = optind; i < argc; i++) {
+      results.models.push_back(argv[i]);
+    }
+    if (results.shard_count > 0) {
+      // Every machine must split the same models the same way, whatever order they are given in.
+      std::sort(results.models.begin(), results.models.end());
+      results.models.erase(std::unique(results.models.begin(), results.models.end()),
+                           results.models.end());
+      std::vector<std::string> shard;
+      for (std::size_t i = results.shard_index - 1; i < results.models.size();
+           i += results.shard_count)
+        shard.push_back(std::move(results.models[i]));
+      results.models = std::move(shard);
+    }
+    return results;
+  }
+
   // TODO: normalize filename?
   results.model_filename = argv[optind];
   ++optind;
@@ -103,6 +452,9 @@ ArgRes parse_args(int argc, char *argv[]) {
     results.datafiles.push_back(argv[i]);
   }
 
+  if (results.instances && results.datafiles.empty())
+    return ArgError{"--instances needs at least one data file"};
+
   return results;
 }
 
@@ -122,4 +474,5 @@ bool is_rule_ignored(const Arguments &args, const LintRule &rule) {
 
   return false;
 }
+
 } // namespace LZN
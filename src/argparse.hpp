@@ -1,6 +1,8 @@
 #pragma once
 
+#include <linter/changed_lines.hpp>
 #include <linter/rules.hpp>
+#include <optional>
 #include <string>
 #include <variant>
 #include <vector>
@@ -18,6 +20,36 @@ class Arguments {
 public:
   std::string model_filename; // required
   std::vector<std::string> datafiles;
+  unsigned int jobs = 0;           // 0 means that only `model_filename` is linted, in-process
+  std::vector<std::string> models; // every model to lint when `jobs` or `project` is set
+  std::string serve_socket;        // serve lint requests on this socket instead of linting
+  std::string connect_socket;      // send `forwarded_args` to the server on this socket
+  std::vector<std::string> forwarded_args;
+  bool lsp = false;      // run a language server on stdin and stdout instead of linting
+  std::string cache_dir; // where to cache results between runs, empty to not cache
+  bool watch = false;    // lint again whenever the model or data files change
+  bool instances = false; // each data file is an instance of its own, linted with the model
+  bool project = false;   // lint `models` together, files they share only once
+  // Only lint shard `shard_index` of `shard_count` of the sorted `models`, if the count isn't 0.
+  unsigned int shard_index = 0;
+  unsigned int shard_count = 0;
+  std::string save_results; // write the results of `models` to this file instead of printing them
+  bool merge = false;       // print the results of the shards saved in the files `models`
+  bool parse_only = false; // only run the rules that don't use types, the model isn't typechecked
+  // Only report what overlaps these lines, if given. Item-local rules only look at those items.
+  std::optional<std::vector<LineRange>> changed_lines;
+  std::string git_diff; // add the lines changed since this git revision to `changed_lines`
+  unsigned int rule_timeout = 0; // stop each rule after this many milliseconds, 0 for no limit
+  unsigned int max_results = 0;  // stop all rules after this many results, 0 for no limit
+  std::string timings; // print the time of each phase and rule as a "table" or "json", if set
+  bool search_stats = false;   // print the work of the searches of each rule
+  std::string trace;           // write trace events of the run to this file, if set
+  bool mem_stats = false;      // print the memory of each phase and rule
+  bool perf_counters = false;  // print the hardware counters of each phase and rule
+  unsigned int item_costs = 0; // print this many of the most expensive top-level items
+  std::string stats; // print a census of the model as a "table" or "json" instead of linting
+  std::string format = "text"; // of the results: "text", "json", "sarif" or "ndjson"
+  bool snippets = false;       // add the source lines of each result to the other formats
   std::vector<lintId> ignored_rules;
   std::vector<std::string> ignored_rule_names;
   std::vector<Category> ignored_categories;
@@ -0,0 +1,77 @@
+#include "batch.hpp"
+#include "driver.hpp"
+#include "processpool.hpp"
+#include <iostream>
+#include <linter/result_io.hpp>
+#include <linter/stdoutprinter.hpp>
+#include <map>
+#include <set>
+
+namespace LZN {
+int lint_instances(const Arguments &args) {
+  std::vector<const LintRule *> model_rules;
+  std::vector<const LintRule *> instance_rules;
+  for (auto rule : enabled_rules(args))
+    (rule->data == Data::UNUSED ? model_rules : instance_rules).push_back(rule);
+
+  auto common = lint_results(model_rules, args.model_filename, {}, std::cerr, std::nullopt, nullptr,
+                             Focus(), Monitor(), args.cache_dir);
+  if (!common)
+    return EXIT_FAILURE;
+
+  std::vector<LintedJob> instances;
+  if (!instance_rules.empty()) {
+    instances = lint_each(args.datafiles, args.jobs, [&](std::uint32_t i, std::ostream &err) {
+      return lint_results(instance_rules, args.model_filename, {args.datafiles[i]}, err,
+                          std::nullopt, nullptr, Focus(), Monitor(), args.cache_dir);
+    });
+  }
+
+  int status = EXIT_SUCCESS;
+  std::size_t linted = 0;
+  std::map<ResultKey, std::size_t> seen_in; // how many instances have a result
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    std::cerr << instances[i].err << std::flush;
+    if (!instances[i].results) {
+      std::cerr << "instance " << args.datafiles[i] << " couldn't be linted" << std::endl;
+      status = EXIT_FAILURE;
+      continue;
+    }
+    ++linted;
+    std::set<ResultKey> keys;
+    for (const auto &r : *instances[i].results)
+      keys.insert(key_of(r));
+    for (const auto &k : keys)
+      ++seen_in[k];
+  }
+
+  // Results of every instance are printed once, in the order of the first instance.
+  std::vector<std::vector<LintResult>> only_some(instances.size());
+  std::set<ResultKey> printed;
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    if (!instances[i].results)
+      continue;
+    for (auto &r : *instances[i].results) {
+      const ResultKey key = key_of(r);
+      if (seen_in[key] < linted)
+        only_some[i].push_back(std::move(r));
+      else if (printed.insert(key).second)
+        common->push_back(std::move(r));
+    }
+  }
+
+  std::cout << "results for all " << args.datafiles.size() << " instances:" << std::endl;
+  stdout_print(*common);
+  std::size_t specific = 0;
+  for (std::size_t i = 0; i < only_some.size(); ++i) {
+    if (only_some[i].empty())
+      continue;
+    specific += only_some[i].size();
+    std::cout << "results for " << args.datafiles[i] << ", but not every instance:" << std::endl;
+    stdout_print(only_some[i]);
+  }
+  std::cout << common->size() << " results for all instances, " << specific
+            << " for only some of them" << std::endl;
+  return status;
+}
+} // namespace LZN
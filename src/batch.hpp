@@ -0,0 +1,12 @@
+#pragma once
+
+#include "argparse.hpp"
+
+namespace LZN {
+// Lint `args.model_filename` once for each of `args.datafiles`, each data file being one instance.
+// Rules that don't use the data are only run once, on the model without data, the others are run
+// for every instance, in `args.jobs` worker processes if given. The results found for every
+// instance are printed first, followed by those of each instance that only some instances have.
+// Returns an exit status for the process.
+int lint_instances(const Arguments &args);
+} // namespace LZN
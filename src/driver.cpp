@@ -0,0 +1,529 @@
+#include "driver.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iterator>
+#include <linter/census.hpp>
+#include <linter/file_utils.hpp>
+#include <linter/item_costs.hpp>
+#include <linter/perf_counters.hpp>
+#include <linter/registry.hpp>
+#include <linter/result_cache.hpp>
+#include <linter/result_formats.hpp>
+#include <linter/searcher.hpp>
+#include <linter/stdlib_subset.hpp>
+#include <linter/stdoutprinter.hpp>
+#include <linter/trace.hpp>
+#include <minizinc/file_utils.hh>
+#include <minizinc/parser.hh>
+#include <minizinc/typecheck.hh>
+#include <sstream>
+#include <system_error>
+
+namespace {
+using namespace LZN;
+
+// The names that `model` uses for the user files among `files`, which are canonical paths.
+std::vector<std::string> names_of(const MiniZinc::Model *model,
+                                  const std::vector<std::string> &includePaths,
+                                  const std::unordered_set<std::string> &files) {
+  std::unordered_set<std::string> seen;
+  std::vector<std::string> names;
+  const auto s =
+      SearchBuilder().only_user_defined(includePaths).recursive().in_everywhere().build();
+  auto ms = s.search(model);
+  while (ms.next()) {
+    const MiniZinc::ASTString filename = ms.cur_item()->loc().filename();
+    if (filename.size() == 0 || !seen.insert(filename.c_str()).second)
+      continue;
+    if (files.count(canonical_path(filename.c_str())) > 0)
+      names.emplace_back(filename.c_str());
+  }
+  return names;
+}
+
+// Prints `timings` of linting `model_filename` to `err`, as a table or as one line of JSON.
+void print_timings(const Timings &timings, const std::string &model_filename,
+                   const std::string &format, std::ostream &err) {
+  if (format == "json") {
+    Json j;
+    j.set("model", model_filename).set("timings", timings.to_json());
+    err << j.dump() << '\n';
+  } else {
+    err << "timings for " << model_filename << ":\n";
+    timings.print(err);
+  }
+}
+
+// Prints the work of the searches of each rule in `stats` of linting `model_filename` to `err`.
+void print_search_stats(const SearchStatsByRule &stats, const std::string &model_filename,
+                        std::ostream &err) {
+  const auto row = [&err](const std::string &name, auto... counts) {
+    err << std::left << std::setw(40) << name << std::right;
+    ((err << ' ' << std::setw(10) << counts), ...);
+    err << '\n';
+  };
+  err << "search stats for " << model_filename << ":\n";
+  row("rule", "searches", "expanded", "queued", "filtered", "matches", "backtracks", "skipped");
+  SearchStats total;
+  for (const auto &[rule, s] : stats) {
+    row(rule.empty() ? "(no rule)" : rule, s.searches, s.nodes_expanded, s.children_queued,
+        s.filter_calls, s.matches, s.backtracks, s.items_skipped);
+    total += s;
+  }
+  row("total", total.searches, total.nodes_expanded, total.children_queued, total.filter_calls,
+      total.matches, total.backtracks, total.items_skipped);
+}
+
+// Points at a copy of what `p` points at, made in `copy`, or nullptr if `p` is.
+template <typename T> T *copy_of(T *p, std::optional<T> &copy) {
+  return p == nullptr ? nullptr : &copy.emplace(*p);
+}
+
+// Replaces what `p` points at with the copy made by copy_of.
+template <typename T> void keep(T *p, std::optional<T> &copy) {
+  if (p != nullptr)
+    *p = std::move(*copy);
+}
+
+// Lints a model as lint_results does, with the data files `loaded` and the include path given.
+std::optional<std::vector<LintResult>>
+lint_loaded(const std::vector<const LintRule *> &rules, const std::string &model_filename,
+            const std::vector<std::string> &loaded, const std::vector<std::string> &includePaths,
+            std::ostream &err, const std::optional<std::string> &model_text, bool *typechecked,
+            const Focus &focus, const Monitor &monitor) {
+  MiniZinc::GCLock lock;
+  MiniZinc::Env env;
+  MiniZinc::Model *m = nullptr;
+  {
+    Timings::Scope scope(monitor.timings, Timings::Kind::PHASE, "parse");
+    m = parse_model(env, model_filename, loaded, includePaths, err, model_text);
+  }
+  if (m == nullptr)
+    return std::nullopt;
+
+  std::optional<ItemSet> changed_items;
+  if (focus.changed != nullptr)
+    changed_items = focus.changed->items(m, includePaths);
+  std::vector<std::string> skipped = loaded;
+  if (focus.skipped_files != nullptr) {
+    for (auto &name : names_of(m, includePaths, *focus.skipped_files))
+      skipped.push_back(std::move(name));
+  }
+
+  // With a focus, item-local rules only look at the focused items and the results of the other
+  // rules are filtered.
+  const bool focused = focus.changed != nullptr || focus.skipped_files != nullptr;
+  std::vector<std::vector<LintResult>> of_rule(rules.size());
+  auto stream = [&](std::size_t i) {
+    if (monitor.on_result) {
+      for (const auto &r : of_rule[i])
+        monitor.on_result(r);
+    }
+  };
+  auto run_rules = [&](Types types) {
+    LintEnv lenv(m, env, includePaths);
+    lenv.opaque_files(loaded.empty() ? nullptr : &loaded);
+    lenv.budget(monitor.budget);
+    lenv.timings(monitor.timings);
+    lenv.search_stats(monitor.search_stats);
+    lenv.item_costs(monitor.item_costs);
+    LintEnv item_env(m, env, includePaths);
+    item_env.opaque_files(skipped.empty() ? nullptr : &skipped);
+    item_env.budget(monitor.budget);
+    item_env.timings(monitor.timings);
+    item_env.search_stats(monitor.search_stats);
+    item_env.item_costs(monitor.item_costs);
+    if (changed_items)
+      item_env.only_items(&*changed_items);
+
+    for (std::size_t i = 0; i < rules.size(); ++i) {
+      if (rules[i]->types != types)
+        continue;
+      const bool item_local = focused && rules[i]->scope == Scope::ITEM;
+      LintEnv &e = item_local ? item_env : lenv;
+      const std::size_t before = e.results().size();
+      rules[i]->run(e);
+      const auto &all = e.results();
+      std::copy_if(all.begin() + before, all.end(), std::back_inserter(of_rule[i]),
+                   [&](const LintResult &r) {
+                     return focus.changed == nullptr || item_local || focus.changed->overlaps(r);
+                   });
+      if (types == Types::USED)
+        stream(i);
+    }
+  };
+
+  // Rules that don't use types run on the parsed model, before typechecking changes it.
+  run_rules(Types::UNUSED);
+
+  const bool uses_types = std::any_of(rules.begin(), rules.end(), [](const LintRule *rule) {
+    return rule->types == Types::USED;
+  });
+  bool ok = true;
+  if (uses_types) {
+    Timings::Scope scope(monitor.timings, Timings::Kind::PHASE, "typecheck");
+    ok = typecheck_model(env, m, err);
+  }
+  if (typechecked != nullptr)
+    *typechecked = ok;
+  else if (!ok)
+    return std::nullopt;
+  // Without types the model may still be loaded again with the whole standard library, so the
+  // results of the other rules are only final now. Callers that keep them anyway pass them on.
+  if (ok) {
+    for (std::size_t i = 0; i < rules.size(); ++i) {
+      if (rules[i]->types == Types::UNUSED)
+        stream(i);
+    }
+  }
+  if (ok && uses_types)
+    run_rules(Types::USED);
+
+  std::vector<LintResult> results;
+  for (auto &rs : of_rule)
+    results.insert(results.end(), std::make_move_iterator(rs.begin()),
+                   std::make_move_iterator(rs.end()));
+  return results;
+}
+} // namespace
+
+namespace LZN {
+std::vector<std::string> stdlib_include_paths() {
+  return {MiniZinc::FileUtils::file_path(MiniZinc::FileUtils::share_directory()) + "/std/"};
+}
+
+MiniZinc::Model *parse_model(MiniZinc::Env &env, const std::string &model_filename,
+                             const std::vector<std::string> &datafiles,
+                             const std::vector<std::string> &includePaths, std::ostream &err,
+                             const std::optional<std::string> &model_text) {
+  std::vector<std::string> filenames;
+  if (!model_text)
+    filenames.push_back(model_filename);
+  std::stringstream errstream;
+  MiniZinc::Model *m = MiniZinc::parse(env, filenames, datafiles, model_text.value_or(""),
+                                       model_text ? model_filename : "", includePaths, false,
+                                       false, false, false, errstream);
+
+  char empty_check;
+  if (errstream.readsome(&empty_check, 1) == 1) {
+    err << "parse errors:" << std::endl;
+    err << empty_check;
+    errstream >> err.rdbuf();
+  }
+  return m;
+}
+
+bool typecheck_model(MiniZinc::Env &env, MiniZinc::Model *m, std::ostream &err) {
+  std::vector<MiniZinc::TypeError> typeErrors;
+  try {
+    MiniZinc::typecheck(env, m, typeErrors, true, false);
+  } catch (MiniZinc::TypeError &te) {
+    typeErrors.push_back(te);
+  }
+  if (!typeErrors.empty()) {
+    err << "type errors:" << std::endl;
+    for (auto &te : typeErrors) {
+      err << te.loc() << ":" << std::endl;
+      err << te.what() << ": " << te.msg() << std::endl;
+    }
+    return false;
+  }
+  return true;
+}
+
+MiniZinc::Model *load_model(MiniZinc::Env &env, const std::string &model_filename,
+                            const std::vector<std::string> &datafiles,
+                            const std::vector<std::string> &includePaths, std::ostream &err,
+                            const std::optional<std::string> &model_text) {
+  MiniZinc::Model *m = parse_model(env, model_filename, datafiles, includePaths, err, model_text);
+  if (m == nullptr || !typecheck_model(env, m, err))
+    return nullptr;
+  return m;
+}
+
+std::vector<const LintRule *> enabled_rules(const Arguments &args) {
+  std::vector<const LintRule *> rules;
+  for (auto rule : Registry::iter()) {
+    if (!is_rule_ignored(args, *rule) && !(args.parse_only && rule->types == Types::USED))
+      rules.push_back(rule);
+  }
+  return rules;
+}
+
+std::vector<std::string> needed_datafiles(const std::vector<const LintRule *> &rules,
+                                          const std::vector<std::string> &datafiles) {
+  const bool used = std::any_of(rules.begin(), rules.end(),
+                                [](const LintRule *rule) { return rule->data == Data::USED; });
+  return used ? datafiles : std::vector<std::string>();
+}
+
+void run_rules(const Arguments &args, LintEnv &lenv) {
+  for (auto rule : enabled_rules(args))
+    rule->run(lenv);
+}
+
+std::optional<std::vector<LintResult>>
+lint_results(const Arguments &args, const std::string &model_filename,
+             const std::vector<std::string> &datafiles, std::ostream &err,
+             const std::optional<std::string> &model_text, IncrementalLinter *incremental,
+             bool *typechecked, const Monitor &monitor) {
+  const auto rules = enabled_rules(args);
+  if (incremental == nullptr) {
+    std::optional<ChangedLines> changed;
+    Focus focus;
+    if (args.changed_lines)
+      focus.changed = &changed.emplace(*args.changed_lines);
+    std::optional<Budget> own_budget;
+    Budget *budget = nullptr;
+    if (args.rule_timeout > 0 || args.max_results > 0) {
+      budget = monitor.budget != nullptr ? monitor.budget : &own_budget.emplace();
+      *budget = Budget();
+      if (args.rule_timeout > 0)
+        budget->rule_time = std::chrono::milliseconds(args.rule_timeout);
+      if (args.max_results > 0)
+        budget->max_results = args.max_results;
+    }
+    Monitor budgeted = monitor;
+    budgeted.budget = budget;
+    auto results = lint_results(rules, model_filename, datafiles, err, model_text, typechecked,
+                                focus, budgeted, args.cache_dir);
+    if (results && budget != nullptr) {
+      for (auto rule : budget->cut_short)
+        err << model_filename << ": rule " << rule->name
+            << " was stopped early by its budget, its results are incomplete\n";
+    }
+    return results;
+  }
+
+  MiniZinc::GCLock lock;
+  const std::vector<std::string> includePaths = stdlib_include_paths();
+  const std::vector<std::string> loaded = needed_datafiles(rules, datafiles);
+  MiniZinc::Env env;
+  MiniZinc::Model *m = parse_model(env, model_filename, loaded, includePaths, err, model_text);
+  if (m == nullptr)
+    return std::nullopt;
+  if (typecheck_model(env, m, err)) {
+    if (typechecked != nullptr)
+      *typechecked = true;
+    return incremental->lint(m, env, includePaths, rules);
+  }
+  if (typechecked == nullptr)
+    return std::nullopt;
+
+  // The incremental linter only keeps results of typechecked models.
+  *typechecked = false;
+  LintEnv lenv(m, env, includePaths);
+  lenv.opaque_files(loaded.empty() ? nullptr : &loaded);
+  for (auto rule : rules) {
+    if (rule->types == Types::UNUSED)
+      rule->run(lenv);
+  }
+  return lenv.take_results();
+}
+
+std::optional<std::vector<LintResult>>
+lint_results(const std::vector<const LintRule *> &rules, const std::string &model_filename,
+             const std::vector<std::string> &datafiles, std::ostream &err,
+             const std::optional<std::string> &model_text, bool *typechecked,
+             const Focus &focus, const Monitor &monitor, const std::string &cache_dir) {
+  const std::vector<std::string> loaded = needed_datafiles(rules, datafiles);
+  const std::vector<std::string> includePaths = stdlib_include_paths();
+  // Building the copies costs a scan of the whole standard library, which only pays off when the
+  // snapshot and the copies are kept for later runs.
+  if (!model_text && !cache_dir.empty()) {
+    std::vector<std::string> roots = {model_filename};
+    roots.insert(roots.end(), loaded.begin(), loaded.end());
+    std::vector<std::string> reduced;
+    try {
+      reduced = reduced_include_path(roots, includePaths, cache_dir);
+    } catch (const std::system_error &) {
+      // Let the parser report the file that can't be read.
+      reduced = includePaths;
+    }
+
+    // Anything that goes wrong with less of the standard library is reported from a full load,
+    // so that the errors are the usual ones.
+    if (reduced != includePaths) {
+      std::ostringstream reduced_err;
+      bool ok = false;
+      // The full load starts over with the budget as it was, and only the load whose results are
+      // kept is measured.
+      std::optional<Budget> budget;
+      std::optional<Timings> timings;
+      std::optional<SearchStatsByRule> search_stats;
+      std::optional<ItemCosts> item_costs;
+      Monitor attempt = monitor;
+      attempt.budget = copy_of(monitor.budget, budget);
+      attempt.timings = copy_of(monitor.timings, timings);
+      attempt.search_stats = copy_of(monitor.search_stats, search_stats);
+      attempt.item_costs = copy_of(monitor.item_costs, item_costs);
+      auto results = lint_loaded(rules, model_filename, loaded, reduced, reduced_err,
+                                 std::nullopt, &ok, focus, attempt);
+      if (results && ok) {
+        err << reduced_err.str();
+        if (typechecked != nullptr)
+          *typechecked = true;
+        keep(monitor.budget, budget);
+        keep(monitor.timings, timings);
+        keep(monitor.search_stats, search_stats);
+        keep(monitor.item_costs, item_costs);
+        return results;
+      }
+    }
+  }
+  auto results = lint_loaded(rules, model_filename, loaded, includePaths, err, model_text,
+                             typechecked, focus, monitor);
+  if (results && monitor.on_result && typechecked != nullptr && !*typechecked) {
+    for (const auto &r : *results)
+      monitor.on_result(r);
+  }
+  return results;
+}
+
+void print_results(const Arguments &args, const std::vector<LintResult> &results, std::ostream &out,
+                   CachedFileReader &reader, const std::vector<const LintRule *> &cut_short) {
+  CachedFileReader *snippets = args.snippets ? &reader : nullptr;
+  if (args.format == "json") {
+    json_print(results, out, snippets, cut_short);
+  } else if (args.format == "sarif") {
+    sarif_print(results, out, snippets, cut_short);
+  } else if (args.format == "ndjson") {
+    for (const auto &r : results)
+      ndjson_print(r, out, snippets);
+    for (const LintRule *rule : cut_short)
+      ndjson_print_cut_short(*rule, out);
+  } else {
+    stdout_print(results, out, reader);
+  }
+}
+
+int lint_model(const Arguments &args, const std::string &model_filename,
+               const std::vector<std::string> &datafiles, std::ostream &out, std::ostream &err,
+               const std::optional<std::string> &model_text) {
+  // Models from stdin are not cached, they are only linted by editors and servers. Neither are
+  // results for changed lines, which are only wanted once, or results within a budget, which may
+  // be incomplete. Measured runs lint, so that there is something to measure.
+  std::optional<ResultCache> cache;
+  std::uint64_t key = 0;
+  const bool budgeted = args.rule_timeout > 0 || args.max_results > 0;
+  if (!args.cache_dir.empty() && !model_text && !args.changed_lines && !budgeted &&
+      args.timings.empty() && args.trace.empty() && !args.search_stats && !args.mem_stats &&
+      !args.perf_counters && args.item_costs == 0) {
+    try {
+      cache.emplace(args.cache_dir);
+      key = cache->key(model_filename, datafiles, stdlib_include_paths(), enabled_rules(args));
+    } catch (const std::system_error &) {
+      // Let the parser report the file that can't be read.
+      cache.reset();
+    }
+  }
+
+  // A trace is made of the spans that are timed, and their memory and counters are measured with
+  // them.
+  std::optional<Timings> timings;
+  std::optional<Trace> trace;
+  std::optional<PerfCounters> counters;
+  if (!args.timings.empty() || !args.trace.empty() || args.mem_stats || args.perf_counters)
+    timings.emplace(args.mem_stats);
+  if (!args.trace.empty())
+    timings->trace(&trace.emplace());
+  if (args.perf_counters) {
+    counters.emplace();
+    if (!counters->unavailable_reason().empty())
+      err << "some hardware counters are not available: " << counters->unavailable_reason()
+          << '\n';
+    if (counters->any_available())
+      timings->counters(&*counters);
+  }
+  std::optional<SearchStatsByRule> search_stats;
+  if (args.search_stats)
+    search_stats.emplace();
+  std::optional<ItemCosts> item_costs;
+  if (args.item_costs > 0)
+    item_costs.emplace();
+  CachedFileReader reader;
+  if (model_text)
+    reader.add(model_filename, *model_text);
+  // Filled in by lint_results if `args` set a budget.
+  Budget budget;
+  Monitor monitor;
+  monitor.budget = &budget;
+  monitor.timings = timings ? &*timings : nullptr;
+  monitor.search_stats = search_stats ? &*search_stats : nullptr;
+  monitor.item_costs = item_costs ? &*item_costs : nullptr;
+  if (args.format == "ndjson") {
+    monitor.on_result = [&](const LintResult &r) {
+      ndjson_print(r, out, args.snippets ? &reader : nullptr);
+    };
+  }
+
+  std::optional<std::vector<LintResult>> results;
+  bool typechecked = true;
+  bool streamed = false;
+  if (cache)
+    results = cache->load(key);
+  if (!results) {
+    results = lint_results(args, model_filename, datafiles, err, model_text, nullptr, &typechecked,
+                           monitor);
+    if (!results)
+      return EXIT_FAILURE;
+    streamed = static_cast<bool>(monitor.on_result);
+    // Without types some rules didn't run, so the results are incomplete.
+    if (cache && typechecked)
+      cache->store(key, *results);
+  }
+
+  if (!streamed) {
+    Timings::Scope scope(timings ? &*timings : nullptr, Timings::Kind::PHASE, "print");
+    print_results(args, *results, out, reader, budget.cut_short);
+  } else {
+    for (const LintRule *rule : budget.cut_short)
+      ndjson_print_cut_short(*rule, out);
+  }
+  if (!args.timings.empty())
+    print_timings(*timings, model_filename, args.timings, err);
+  if (args.mem_stats && args.timings != "json") {
+    err << "memory for " << model_filename << ":\n";
+    timings->print_memory(err);
+  }
+  if (counters && counters->any_available() && args.timings != "json") {
+    err << "hardware counters for " << model_filename << ":\n";
+    timings->print_counters(err);
+  }
+  if (trace && !write_file_atomically(args.trace, trace->to_json().dump())) {
+    err << "couldn't write the trace to " << args.trace << '\n';
+    return EXIT_FAILURE;
+  }
+  if (search_stats)
+    print_search_stats(*search_stats, model_filename, err);
+  if (item_costs) {
+    err << "most expensive items of " << model_filename << ":\n";
+    item_costs->print(err, args.item_costs);
+  }
+
+  return typechecked ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int print_census(const Arguments &args, const std::string &model_filename,
+                 const std::vector<std::string> &datafiles, std::ostream &out, std::ostream &err,
+                 const std::optional<std::string> &model_text) {
+  MiniZinc::GCLock lock;
+  MiniZinc::Env env;
+  const std::vector<std::string> includePaths = stdlib_include_paths();
+  MiniZinc::Model *model =
+      parse_model(env, model_filename, datafiles, includePaths, err, model_text);
+  if (model == nullptr)
+    return EXIT_FAILURE;
+
+  const Census census = take_census(model, includePaths);
+  if (args.stats == "json") {
+    Json j;
+    j.set("model", model_filename).set("stats", census.to_json());
+    out << j.dump() << '\n';
+  } else {
+    out << "stats for " << model_filename << ":\n";
+    census.print(out);
+  }
+  return EXIT_SUCCESS;
+}
+} // namespace LZN
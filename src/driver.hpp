@@ -0,0 +1,115 @@
+#pragma once
+
+#include "argparse.hpp"
+#include <functional>
+#include <linter/changed_lines.hpp>
+#include <linter/file_utils.hpp>
+#include <linter/incremental.hpp>
+#include <linter/rules.hpp>
+#include <minizinc/model.hh>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace LZN {
+// The include path to the standard library that lives next to the executable.
+std::vector<std::string> stdlib_include_paths();
+
+// The name given to a model that is read from stdin, i.e. given as "-".
+constexpr const char *STDIN_MODEL_NAME = "stdin";
+
+// Parse a model together with its data files. Errors are printed to `err`. Returns nullptr if the
+// model couldn't be parsed. If `model_text` is given it is parsed instead of the file and
+// `model_filename` is only used as its name.
+MiniZinc::Model *parse_model(MiniZinc::Env &env, const std::string &model_filename,
+                             const std::vector<std::string> &datafiles,
+                             const std::vector<std::string> &includePaths, std::ostream &err,
+                             const std::optional<std::string> &model_text = std::nullopt);
+
+// Typecheck a parsed model. Type errors are printed to `err`. Returns false if there were any.
+bool typecheck_model(MiniZinc::Env &env, MiniZinc::Model *m, std::ostream &err);
+
+// Parse and typecheck a model together with its data files, as for parse_model. Returns nullptr if
+// the model couldn't be parsed or typechecked.
+MiniZinc::Model *load_model(MiniZinc::Env &env, const std::string &model_filename,
+                            const std::vector<std::string> &datafiles,
+                            const std::vector<std::string> &includePaths, std::ostream &err,
+                            const std::optional<std::string> &model_text = std::nullopt);
+
+// What lint_results looks at, by default the whole model.
+struct Focus {
+  // Only the results that overlap these lines are kept, item-local rules only look at the items
+  // there.
+  const ChangedLines *changed = nullptr;
+  // The canonical paths of files whose items item-local rules skip, e.g. since they were linted
+  // already. Other rules still look at them.
+  const std::unordered_set<std::string> *skipped_files = nullptr;
+};
+
+// What watches over the rules of lint_results, nothing by default.
+struct Monitor {
+  // the limits of each rule, which records the rules stopped early; lint_results with `args`
+  // replaces its limits by the ones of `args`, if any
+  Budget *budget = nullptr;
+  Timings *timings = nullptr; // where the time of parsing, typechecking and each rule is added
+  // where the work of the searches of each rule is added
+  SearchStatsByRule *search_stats = nullptr;
+  // where the time spent in each top-level item is added
+  ItemCosts *item_costs = nullptr;
+  // called with each result that is kept as soon as it is final, i.e. after its rule finished and
+  // the model typechecked, in no particular order
+  std::function<void(const LintResult &)> on_result;
+};
+
+// Every rule that isn't ignored by `args`. With `parse_only`, rules that use types are ignored too.
+std::vector<const LintRule *> enabled_rules(const Arguments &args);
+
+// The data files that must be loaded to run `rules`, which are none unless one of them uses data.
+std::vector<std::string> needed_datafiles(const std::vector<const LintRule *> &rules,
+                                          const std::vector<std::string> &datafiles);
+
+// Run every rule that isn't ignored by `args`.
+void run_rules(const Arguments &args, LintEnv &lenv);
+
+// Lint one model with the rules of `args` and return the results, or std::nullopt if it couldn't
+// be loaded. Errors are printed to `err`. An `incremental` linter reuses the results of an earlier
+// version of the model, otherwise the run is watched over by `monitor`. If `typechecked` is given,
+// a model that doesn't typecheck isn't an error and `*typechecked` is set to false.
+std::optional<std::vector<LintResult>>
+lint_results(const Arguments &args, const std::string &model_filename,
+             const std::vector<std::string> &datafiles, std::ostream &err,
+             const std::optional<std::string> &model_text = std::nullopt,
+             IncrementalLinter *incremental = nullptr, bool *typechecked = nullptr,
+             const Monitor &monitor = Monitor());
+
+// Lint what is in `focus` of one model with `rules` only, as above. Rules that don't use types run
+// before the model is typechecked. With a `cache_dir`, the model is loaded with only the parts of
+// the standard library it needs, see reduced_include_path.
+std::optional<std::vector<LintResult>>
+lint_results(const std::vector<const LintRule *> &rules, const std::string &model_filename,
+             const std::vector<std::string> &datafiles, std::ostream &err,
+             const std::optional<std::string> &model_text = std::nullopt,
+             bool *typechecked = nullptr, const Focus &focus = Focus(),
+             const Monitor &monitor = Monitor(), const std::string &cache_dir = "");
+
+// Print `results` to `out` in the format of `args`, reading source lines through `reader`. The
+// machine-readable formats also list the rules in `cut_short`, which were stopped early by their
+// budget.
+void print_results(const Arguments &args, const std::vector<LintResult> &results, std::ostream &out,
+                   CachedFileReader &reader, const std::vector<const LintRule *> &cut_short = {});
+
+// Lint one model and print the results to `out` in the format of `args`. Errors and the
+// measurements that `args` asks for are printed to `err`. Returns an exit status for the process.
+int lint_model(const Arguments &args, const std::string &model_filename,
+               const std::vector<std::string> &datafiles, std::ostream &out, std::ostream &err,
+               const std::optional<std::string> &model_text = std::nullopt);
+
+// Parse one model and print its census to `out` in the `stats` format of `args`, without linting
+// or typechecking it. Errors are printed to `err`. Returns an exit status for the process. The
+// model is read from `model_text` if given, as for load_model.
+int print_census(const Arguments &args, const std::string &model_filename,
+                 const std::vector<std::string> &datafiles, std::ostream &out, std::ostream &err,
+                 const std::optional<std::string> &model_text = std::nullopt);
+} // namespace LZN
@@ -0,0 +1,73 @@
+#include "gitdiff.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+// Runs `argv` and returns its output, or std::nullopt if it couldn't be run or failed. Its errors
+// go to the stderr of this process.
+std::optional<std::string> run(const std::vector<std::string> &argv) {
+  int fds[2];
+  if (::pipe(fds) != 0)
+    return std::nullopt;
+
+  const pid_t pid = ::fork();
+  if (pid < 0) {
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return std::nullopt;
+  }
+  if (pid == 0) {
+    ::dup2(fds[1], STDOUT_FILENO);
+    ::close(fds[0]);
+    ::close(fds[1]);
+    std::vector<char *> args;
+    for (const auto &arg : argv)
+      args.push_back(const_cast<char *>(arg.c_str()));
+    args.push_back(nullptr);
+    ::execvp(args[0], args.data());
+    std::perror(args[0]);
+    ::_exit(127);
+  }
+
+  ::close(fds[1]);
+  std::string out;
+  char buf[4096];
+  while (true) {
+    const ssize_t n = ::read(fds[0], buf, sizeof(buf));
+    if (n > 0)
+      out.append(buf, static_cast<std::size_t>(n));
+    else if (n == 0 || errno != EINTR)
+      break;
+  }
+  ::close(fds[0]);
+
+  int status = 0;
+  while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    return std::nullopt;
+  return out;
+}
+} // namespace
+
+namespace LZN {
+std::optional<std::vector<LineRange>> git_changed_lines(const std::string &rev, std::ostream &err) {
+  auto root = run({"git", "rev-parse", "--show-toplevel"});
+  if (!root) {
+    err << "couldn't find the git repository of the current directory" << std::endl;
+    return std::nullopt;
+  }
+  while (!root->empty() && (root->back() == '\n' || root->back() == '\r'))
+    root->pop_back();
+
+  // The prefixes are given since they can be configured away.
+  const auto diff = run({"git", "-c", "core.quotepath=off", "diff", "--no-color", "--no-ext-diff",
+                         "--unified=0", "--src-prefix=a/", "--dst-prefix=b/", rev, "--"});
+  if (!diff) {
+    err << "couldn't get the changes since '" << rev << "' from git" << std::endl;
+    return std::nullopt;
+  }
+  return parse_unified_diff(*diff, *root);
+}
+} // namespace LZN
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <linter/changed_lines.hpp>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace LZN {
+// The lines that changed in the working tree of the git repository around the current directory
+// since the revision `rev`, as given by `git diff`. Files that aren't tracked are left out. Errors
+// are printed to `err`, returns std::nullopt if git failed.
+std::optional<std::vector<LineRange>> git_changed_lines(const std::string &rev, std::ostream &err);
+} // namespace LZN
@@ -0,0 +1,141 @@
+#include "ipc.hpp"
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace LZN {
+bool write_full(int fd, const void *data, std::size_t size) noexcept {
+  const char *p = static_cast<const char *>(data);
+  while (size > 0) {
+    const ssize_t n = ::write(fd, p, size);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    p += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+bool read_full(int fd, void *data, std::size_t size) noexcept {
+  char *p = static_cast<char *>(data);
+  while (size > 0) {
+    const ssize_t n = ::read(fd, p, size);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    if (n == 0)
+      return false;
+    p += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+bool write_message(int fd, char tag, std::string_view payload) noexcept {
+  std::string frame;
+  try {
+    frame.reserve(1 + sizeof(std::uint32_t) + payload.size());
+    frame.push_back(tag);
+    put_string(frame, payload);
+  } catch (const std::bad_alloc &) {
+    return false;
+  }
+  return write_full(fd, frame.data(), frame.size());
+}
+
+bool read_message(int fd, Message &msg, std::uint32_t max_size) {
+  std::uint32_t size;
+  if (!read_full(fd, &msg.tag, 1) || !read_full(fd, &size, sizeof(size)) || size > max_size)
+    return false;
+  msg.payload.resize(size);
+  return read_full(fd, msg.payload.data(), size);
+}
+
+MessageStreamBuf::MessageStreamBuf(int fd, char tag) : fd(fd), tag(tag) {
+  setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+MessageStreamBuf::~MessageStreamBuf() {
+  sync();
+}
+
+MessageStreamBuf::int_type MessageStreamBuf::overflow(int_type ch) {
+  if (sync() != 0)
+    return traits_type::eof();
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+int MessageStreamBuf::sync() {
+  const std::size_t size = static_cast<std::size_t>(pptr() - pbase());
+  if (size == 0)
+    return 0;
+  const bool ok = write_message(fd, tag, std::string_view(pbase(), size));
+  setp(buffer.data(), buffer.data() + buffer.size());
+  return ok ? 0 : -1;
+}
+
+namespace {
+bool make_address(const std::string &path, sockaddr_un &addr) {
+  addr = {};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    errno = ENAMETOOLONG;
+    return false;
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+} // namespace
+
+int listen_unix(const std::string &path) {
+  sockaddr_un addr;
+  if (!make_address(path, addr))
+    return -1;
+
+  struct stat st;
+  if (::stat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    ::unlink(path.c_str());
+
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+  if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+      ::listen(fd, SOMAXCONN) != 0) {
+    const int err = errno;
+    ::close(fd);
+    errno = err;
+    return -1;
+  }
+  return fd;
+}
+
+int connect_unix(const std::string &path) {
+  sockaddr_un addr;
+  if (!make_address(path, addr))
+    return -1;
+
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+    const int err = errno;
+    ::close(fd);
+    errno = err;
+    return -1;
+  }
+  return fd;
+}
+} // namespace LZN
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <linter/binary_io.hpp>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace LZN {
+// Write all of `data` to `fd`, retrying on partial writes and EINTR. Returns false on failure.
+bool write_full(int fd, const void *data, std::size_t size) noexcept;
+
+// Read exactly `size` bytes from `fd`. Returns false on failure or if end-of-file is reached
+// first.
+bool read_full(int fd, void *data, std::size_t size) noexcept;
+
+// Messages sent between processes. A message is a one byte tag followed by a length-prefixed
+// payload.
+struct Message {
+  char tag = '\0';
+  std::string payload;
+};
+
+bool write_message(int fd, char tag, std::string_view payload) noexcept;
+// Returns false on failure, also for a payload larger than `max_size`, which is then left unread.
+bool read_message(int fd, Message &msg, std::uint32_t max_size = UINT32_MAX);
+
+// A stream buffer that sends everything written to it as messages with tag `tag` on `fd`.
+class MessageStreamBuf : public std::streambuf {
+  int fd;
+  char tag;
+  std::array<char, 4096> buffer;
+
+public:
+  MessageStreamBuf(int fd, char tag);
+  ~MessageStreamBuf() override;
+
+protected:
+  int_type overflow(int_type ch) override;
+  int sync() override;
+};
+
+// Create a Unix domain socket listening on `path`, a stale socket file is replaced. Returns -1 on
+// failure with errno set.
+int listen_unix(const std::string &path);
+
+// Connect to the Unix domain socket at `path`. Returns -1 on failure with errno set.
+int connect_unix(const std::string &path);
+} // namespace LZN
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace LZN {
+// Helpers to put integers and strings into a byte buffer and take them out again, in host byte
+// order. The `take_` functions throw std::out_of_range if the buffer is too short.
+inline void put_u32(std::string &out, std::uint32_t v) {
+  out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+inline void put_u64(std::string &out, std::uint64_t v) {
+  out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+inline void put_string(std::string &out, std::string_view s) {
+  put_u32(out, static_cast<std::uint32_t>(s.size()));
+  out.append(s);
+}
+
+template <typename T>
+T take_integer(std::string_view &in) {
+  T v;
+  if (in.size() < sizeof(v))
+    throw std::out_of_range("input too short");
+  std::memcpy(&v, in.data(), sizeof(v));
+  in.remove_prefix(sizeof(v));
+  return v;
+}
+
+inline std::uint32_t take_u32(std::string_view &in) {
+  return take_integer<std::uint32_t>(in);
+}
+
+inline std::uint64_t take_u64(std::string_view &in) {
+  return take_integer<std::uint64_t>(in);
+}
+
+inline std::string take_string(std::string_view &in) {
+  const std::uint32_t size = take_u32(in);
+  if (in.size() < size)
+    throw std::out_of_range("input too short");
+  std::string s(in.substr(0, size));
+  in.remove_prefix(size);
+  return s;
+}
+} // namespace LZN
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace LZN {
+// Lets long-running work stop early, cooperatively: whoever does the work polls `cancelled()`
+// and winds down once it returns true. It is cancelled explicitly or when a deadline passes.
+class CancellationToken {
+  using Clock = std::chrono::steady_clock;
+
+  // Reading the clock costs more than a step of a search, so it is only read every so often.
+  static constexpr std::uint32_t POLLS_PER_CLOCK_READ = 1024;
+
+  std::optional<Clock::time_point> _deadline;
+  bool _cancelled = false;
+  std::uint32_t _polls = 0;
+
+public:
+  // Start over, cancelling once `timeout` has passed from now, or never without one.
+  void reset(std::optional<std::chrono::milliseconds> timeout) noexcept {
+    _deadline.reset();
+    if (timeout)
+      _deadline = Clock::now() + *timeout;
+    _cancelled = false;
+    _polls = 0;
+  }
+
+  void cancel() noexcept { _cancelled = true; }
+
+  // Returns true if the work should stop. Only this call notices that the deadline passed.
+  bool cancelled() noexcept {
+    if (!_cancelled && _deadline && ++_polls % POLLS_PER_CLOCK_READ == 0)
+      _cancelled = Clock::now() >= *_deadline;
+    return _cancelled;
+  }
+
+  // Returns true if the token was cancelled, without looking at the clock.
+  bool was_cancelled() const noexcept { return _cancelled; }
+};
+} // namespace LZN
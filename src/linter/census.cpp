@@ -0,0 +1,247 @@
+#include "census.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <linter/file_utils.hpp>
+#include <linter/searcher.hpp>
+#include <minizinc/astiterator.hh>
+#include <optional>
+
+namespace {
+using namespace LZN;
+
+const char *item_kind(const MiniZinc::Item *item) {
+  using I = MiniZinc::Item;
+  switch (item->iid()) {
+  case I::II_INC: return "include";
+  case I::II_VD: return "declaration";
+  case I::II_ASN: return "assignment";
+  case I::II_CON: return "constraint";
+  case I::II_SOL: return "solve";
+  case I::II_OUT: return "output";
+  case I::II_FUN: return "function";
+  default: return "other";
+  }
+}
+
+const char *expression_kind(const MiniZinc::Expression *e) {
+  using E = MiniZinc::Expression;
+  switch (e->eid()) {
+  case E::E_INTLIT: return "int literal";
+  case E::E_FLOATLIT: return "float literal";
+  case E::E_SETLIT: return "set literal";
+  case E::E_BOOLLIT: return "bool literal";
+  case E::E_STRINGLIT: return "string literal";
+  case E::E_ID: return "identifier";
+  case E::E_ANON: return "anonymous variable";
+  case E::E_ARRAYLIT: return "array literal";
+  case E::E_ARRAYACCESS: return "array access";
+  case E::E_COMP: return "comprehension";
+  case E::E_ITE: return "if-then-else";
+  case E::E_BINOP: return "binary operation";
+  case E::E_UNOP: return "unary operation";
+  case E::E_CALL: return "call";
+  case E::E_VARDECL: return "declaration";
+  case E::E_LET: return "let";
+  case E::E_TI: return "type-inst";
+  case E::E_TIID: return "type-inst variable";
+  default: return "other";
+  }
+}
+
+// The number of elements of `ti` if it is an array whose index sets are all literal ranges.
+std::optional<std::uint64_t> literal_size(const MiniZinc::TypeInst *ti) {
+  if (ti == nullptr || !ti->isarray())
+    return std::nullopt;
+  std::uint64_t size = 1;
+  for (const MiniZinc::TypeInst *range : ti->ranges()) {
+    auto dots = range->domain() != nullptr ? range->domain()->dynamicCast<MiniZinc::BinOp>()
+                                           : nullptr;
+    if (dots == nullptr || dots->op() != MiniZinc::BOT_DOTDOT)
+      return std::nullopt;
+    auto lb = dots->lhs()->dynamicCast<MiniZinc::IntLit>();
+    auto ub = dots->rhs()->dynamicCast<MiniZinc::IntLit>();
+    if (lb == nullptr || ub == nullptr)
+      return std::nullopt;
+    const long long n = ub->v().toInt() - lb->v().toInt() + 1;
+    size *= n > 0 ? static_cast<std::uint64_t>(n) : 0;
+  }
+  return size;
+}
+
+// Counts every expression below `root` into `census`.
+void count(const MiniZinc::Expression *root, Census &census) {
+  if (root == nullptr)
+    return;
+
+  struct : MiniZinc::EVisitor {
+    Census *census;
+    std::uint64_t depth = 0;
+
+    bool enter(MiniZinc::Expression *e) {
+      ++depth;
+      census->max_depth = std::max(census->max_depth, depth);
+      census->total_depth += depth;
+      ++census->expressions[expression_kind(e)];
+      if (auto bo = e->dynamicCast<MiniZinc::BinOp>()) {
+        ++census->operators[bo->opToString().c_str()];
+      } else if (auto uo = e->dynamicCast<MiniZinc::UnOp>()) {
+        ++census->operators[std::string("unary ") + uo->opToString().c_str()];
+      } else if (auto comp = e->dynamicCast<MiniZinc::Comprehension>()) {
+        ++census->comprehensions;
+        census->generators += comp->numberOfGenerators();
+      } else if (auto al = e->dynamicCast<MiniZinc::ArrayLit>()) {
+        ++census->literal_arrays;
+        census->literal_array_elements += al->size();
+        census->largest_literal_array =
+            std::max<std::uint64_t>(census->largest_literal_array, al->size());
+      }
+      return true;
+    }
+    void exit(MiniZinc::Expression *) { --depth; }
+  } counter;
+  counter.census = &census;
+
+  // NOTE: Assume that top_down doesn't modify root
+  MiniZinc::top_down(counter, const_cast<MiniZinc::Expression *>(root));
+}
+
+void count(const MiniZinc::Annotation &ann, Census &census) {
+  for (const MiniZinc::Expression *e : ann)
+    count(e, census);
+}
+
+void count(const MiniZinc::Item *item, Census &census) {
+  using I = MiniZinc::Item;
+  switch (item->iid()) {
+  case I::II_VD: {
+    const MiniZinc::VarDecl *vd = item->cast<MiniZinc::VarDeclI>()->e();
+    ++(vd->ti()->type().isvar() ? census.var_decls : census.par_decls);
+    if (const auto size = literal_size(vd->ti())) {
+      ++census.sized_arrays;
+      census.sized_array_elements += *size;
+      census.largest_sized_array = std::max(census.largest_sized_array, *size);
+    }
+    count(vd, census);
+    break;
+  }
+  case I::II_ASN: count(item->cast<MiniZinc::AssignI>()->e(), census); break;
+  case I::II_CON: count(item->cast<MiniZinc::ConstraintI>()->e(), census); break;
+  case I::II_SOL: {
+    auto si = item->cast<MiniZinc::SolveI>();
+    count(si->e(), census);
+    count(si->ann(), census);
+    break;
+  }
+  case I::II_OUT: count(item->cast<MiniZinc::OutputI>()->e(), census); break;
+  case I::II_FUN: {
+    auto fi = item->cast<MiniZinc::FunctionI>();
+    count(fi->ti(), census);
+    for (const MiniZinc::VarDecl *param : fi->params())
+      count(param, census);
+    count(fi->e(), census);
+    count(fi->ann(), census);
+    break;
+  }
+  default: break;
+  }
+}
+
+// Prints `name` and `value` as a line of the report, indented by `indent`.
+template <typename T>
+void line(std::ostream &os, int indent, const std::string &name, const T &value) {
+  os << std::string(indent, ' ') << std::left << std::setw(32 - indent) << name << std::right
+     << std::setw(12) << value << '\n';
+}
+
+Json to_object(const std::map<std::string, std::uint64_t> &counts) {
+  Json j = Json::Object();
+  for (const auto &[name, n] : counts)
+    j.set(name, n);
+  return j;
+}
+} // namespace
+
+namespace LZN {
+std::uint64_t Census::expression_count() const noexcept {
+  std::uint64_t n = 0;
+  for (const auto &e : expressions)
+    n += e.second;
+  return n;
+}
+
+double Census::average_depth() const noexcept {
+  const std::uint64_t n = expression_count();
+  return n > 0 ? static_cast<double>(total_depth) / static_cast<double>(n) : 0;
+}
+
+void Census::print(std::ostream &os) const {
+  const auto flags = os.flags();
+  os << std::fixed << std::setprecision(2);
+  line(os, 0, "items", user_items + stdlib_items);
+  line(os, 2, "user", user_items);
+  line(os, 2, "standard library", stdlib_items);
+  os << "user items by kind:\n";
+  for (const auto &[kind, n] : items)
+    line(os, 2, kind, n);
+  line(os, 0, "var declarations", var_decls);
+  line(os, 0, "par declarations", par_decls);
+  line(os, 0, "expressions", expression_count());
+  for (const auto &[kind, n] : expressions)
+    line(os, 2, kind, n);
+  os << "operators:\n";
+  for (const auto &[op, n] : operators)
+    line(os, 2, op, n);
+  line(os, 0, "maximum depth", max_depth);
+  line(os, 0, "average depth", average_depth());
+  line(os, 0, "comprehensions", comprehensions);
+  line(os, 0, "generators", generators);
+  line(os, 0, "array literals", literal_arrays);
+  line(os, 2, "elements", literal_array_elements);
+  line(os, 2, "largest", largest_literal_array);
+  line(os, 0, "arrays of literal size", sized_arrays);
+  line(os, 2, "elements", sized_array_elements);
+  line(os, 2, "largest", largest_sized_array);
+  os.flags(flags);
+}
+
+Json Census::to_json() const {
+  Json j;
+  j.set("user_items", user_items)
+      .set("stdlib_items", stdlib_items)
+      .set("items", to_object(items))
+      .set("var_declarations", var_decls)
+      .set("par_declarations", par_decls)
+      .set("expressions", to_object(expressions))
+      .set("operators", to_object(operators))
+      .set("max_depth", max_depth)
+      .set("average_depth", average_depth())
+      .set("comprehensions", comprehensions)
+      .set("generators", generators)
+      .set("array_literals", literal_arrays)
+      .set("array_literal_elements", literal_array_elements)
+      .set("largest_array_literal", largest_literal_array)
+      .set("sized_arrays", sized_arrays)
+      .set("sized_array_elements", sized_array_elements)
+      .set("largest_sized_array", largest_sized_array);
+  return j;
+}
+
+Census take_census(const MiniZinc::Model *model, const std::vector<std::string> &includePath) {
+  Census census;
+  // Every item, the standard library included, to count both.
+  const auto s = SearchBuilder().recursive().in_everywhere().build();
+  auto ms = s.search(model);
+  while (ms.next()) {
+    const MiniZinc::Item *item = ms.cur_item();
+    const MiniZinc::ASTString filename = item->loc().filename();
+    if (filename.size() == 0 || path_included_from(includePath, filename)) {
+      ++census.stdlib_items;
+      continue;
+    }
+    ++census.user_items;
+    ++census.items[item_kind(item)];
+    count(item, census);
+  }
+  return census;
+}
+} // namespace LZN
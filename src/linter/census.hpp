@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <linter/json.hpp>
+#include <map>
+#include <minizinc/model.hh>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace LZN {
+// Basic statistics about a model, for `--stats`, to size the cost of linting and flattening it.
+// Everything but the split of the items is only counted for the user files.
+struct Census {
+  std::uint64_t user_items = 0;
+  std::uint64_t stdlib_items = 0; // of the standard library or introduced by MiniZinc
+  std::map<std::string, std::uint64_t> items;       // by kind
+  std::map<std::string, std::uint64_t> expressions; // by kind
+  std::map<std::string, std::uint64_t> operators;   // of binary and unary operations
+  std::uint64_t max_depth = 0;   // of the expressions of a single item
+  std::uint64_t total_depth = 0; // of every expression, for the average
+  std::uint64_t comprehensions = 0;
+  std::uint64_t generators = 0;
+  std::uint64_t var_decls = 0; // top-level declarations of variables
+  std::uint64_t par_decls = 0; // top-level declarations of parameters
+  // Array literals and top-level arrays whose index sets are literal ranges, by their number of
+  // elements.
+  std::uint64_t literal_arrays = 0;
+  std::uint64_t literal_array_elements = 0;
+  std::uint64_t largest_literal_array = 0;
+  std::uint64_t sized_arrays = 0;
+  std::uint64_t sized_array_elements = 0;
+  std::uint64_t largest_sized_array = 0;
+
+  std::uint64_t expression_count() const noexcept;
+  double average_depth() const noexcept;
+
+  // Prints a report with a line for each number.
+  void print(std::ostream &os) const;
+  Json to_json() const;
+};
+
+// Takes the census of `model` in one traversal. Files below `includePath` are the standard
+// library.
+Census take_census(const MiniZinc::Model *model, const std::vector<std::string> &includePath);
+} // namespace LZN
@@ -0,0 +1,117 @@
+#include "changed_lines.hpp"
+#include <algorithm>
+#include <limits>
+#include <linter/file_utils.hpp>
+#include <linter/incremental.hpp>
+#include <linter/overload.hpp>
+#include <linter/searcher.hpp>
+#include <utility>
+
+namespace {
+bool starts_with(std::string_view s, std::string_view prefix) {
+  return s.substr(0, prefix.size()) == prefix;
+}
+
+// Reads an unsigned number at the start of `s` and removes it from `s`.
+unsigned int take_number(std::string_view &s) {
+  unsigned int n = 0;
+  std::size_t i = 0;
+  for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i)
+    n = n * 10 + static_cast<unsigned int>(s[i] - '0');
+  s.remove_prefix(i);
+  return n;
+}
+} // namespace
+
+namespace LZN {
+std::vector<LineRange> parse_unified_diff(std::string_view diff, const std::string &root) {
+  std::vector<LineRange> ranges;
+  std::string file; // of the current hunks, empty if the file was deleted
+  std::string_view previous;
+  while (!diff.empty()) {
+    const std::size_t eol = std::min(diff.find('\n'), diff.size());
+    std::string_view line = diff.substr(0, eol);
+    diff.remove_prefix(std::min(eol + 1, diff.size()));
+    const std::string_view before = std::exchange(previous, line);
+
+    // An added line that starts with "++ " looks the same, but doesn't follow a "--- " line.
+    if (starts_with(line, "+++ ") && starts_with(before, "--- ")) {
+      line.remove_prefix(4);
+      // Names with spaces may be followed by a tab.
+      line = line.substr(0, line.find('\t'));
+      if (line == "/dev/null")
+        file.clear();
+      else
+        file = root + "/" + std::string(starts_with(line, "b/") ? line.substr(2) : line);
+    } else if (starts_with(line, "@@ ") && !file.empty()) {
+      // @@ -start[,count] +start[,count] @@
+      const std::size_t plus = line.find(" +");
+      if (plus == std::string_view::npos)
+        continue;
+      std::string_view spec = line.substr(plus + 2);
+      const unsigned int start = take_number(spec);
+      unsigned int count = 1;
+      if (starts_with(spec, ",")) {
+        spec.remove_prefix(1);
+        count = take_number(spec);
+      }
+      const unsigned int first = std::max(start, 1U);
+      ranges.push_back({file, first, count == 0 ? first : start + count - 1});
+    }
+  }
+  return ranges;
+}
+
+ChangedLines::ChangedLines(const std::vector<LineRange> &ranges) {
+  for (const auto &r : ranges)
+    _ranges[canonical(r.file)].emplace_back(r.first, r.last);
+}
+
+const std::string &ChangedLines::canonical(const std::string &file) const {
+  auto it = _canonical.find(file);
+  if (it == _canonical.end())
+    it = _canonical.emplace(file, canonical_path(file)).first;
+  return it->second;
+}
+
+bool ChangedLines::overlaps(const std::string &file, unsigned int first, unsigned int last) const {
+  const auto it = _ranges.find(canonical(file));
+  if (it == _ranges.end())
+    return false;
+  return std::any_of(it->second.begin(), it->second.end(), [first, last](const auto &r) {
+    return r.first <= last && first <= r.second;
+  });
+}
+
+bool ChangedLines::overlaps(const LintResult &r) const {
+  if (r.content.filename.empty())
+    return false;
+  return std::visit(
+      overload{
+          [&](const std::monostate &) {
+            return overlaps(r.content.filename, 1, std::numeric_limits<unsigned int>::max());
+          },
+          [&](const FileContents::OneLineMarked &olm) {
+            return overlaps(r.content.filename, olm.line, olm.line);
+          },
+          [&](const FileContents::MultiLine &ml) {
+            return overlaps(r.content.filename, ml.startline, ml.endline);
+          },
+      },
+      r.content.region);
+}
+
+ItemSet ChangedLines::items(const MiniZinc::Model *model,
+                            const std::vector<std::string> &includePath) const {
+  ItemSet items;
+  const auto s = SearchBuilder().only_user_defined(includePath).recursive().in_everywhere().build();
+  auto ms = s.search(model);
+  while (ms.next()) {
+    const MiniZinc::Item *item = ms.cur_item();
+    const ItemFingerprint fp = fingerprint(item);
+    if (!fp.filename.empty() && overlaps(fp.filename, fp.first_line, fp.last_line))
+      items.insert(item);
+  }
+  return items;
+}
+} // namespace LZN
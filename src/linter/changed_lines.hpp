@@ -0,0 +1,45 @@
+#pragma once
+
+#include <linter/rules.hpp>
+#include <minizinc/model.hh>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace LZN {
+// The lines `first` to `last` of `file`, both inclusive and 1-based.
+struct LineRange {
+  std::string file;
+  unsigned int first;
+  unsigned int last;
+};
+
+// The lines that `diff`, in the unified format of `git diff --unified=0`, adds or changes in the
+// new version of each file. A deletion counts as a change of the line before it. File names are
+// taken relative to `root`.
+std::vector<LineRange> parse_unified_diff(std::string_view diff, const std::string &root);
+
+// Lines of files that changed, to restrict linting to what overlaps them. Files are compared by
+// their canonical paths, so the same file may be named differently by a range and a location.
+class ChangedLines {
+  std::unordered_map<std::string, std::vector<std::pair<unsigned int, unsigned int>>> _ranges;
+  mutable std::unordered_map<std::string, std::string> _canonical;
+
+  const std::string &canonical(const std::string &file) const;
+
+public:
+  explicit ChangedLines(const std::vector<LineRange> &ranges);
+
+  // Returns true if lines `first` to `last` of `file` overlap a changed line.
+  bool overlaps(const std::string &file, unsigned int first, unsigned int last) const;
+
+  // Returns true if the location of `r` overlaps a changed line. Results without a location never
+  // do and results that only name a file do if the file changed at all.
+  bool overlaps(const LintResult &r) const;
+
+  // The user-defined top-level items of `model` that overlap a changed line.
+  ItemSet items(const MiniZinc::Model *model, const std::vector<std::string> &includePath) const;
+};
+} // namespace LZN
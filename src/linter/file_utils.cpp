@@ -1,27 +1,39 @@
 #include "file_utils.hpp"
 #include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <errno.h>
+#include <fcntl.h>
+#include <filesystem>
 #include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <system_error>
+#include <unistd.h>
 
 namespace LZN {
-std::vector<std::string> lines_of_file(const std::string &filename) {
-  std::ifstream f(filename);
-  if (!f.is_open()) {
-    throw std::system_error(errno, std::generic_category(), filename);
-  }
-  std::vector<std::string> lines;
-  std::string line;
-  while (std::getline(f, line)) {
-    if (!line.empty() && line[line.length() - 1] == '\r')
-      line.pop_back();
-    lines.push_back(std::move(line));
-  }
-  if (f.bad()) {
-    throw std::system_error(errno, std::generic_category());
+namespace {
+// The offset of every newline in `text`, and of its end if the last line has none. memchr is
+// vectorized by the C library, which matters for large generated files.
+std::vector<std::size_t> line_ends(std::string_view text) {
+  std::vector<std::size_t> ends;
+  const char *const begin = text.data();
+  const char *const end = begin + text.size();
+  for (const char *p = begin; p != end;) {
+    const auto *newline =
+        static_cast<const char *>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    if (newline == nullptr) {
+      ends.push_back(text.size());
+      break;
+    }
+    ends.push_back(static_cast<std::size_t>(newline - begin));
+    p = newline + 1;
   }
-  return lines;
+  return ends;
 }
+} // namespace
 
 bool path_included_from(const std::vector<std::string> &includePath, MiniZinc::ASTString path) {
   if (path.size() == 0)
@@ -31,20 +43,169 @@ bool path_included_from(const std::vector<std::string> &includePath, MiniZinc::A
                      [path](const std::string &incpath) { return path.beginsWith(incpath); });
 }
 
-void CachedFileReader::read_to_cache(const CachedFileReader::FilePath &filename) {
-  if (cache.find(filename) == cache.end()) {
-    cache.emplace(filename, lines_of_file(filename));
+std::string canonical_path(const std::string &path) {
+  std::error_code ec;
+  const std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+  if (ec)
+    return path;
+  const std::filesystem::path canonical = std::filesystem::weakly_canonical(absolute, ec);
+  return ec ? path : canonical.string();
+}
+
+std::string percent_encode_path(std::string_view path) {
+  constexpr const char *HEX = "0123456789ABCDEF";
+  std::string encoded;
+  encoded.reserve(path.size());
+  for (const char c : path) {
+    const auto u = static_cast<unsigned char>(c);
+    if (std::isalnum(u) || c == '/' || c == '-' || c == '_' || c == '.' || c == '~') {
+      encoded.push_back(c);
+    } else {
+      encoded.push_back('%');
+      encoded.push_back(HEX[u >> 4]);
+      encoded.push_back(HEX[u & 0xF]);
+    }
+  }
+  return encoded;
+}
+
+bool ensure_directory(const std::string &dir) noexcept {
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  return std::filesystem::is_directory(dir, ec);
+}
+
+std::string read_file(const std::string &filename) {
+  const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(), filename);
+
+  std::string text;
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && st.st_size > 0)
+    text.reserve(static_cast<std::size_t>(st.st_size));
+  // The size is only a hint, the file is read until its end as it is now.
+  char buf[64 * 1024];
+  for (;;) {
+    const ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n == 0)
+      break;
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      const int err = errno;
+      ::close(fd);
+      throw std::system_error(err, std::generic_category(), filename);
+    }
+    text.append(buf, static_cast<std::size_t>(n));
+  }
+  ::close(fd);
+  return text;
+}
+
+bool write_file_atomically(const std::string &filename, std::string_view contents) noexcept {
+  const std::string tmp = filename + ".tmp" + std::to_string(::getpid());
+  {
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    if (!f.is_open())
+      return false;
+    f.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    if (!f.good()) {
+      std::remove(tmp.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp.c_str(), filename.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+TemporaryDirectory::TemporaryDirectory() {
+  std::string templ = (std::filesystem::temp_directory_path() / "lzn-XXXXXX").string();
+  if (::mkdtemp(templ.data()) == nullptr)
+    throw std::system_error(errno, std::generic_category(), templ);
+  _path = std::move(templ);
+}
+
+TemporaryDirectory::~TemporaryDirectory() {
+  std::error_code ec;
+  std::filesystem::remove_all(_path, ec);
+}
+
+MappedFile::MappedFile(const std::string &filename) {
+  const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    throw std::system_error(errno, std::generic_category(), filename);
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    const int err = errno;
+    ::close(fd);
+    throw std::system_error(err, std::generic_category(), filename);
   }
+
+  _size = static_cast<std::size_t>(st.st_size);
+  if (_size > 0) {
+    void *addr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      const int err = errno;
+      ::close(fd);
+      throw std::system_error(err, std::generic_category(), filename);
+    }
+    _data = static_cast<const char *>(addr);
+  }
+  ::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept : _data(other._data), _size(other._size) {
+  other._data = nullptr;
+  other._size = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  std::swap(_data, other._data);
+  std::swap(_size, other._size);
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  if (_data != nullptr)
+    ::munmap(const_cast<char *>(_data), _size);
+}
+
+CachedFileReader::Source::Source(std::string text) : _text(std::move(text)) {
+  _ends = line_ends(_text);
+}
+
+std::string_view CachedFileReader::Source::line(std::size_t i) const noexcept {
+  assert(i < _ends.size());
+  const std::size_t start = i == 0 ? 0 : _ends[i - 1] + 1;
+  std::string_view line = std::string_view(_text).substr(start, _ends[i] - start);
+  if (!line.empty() && line.back() == '\r')
+    line.remove_suffix(1);
+  return line;
+}
+
+const CachedFileReader::Source &
+CachedFileReader::read_to_cache(const CachedFileReader::FilePath &filename) {
+  auto it = cache.find(filename);
+  if (it == cache.end())
+    it = cache.emplace(filename, Source(read_file(filename))).first;
+  return it->second;
 }
 
 CachedFileReader::FileIter CachedFileReader::read(const CachedFileReader::FilePath &filename,
                                                   unsigned int startline, unsigned int endline) {
   assert(endline >= startline && endline > 0 && startline > 0);
-  read_to_cache(filename);
-  const auto &contents = cache.at(filename);
-  auto beg =
-      startline > contents.size() ? contents.end() : std::next(contents.begin(), startline - 1);
-  auto end = endline > contents.size() ? contents.end() : std::next(contents.begin(), endline);
-  return std::make_pair(beg, end);
+  const Source &source = read_to_cache(filename);
+  const std::size_t beg = std::min<std::size_t>(startline - 1, source.lines());
+  const std::size_t end = std::min<std::size_t>(endline, source.lines());
+  return std::make_pair(LineIter(&source, beg), LineIter(&source, end));
+}
+
+void CachedFileReader::add(const CachedFileReader::FilePath &filename, std::string_view text) {
+  cache.insert_or_assign(filename, Source(std::string(text)));
 }
 } // namespace LZN
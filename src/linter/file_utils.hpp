@@ -1,32 +1,132 @@
 #pragma once
 
+#include <cstddef>
+#include <iterator>
 #include <minizinc/aststring.hh>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace LZN {
-// Reads all lines of a file to a vector where each element is a line.
-std::vector<std::string> lines_of_file(const std::string &filename);
-
 // Returns true if `path` originates from a file in any directory from `includePath`.
 bool path_included_from(const std::vector<std::string> &includePath, MiniZinc::ASTString path);
 
-// Reads files and caches them to make a future read of the same file faster.
+// Returns the absolute canonical form of `path`, to tell if differently named paths are the same
+// file. Parts that don't exist are only normalized. Returns `path` itself on errors.
+std::string canonical_path(const std::string &path);
+
+// Returns `path` with every character but letters, digits and "/-_.~" percent-encoded, for use in
+// a URI.
+std::string percent_encode_path(std::string_view path);
+
+// Creates `dir` and all its parents, returns true if it exists afterwards.
+bool ensure_directory(const std::string &dir) noexcept;
+
+// Reads all of `filename` with read(2). Unlike a MappedFile, the copy can't fault if the file is
+// truncated while it is used, e.g. by an editor that saves it again. Throws std::system_error if
+// the file can't be read.
+std::string read_file(const std::string &filename);
+
+// Writes `contents` to `filename` through a temporary file and a rename, so that concurrent readers
+// never see a half-written file. Returns false on failure.
+bool write_file_atomically(const std::string &filename, std::string_view contents) noexcept;
+
+// A fresh directory below the system's temporary directory, which is removed with everything in it
+// when this is destroyed.
+class TemporaryDirectory {
+  std::string _path;
+
+public:
+  // Throws std::system_error if the directory can't be created.
+  TemporaryDirectory();
+  TemporaryDirectory(const TemporaryDirectory &) = delete;
+  TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+  ~TemporaryDirectory();
+
+  const std::string &path() const noexcept { return _path; }
+};
+
+// A read-only memory mapping of a whole file. Reading it faults if the file is truncated, so it is
+// only used for files that lzn writes itself with write_file_atomically, or that no one edits.
+class MappedFile {
+  const char *_data = nullptr;
+  std::size_t _size = 0;
+
+public:
+  // Throws std::system_error if the file can't be opened or mapped.
+  explicit MappedFile(const std::string &filename);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  ~MappedFile();
+
+  std::string_view contents() const noexcept { return {_data, _size}; }
+};
+
+// Reads files and caches them to make a future read of the same file faster. Each file is read
+// into one buffer and indexed by the offsets of its newlines, so its lines are views that are
+// never copied. A '\r' before a newline is not part of a line.
 class CachedFileReader {
+  // The text of a file and where each of its lines ends.
+  class Source {
+    std::string _text;
+    // The offset of the newline after each line, or of the end of the text for a last line
+    // without one.
+    std::vector<std::size_t> _ends;
+
+  public:
+    explicit Source(std::string text);
+
+    std::size_t lines() const noexcept { return _ends.size(); }
+    // Line `i`, counted from 0.
+    std::string_view line(std::size_t i) const noexcept;
+  };
+
 public:
-  using FileContents = std::vector<std::string>;
+  // Iterates over the lines of a file.
+  class LineIter {
+    const Source *_source = nullptr;
+    std::size_t _line = 0;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view *;
+    using reference = std::string_view;
+
+    LineIter() = default;
+    LineIter(const Source *source, std::size_t line) : _source(source), _line(line) {}
+
+    std::string_view operator*() const noexcept { return _source->line(_line); }
+    LineIter &operator++() noexcept {
+      ++_line;
+      return *this;
+    }
+    LineIter operator++(int) noexcept { return LineIter(_source, _line++); }
+    bool operator==(const LineIter &other) const noexcept {
+      return _source == other._source && _line == other._line;
+    }
+    bool operator!=(const LineIter &other) const noexcept { return !(*this == other); }
+  };
+
   using FilePath = std::string;
-  using FileIter = std::pair<FileContents::const_iterator, FileContents::const_iterator>;
+  using FileIter = std::pair<LineIter, LineIter>;
 
 private:
   // maps filepaths to their contents
-  std::unordered_map<FilePath, FileContents> cache;
+  std::unordered_map<FilePath, Source> cache;
   // read `filename` and store it in `cache`.
-  void read_to_cache(const FilePath &filename);
+  const Source &read_to_cache(const FilePath &filename);
 
 public:
   // Returns a pair of iterators to all lines in file `filename`, starting from `startline` to
-  // `endline` (inclusive).
+  // `endline` (inclusive). The lines stay valid as long as the reader and the file do. Throws
+  // std::system_error if the file can't be read.
   FileIter read(const FilePath &filename, unsigned int startline, unsigned int endline);
+  // Use `text` as the contents of `filename`, for models that don't live on disk.
+  void add(const FilePath &filename, std::string_view text);
 };
 } // namespace LZN
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace LZN {
+// Incremental 64-bit FNV-1a hash. Not cryptographic, only used to detect changes in files and
+// models.
+class Hasher {
+  static constexpr std::uint64_t OFFSET = 0xcbf29ce484222325ULL;
+  static constexpr std::uint64_t PRIME = 0x100000001b3ULL;
+  std::uint64_t h = OFFSET;
+
+public:
+  Hasher &add(std::string_view bytes) noexcept {
+    for (const unsigned char c : bytes) {
+      h ^= c;
+      h *= PRIME;
+    }
+    return *this;
+  }
+
+  // Hash the bytes of an integral value. A separator is not needed since the size is fixed.
+  template <typename T, typename = std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>>>
+  Hasher &add(T value) noexcept {
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+      h ^= static_cast<std::uint64_t>(value) >> (8 * i) & 0xff;
+      h *= PRIME;
+    }
+    return *this;
+  }
+
+  // Hash a string followed by a terminator, so that ("ab", "c") and ("a", "bc") differ.
+  Hasher &add_string(std::string_view s) noexcept { return add(s).add('\0'); }
+
+  std::uint64_t value() const noexcept { return h; }
+};
+} // namespace LZN
@@ -0,0 +1,278 @@
+#include "incremental.hpp"
+#include <algorithm>
+#include <limits>
+#include <linter/hashing.hpp>
+#include <linter/overload.hpp>
+#include <minizinc/astiterator.hh>
+#include <optional>
+
+namespace {
+using namespace LZN;
+
+void collect(const MiniZinc::Expression *e, std::vector<const MiniZinc::Expression *> &nodes) {
+  if (e == nullptr)
+    return;
+
+  struct : MiniZinc::EVisitor {
+    std::vector<const MiniZinc::Expression *> *nodes;
+    bool enter(MiniZinc::Expression *e) {
+      nodes->push_back(e);
+      return true;
+    }
+  } collector;
+  collector.nodes = &nodes;
+
+  // NOTE: Assume that top_down doesn't modify e
+  MiniZinc::top_down(collector, const_cast<MiniZinc::Expression *>(e));
+}
+
+void collect(const MiniZinc::Annotation &ann, std::vector<const MiniZinc::Expression *> &nodes) {
+  for (const MiniZinc::Expression *e : ann)
+    collect(e, nodes);
+}
+
+bool is_file(MiniZinc::ASTString filename, const std::string &name) {
+  return filename.size() > 0 && name == filename.c_str();
+}
+
+// The region of `content` as a range of lines, or nullopt if there is none.
+std::optional<std::pair<unsigned int, unsigned int>> lines_of(const FileContents &content) {
+  return std::visit(overload{
+                        [](const std::monostate &) {
+                          return std::optional<std::pair<unsigned int, unsigned int>>();
+                        },
+                        [](const FileContents::OneLineMarked &olm) {
+                          return std::make_optional(std::make_pair(olm.line, olm.line));
+                        },
+                        [](const FileContents::MultiLine &ml) {
+                          return std::make_optional(std::make_pair(ml.startline, ml.endline));
+                        },
+                    },
+                    content.region);
+}
+
+void shift_lines(FileContents &content, int delta) {
+  std::visit(overload{
+                 [](std::monostate &) {},
+                 [delta](FileContents::OneLineMarked &olm) { olm.line += delta; },
+                 [delta](FileContents::MultiLine &ml) {
+                   ml.startline += delta;
+                   ml.endline += delta;
+                 },
+             },
+             content.region);
+}
+
+void shift_lines(LintResult &r, int delta) {
+  shift_lines(r.content, delta);
+  for (auto &sub : r.sub_results)
+    shift_lines(sub.content, delta);
+}
+
+// Returns true if `content` is somewhere in the lines of `fp`, notes without a location count too.
+bool is_within(const FileContents &content, const ItemFingerprint &fp, bool allow_empty) {
+  if (content.is_empty())
+    return allow_empty;
+  const auto lines = lines_of(content);
+  return lines && content.filename == fp.filename && lines->first >= fp.first_line &&
+         lines->second <= fp.last_line;
+}
+
+bool is_within(const LintResult &r, const ItemFingerprint &fp) {
+  return is_within(r.content, fp, false) &&
+         std::all_of(r.sub_results.begin(), r.sub_results.end(), [&fp](const LintResult::Sub &sub) {
+           return is_within(sub.content, fp, true);
+         });
+}
+} // namespace
+
+namespace LZN {
+ItemFingerprint fingerprint(const MiniZinc::Item *item) {
+  using I = MiniZinc::Item;
+  Hasher h;
+  h.add(item->iid());
+
+  std::vector<const MiniZinc::Expression *> nodes;
+  switch (item->iid()) {
+  case I::II_INC: h.add_string(item->cast<MiniZinc::IncludeI>()->f().c_str()); break;
+  case I::II_VD: collect(item->cast<MiniZinc::VarDeclI>()->e(), nodes); break;
+  case I::II_ASN: {
+    auto ai = item->cast<MiniZinc::AssignI>();
+    h.add_string(ai->id().c_str());
+    collect(ai->e(), nodes);
+    break;
+  }
+  case I::II_CON: collect(item->cast<MiniZinc::ConstraintI>()->e(), nodes); break;
+  case I::II_SOL: {
+    auto si = item->cast<MiniZinc::SolveI>();
+    h.add(si->st());
+    collect(si->e(), nodes);
+    collect(si->ann(), nodes);
+    break;
+  }
+  case I::II_OUT: collect(item->cast<MiniZinc::OutputI>()->e(), nodes); break;
+  case I::II_FUN: {
+    auto fi = item->cast<MiniZinc::FunctionI>();
+    h.add_string(fi->id().c_str());
+    collect(fi->ti(), nodes);
+    for (const MiniZinc::VarDecl *param : fi->params())
+      collect(param, nodes);
+    collect(fi->e(), nodes);
+    collect(fi->ann(), nodes);
+    break;
+  }
+  default: break;
+  }
+
+  ItemFingerprint fp;
+  const MiniZinc::Location &loc = item->loc();
+  if (loc.filename().size() > 0)
+    fp.filename = loc.filename().c_str();
+  else if (!nodes.empty() && nodes.front()->loc().filename().size() > 0)
+    fp.filename = nodes.front()->loc().filename().c_str();
+  h.add_string(fp.filename);
+
+  fp.first_line = loc.firstLine() > 0 ? loc.firstLine() : std::numeric_limits<unsigned int>::max();
+  fp.last_line = loc.lastLine();
+  for (const auto *e : nodes) {
+    const MiniZinc::Location &l = e->loc();
+    if (!is_file(l.filename(), fp.filename) || l.firstLine() == 0)
+      continue;
+    fp.first_line = std::min(fp.first_line, l.firstLine());
+    fp.last_line = std::max(fp.last_line, l.lastLine());
+  }
+  if (fp.first_line > fp.last_line)
+    fp.first_line = fp.last_line;
+
+  for (const auto *e : nodes) {
+    const MiniZinc::Location &l = e->loc();
+    h.add(e->eid())
+        .add(e->type().toInt())
+        .add(MiniZinc::Expression::hash(e))
+        .add(is_file(l.filename(), fp.filename))
+        .add(l.firstLine() - fp.first_line)
+        .add(l.firstColumn())
+        .add(l.lastLine() - fp.first_line)
+        .add(l.lastColumn());
+  }
+
+  fp.hash = h.value();
+  return fp;
+}
+
+std::vector<LintResult> IncrementalLinter::lint(const MiniZinc::Model *model, MiniZinc::Env &env,
+                                                const std::vector<std::string> &includePath,
+                                                const std::vector<const LintRule *> &rules) {
+  if (rules != _rules) {
+    clear();
+    _rules = rules;
+  }
+  _stats = Stats();
+
+  auto is_item_local = [this](const LintRule *rule) {
+    return rule->scope == Scope::ITEM && _misbehaving.count(rule) == 0;
+  };
+
+  // Fingerprint every user-defined item and reuse what can be reused.
+  const auto s = SearchBuilder().only_user_defined(includePath).recursive().in_everywhere().build();
+  auto ms = s.search(model);
+  std::unordered_map<std::uint64_t, CachedItem> next_cache;
+  std::vector<LintResult> item_results;
+  ItemSet dirty;
+  std::vector<std::pair<const MiniZinc::Item *, ItemFingerprint>> dirty_prints;
+  while (ms.next()) {
+    const MiniZinc::Item *item = ms.cur_item();
+    ItemFingerprint fp = fingerprint(item);
+    ++_stats.items;
+
+    if (next_cache.count(fp.hash) > 0) {
+      // An identical item elsewhere in the same file has already been handled.
+      const CachedItem &cached = next_cache.at(fp.hash);
+      for (LintResult r : cached.results) {
+        shift_lines(r, static_cast<int>(fp.first_line) - static_cast<int>(cached.first_line));
+        item_results.push_back(std::move(r));
+      }
+      ++_stats.reused;
+    } else if (auto it = _cache.find(fp.hash); it != _cache.end()) {
+      for (LintResult r : it->second.results) {
+        shift_lines(r, static_cast<int>(fp.first_line) - static_cast<int>(it->second.first_line));
+        item_results.push_back(std::move(r));
+      }
+      next_cache.emplace(fp.hash, std::move(it->second));
+      ++_stats.reused;
+    } else {
+      dirty.insert(item);
+      dirty_prints.emplace_back(item, std::move(fp));
+    }
+  }
+
+  // Run item-local rules on the dirty items only.
+  LintEnv item_env(model, env, includePath);
+  item_env.only_items(&dirty);
+  for (const LintRule *rule : rules) {
+    if (is_item_local(rule))
+      rule->run(item_env);
+  }
+
+  // Attribute the new results to their items.
+  std::vector<LintResult> fresh = item_env.take_results();
+  std::unordered_map<std::string, std::vector<const ItemFingerprint *>> by_file;
+  for (const auto &[item, fp] : dirty_prints)
+    by_file[fp.filename].push_back(&fp);
+  std::unordered_map<const ItemFingerprint *, std::vector<LintResult>> attributed;
+  for (auto &r : fresh) {
+    const ItemFingerprint *owner = nullptr;
+    if (auto it = by_file.find(r.content.filename); it != by_file.end()) {
+      for (const ItemFingerprint *fp : it->second) {
+        if (is_within(r, *fp)) {
+          owner = fp;
+          break;
+        }
+      }
+    }
+    if (owner == nullptr)
+      _misbehaving.insert(r.rule);
+    else
+      attributed[owner].push_back(std::move(r));
+  }
+
+  for (const auto &[item, fp] : dirty_prints) {
+    auto &results = attributed[&fp];
+    auto misbehaved = [this](const LintResult &r) { return _misbehaving.count(r.rule) > 0; };
+    results.erase(std::remove_if(results.begin(), results.end(), misbehaved), results.end());
+    item_results.insert(item_results.end(), results.begin(), results.end());
+    next_cache.emplace(fp.hash, CachedItem{fp.first_line, std::move(results)});
+  }
+  _cache = std::move(next_cache);
+
+  // Run the whole-model rules, including item-local rules that can't be trusted to be.
+  LintEnv model_env(model, env, includePath);
+  std::vector<LintResult> results;
+  for (const LintRule *rule : rules) {
+    if (is_item_local(rule)) {
+      std::vector<LintResult> of_rule;
+      for (auto &r : item_results) {
+        if (r.rule == rule)
+          of_rule.push_back(std::move(r));
+      }
+      std::stable_sort(of_rule.begin(), of_rule.end(), [](const auto &a, const auto &b) {
+        return a.content < b.content;
+      });
+      results.insert(results.end(), std::make_move_iterator(of_rule.begin()),
+                     std::make_move_iterator(of_rule.end()));
+    } else {
+      const std::size_t before = model_env.results().size();
+      rule->run(model_env);
+      const auto &all = model_env.results();
+      results.insert(results.end(), all.begin() + before, all.end());
+    }
+  }
+  return results;
+}
+
+void IncrementalLinter::clear() noexcept {
+  _cache.clear();
+  _misbehaving.clear();
+  _stats = Stats();
+}
+} // namespace LZN
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <linter/rules.hpp>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace LZN {
+// A fingerprint of a top-level item: its structure, the types of its expressions and their
+// locations relative to the first line of the item.
+struct ItemFingerprint {
+  std::uint64_t hash;
+  std::string filename;
+  unsigned int first_line; // the lines the item spans in `filename`
+  unsigned int last_line;
+};
+
+ItemFingerprint fingerprint(const MiniZinc::Item *item);
+
+// Lints successive versions of a model in a long-lived process, reusing the results of item-local
+// rules for the items that didn't change since the previous version. Whole-model rules always run.
+class IncrementalLinter {
+  struct CachedItem {
+    unsigned int first_line;
+    std::vector<LintResult> results;
+  };
+
+  std::vector<const LintRule *> _rules;
+  std::unordered_map<std::uint64_t, CachedItem> _cache;
+  // Item-local rules that produced results outside of the item, they are treated as whole-model.
+  std::unordered_set<const LintRule *> _misbehaving;
+
+public:
+  // Statistics of the latest call to `lint`.
+  struct Stats {
+    std::size_t items = 0;  // user-defined top-level items in the model
+    std::size_t reused = 0; // items whose cached results were reused
+  };
+
+private:
+  Stats _stats;
+
+public:
+  // Run `rules` on `model`. The results are the same as from running all rules on a LintEnv, but
+  // sorted per rule.
+  std::vector<LintResult> lint(const MiniZinc::Model *model, MiniZinc::Env &env,
+                               const std::vector<std::string> &includePath,
+                               const std::vector<const LintRule *> &rules);
+
+  const Stats &stats() const noexcept { return _stats; }
+  // Forget all cached results.
+  void clear() noexcept;
+};
+} // namespace LZN
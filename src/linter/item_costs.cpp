@@ -0,0 +1,90 @@
+#include "item_costs.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <minizinc/ast.hh>
+
+namespace LZN {
+std::string item_label(const MiniZinc::Item *item) {
+  using I = MiniZinc::Item;
+  std::string label;
+  switch (item->iid()) {
+  case I::II_INC: label = "include"; break;
+  case I::II_VD:
+    label = "var ";
+    label += item->cast<MiniZinc::VarDeclI>()->e()->id()->str().c_str();
+    break;
+  case I::II_ASN:
+    label = "assign ";
+    label += item->cast<MiniZinc::AssignI>()->id().c_str();
+    break;
+  case I::II_CON: label = "constraint"; break;
+  case I::II_SOL: label = "solve"; break;
+  case I::II_OUT: label = "output"; break;
+  case I::II_FUN:
+    label = "function ";
+    label += item->cast<MiniZinc::FunctionI>()->id().c_str();
+    break;
+  default: label = "item"; break;
+  }
+  const MiniZinc::Location &loc = item->loc();
+  label += " at ";
+  label += loc.filename().c_str();
+  label += ':' + std::to_string(loc.firstLine());
+  return label;
+}
+
+void ItemCosts::enter(const MiniZinc::Item *item) {
+  _open.push_back({item, std::chrono::steady_clock::now()});
+}
+
+void ItemCosts::leave(const MiniZinc::Item *item, std::uint64_t nodes) {
+  const auto end = std::chrono::steady_clock::now();
+  // Searches almost always end in the reverse order they started, one that doesn't only loses
+  // the time of the spans nested in it.
+  auto open = std::find_if(_open.rbegin(), _open.rend(),
+                           [item](const Open &o) { return o.item == item; });
+  if (open == _open.rend())
+    return;
+  const auto spent = end - open->start;
+  const auto own = spent - open->nested;
+  const bool innermost = open == _open.rbegin();
+  _open.erase(std::next(open).base());
+  if (innermost && !_open.empty())
+    _open.back().nested += spent;
+
+  const std::string label = item_label(item);
+  auto it = _index.find(label);
+  if (it == _index.end()) {
+    it = _index.emplace(label, _costs.size()).first;
+    _costs.push_back(Cost{label});
+  }
+  Cost &c = _costs[it->second];
+  c.wall += own;
+  c.nodes += nodes;
+  ++c.visits;
+}
+
+std::vector<ItemCosts::Cost> ItemCosts::top(std::size_t n) const {
+  std::vector<Cost> costs = _costs;
+  const auto longer = [](const Cost &a, const Cost &b) { return a.wall > b.wall; };
+  if (n < costs.size()) {
+    std::partial_sort(costs.begin(), costs.begin() + static_cast<std::ptrdiff_t>(n), costs.end(),
+                      longer);
+    costs.resize(n);
+  } else {
+    std::sort(costs.begin(), costs.end(), longer);
+  }
+  return costs;
+}
+
+void ItemCosts::print(std::ostream &os, std::size_t n) const {
+  const auto flags = os.flags();
+  os << std::right << std::setw(11) << "wall ms" << std::setw(12) << "nodes" << std::setw(8)
+     << "visits" << "  item\n";
+  os << std::fixed << std::setprecision(2);
+  for (const auto &c : top(n))
+    os << std::setw(11) << c.wall.count() << std::setw(12) << c.nodes << std::setw(8) << c.visits
+       << "  " << c.item << '\n';
+  os.flags(flags);
+}
+} // namespace LZN
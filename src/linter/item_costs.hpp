@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <minizinc/model.hh>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace LZN {
+// What traces and reports call a top-level item: its kind, its name if it has one, and the file
+// and line where it starts.
+std::string item_label(const MiniZinc::Item *item);
+
+// The time that searches spent in each top-level item and the expressions they queued there,
+// summed over every rule and cached analysis, for `--item-costs`. Items are told apart by their
+// labels, so the costs outlive the model.
+class ItemCosts {
+public:
+  struct Cost {
+    std::string item;
+    std::chrono::duration<double, std::milli> wall{0};
+    std::uint64_t nodes = 0;  // expressions queued
+    unsigned int visits = 0; // by searches
+  };
+
+  // Attributes the time from now until `leave` to `item`. A span that is entered while another
+  // one is open, e.g. by a cached analysis that is computed for a rule, takes its time away from
+  // the other one, so that time is never attributed twice.
+  void enter(const MiniZinc::Item *item);
+  // Ends the span of `item` and attributes the `nodes` queued in it.
+  void leave(const MiniZinc::Item *item, std::uint64_t nodes);
+
+  // The `n` items that took the longest, the longest first.
+  std::vector<Cost> top(std::size_t n) const;
+  // Prints a table of the `n` items that took the longest.
+  void print(std::ostream &os, std::size_t n) const;
+
+private:
+  struct Open {
+    const MiniZinc::Item *item;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::duration nested{0}; // spent in spans entered since
+  };
+
+  std::vector<Cost> _costs;
+  std::unordered_map<std::string, std::size_t> _index; // by label
+  std::vector<Open> _open;
+};
+} // namespace LZN
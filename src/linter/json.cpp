@@ -0,0 +1,335 @@
+#include "json.hpp"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+using namespace LZN;
+
+// Deeper documents are rejected rather than risking the stack.
+constexpr unsigned int MAX_DEPTH = 512;
+
+class Parser {
+  std::string_view text;
+  std::size_t pos = 0;
+
+  [[noreturn]] void fail(const char *what) const {
+    throw std::invalid_argument(std::string("invalid JSON at offset ") + std::to_string(pos) +
+                                ": " + what);
+  }
+
+  void skip_whitespace() {
+    while (pos < text.size() &&
+           (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+      ++pos;
+  }
+
+  bool consume(char c) {
+    skip_whitespace();
+    if (pos < text.size() && text[pos] == c) {
+      ++pos;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c) {
+    if (!consume(c))
+      fail("unexpected character");
+  }
+
+  bool consume_literal(std::string_view lit) {
+    if (text.substr(pos, lit.size()) != lit)
+      return false;
+    pos += lit.size();
+    return true;
+  }
+
+  unsigned int hex4() {
+    if (pos + 4 > text.size())
+      fail("truncated escape");
+    unsigned int v = 0;
+    for (int i = 0; i < 4; ++i) {
+      const char c = text[pos++];
+      v <<= 4;
+      if (c >= '0' && c <= '9')
+        v |= static_cast<unsigned int>(c - '0');
+      else if (c >= 'a' && c <= 'f')
+        v |= static_cast<unsigned int>(c - 'a' + 10);
+      else if (c >= 'A' && c <= 'F')
+        v |= static_cast<unsigned int>(c - 'A' + 10);
+      else
+        fail("invalid escape");
+    }
+    return v;
+  }
+
+  static void append_utf8(std::string &out, unsigned int cp) {
+    if (cp < 0x80) {
+      out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+      out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+      out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+      out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+  }
+
+  std::string string() {
+    expect('"');
+    std::string out;
+    while (true) {
+      if (pos >= text.size())
+        fail("unterminated string");
+      const char c = text[pos++];
+      if (c == '"')
+        return out;
+      if (static_cast<unsigned char>(c) < 0x20)
+        fail("control character in string");
+      if (c != '\\') {
+        out.push_back(c);
+        continue;
+      }
+      if (pos >= text.size())
+        fail("unterminated string");
+      switch (text[pos++]) {
+      case '"': out.push_back('"'); break;
+      case '\\': out.push_back('\\'); break;
+      case '/': out.push_back('/'); break;
+      case 'b': out.push_back('\b'); break;
+      case 'f': out.push_back('\f'); break;
+      case 'n': out.push_back('\n'); break;
+      case 'r': out.push_back('\r'); break;
+      case 't': out.push_back('\t'); break;
+      case 'u': {
+        unsigned int cp = hex4();
+        if (cp >= 0xD800 && cp < 0xDC00 && consume_literal("\\u")) {
+          const unsigned int low = hex4();
+          if (low < 0xDC00 || low >= 0xE000)
+            fail("invalid surrogate pair");
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        }
+        append_utf8(out, cp);
+        break;
+      }
+      default: fail("invalid escape");
+      }
+    }
+  }
+
+  Json number() {
+    const std::size_t start = pos;
+    bool integral = true;
+    if (pos < text.size() && text[pos] == '-')
+      ++pos;
+    while (pos < text.size()) {
+      const char c = text[pos];
+      if (c == '.' || c == 'e' || c == 'E' || c == '+' || (c == '-' && pos > start))
+        integral = false;
+      else if (c < '0' || c > '9')
+        break;
+      ++pos;
+    }
+    const std::string num(text.substr(start, pos - start));
+    if (num.empty() || num == "-")
+      fail("invalid number");
+    char *end = nullptr;
+    errno = 0;
+    if (integral) {
+      const long long v = std::strtoll(num.c_str(), &end, 10);
+      if (*end == '\0' && errno == 0)
+        return Json(static_cast<std::int64_t>(v));
+      errno = 0;
+    }
+    const double d = std::strtod(num.c_str(), &end);
+    if (*end != '\0')
+      fail("invalid number");
+    return Json(d);
+  }
+
+  Json value(unsigned int depth) {
+    if (depth > MAX_DEPTH)
+      fail("nested too deeply");
+    skip_whitespace();
+    if (pos >= text.size())
+      fail("unexpected end of input");
+
+    switch (text[pos]) {
+    case '{': {
+      ++pos;
+      Json::Object obj;
+      if (consume('}'))
+        return obj;
+      do {
+        skip_whitespace();
+        std::string key = string();
+        expect(':');
+        obj.emplace_back(std::move(key), value(depth + 1));
+      } while (consume(','));
+      expect('}');
+      return obj;
+    }
+    case '[': {
+      ++pos;
+      Json::Array arr;
+      if (consume(']'))
+        return arr;
+      do {
+        arr.push_back(value(depth + 1));
+      } while (consume(','));
+      expect(']');
+      return arr;
+    }
+    case '"': return string();
+    default: break;
+    }
+
+    if (consume_literal("null"))
+      return nullptr;
+    if (consume_literal("true"))
+      return true;
+    if (consume_literal("false"))
+      return false;
+    return number();
+  }
+
+public:
+  explicit Parser(std::string_view text) : text(text) {}
+
+  Json document() {
+    Json v = value(0);
+    skip_whitespace();
+    if (pos != text.size())
+      fail("trailing characters");
+    return v;
+  }
+};
+} // namespace
+
+namespace LZN {
+std::int64_t Json::as_int() const {
+  if (auto d = std::get_if<double>(&_value))
+    return static_cast<std::int64_t>(*d);
+  return std::get<std::int64_t>(_value);
+}
+
+double Json::as_double() const {
+  if (auto i = std::get_if<std::int64_t>(&_value))
+    return static_cast<double>(*i);
+  return std::get<double>(_value);
+}
+
+const Json &Json::operator[](std::string_view key) const noexcept {
+  static const Json null;
+  if (auto obj = std::get_if<Object>(&_value)) {
+    for (const auto &[k, v] : *obj) {
+      if (k == key)
+        return v;
+    }
+  }
+  return null;
+}
+
+Json &Json::set(std::string_view key, Json value) {
+  if (is_null())
+    _value = Object();
+  auto &obj = std::get<Object>(_value);
+  for (auto &[k, v] : obj) {
+    if (k == key) {
+      v = std::move(value);
+      return *this;
+    }
+  }
+  obj.emplace_back(std::string(key), std::move(value));
+  return *this;
+}
+
+Json &Json::push_back(Json value) {
+  if (is_null())
+    _value = Array();
+  std::get<Array>(_value).push_back(std::move(value));
+  return *this;
+}
+
+void Json::dump(std::ostream &os) const {
+  struct Dumper {
+    std::ostream &os;
+    void operator()(std::nullptr_t) { os << "null"; }
+    void operator()(bool b) { os << (b ? "true" : "false"); }
+    void operator()(std::int64_t i) { os << i; }
+    void operator()(double d) {
+      if (!std::isfinite(d)) {
+        os << "null";
+        return;
+      }
+      char buf[32];
+      std::snprintf(buf, sizeof(buf), "%.15g", d);
+      os << buf;
+    }
+    void operator()(const std::string &s) { write_json_string(os, s); }
+    void operator()(const Array &arr) {
+      os << '[';
+      for (std::size_t i = 0; i < arr.size(); ++i) {
+        if (i > 0)
+          os << ',';
+        arr[i].dump(os);
+      }
+      os << ']';
+    }
+    void operator()(const Object &obj) {
+      os << '{';
+      for (std::size_t i = 0; i < obj.size(); ++i) {
+        if (i > 0)
+          os << ',';
+        write_json_string(os, obj[i].first);
+        os << ':';
+        obj[i].second.dump(os);
+      }
+      os << '}';
+    }
+  };
+  std::visit(Dumper{os}, _value);
+}
+
+std::string Json::dump() const {
+  std::ostringstream os;
+  dump(os);
+  return os.str();
+}
+
+Json Json::parse(std::string_view text) {
+  return Parser(text).document();
+}
+
+void write_json_string(std::ostream &os, std::string_view s) {
+  constexpr const char *HEX = "0123456789abcdef";
+  os << '"';
+  for (const char c : s) {
+    switch (c) {
+    case '"': os << "\\\""; break;
+    case '\\': os << "\\\\"; break;
+    case '\b': os << "\\b"; break;
+    case '\f': os << "\\f"; break;
+    case '\n': os << "\\n"; break;
+    case '\r': os << "\\r"; break;
+    case '\t': os << "\\t"; break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20)
+        os << "\\u00" << HEX[(c >> 4) & 0xF] << HEX[c & 0xF];
+      else
+        os << c;
+    }
+  }
+  os << '"';
+}
+} // namespace LZN
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace LZN {
+// A JSON value. Objects keep their members in insertion order.
+class Json {
+public:
+  using Array = std::vector<Json>;
+  using Object = std::vector<std::pair<std::string, Json>>;
+
+private:
+  std::variant<std::nullptr_t, bool, std::int64_t, double, std::string, Array, Object> _value;
+
+public:
+  Json(std::nullptr_t = nullptr) noexcept : _value(nullptr) {}
+  Json(bool b) noexcept : _value(b) {}
+  template <typename T,
+            std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+  Json(T i) noexcept : _value(static_cast<std::int64_t>(i)) {}
+  Json(double d) noexcept : _value(d) {}
+  Json(const char *s) : _value(std::string(s)) {}
+  Json(std::string_view s) : _value(std::string(s)) {}
+  Json(std::string s) noexcept : _value(std::move(s)) {}
+  Json(Array a) noexcept : _value(std::move(a)) {}
+  Json(Object o) noexcept : _value(std::move(o)) {}
+
+  bool is_null() const noexcept { return std::holds_alternative<std::nullptr_t>(_value); }
+  bool is_bool() const noexcept { return std::holds_alternative<bool>(_value); }
+  bool is_int() const noexcept { return std::holds_alternative<std::int64_t>(_value); }
+  bool is_number() const noexcept { return is_int() || std::holds_alternative<double>(_value); }
+  bool is_string() const noexcept { return std::holds_alternative<std::string>(_value); }
+  bool is_array() const noexcept { return std::holds_alternative<Array>(_value); }
+  bool is_object() const noexcept { return std::holds_alternative<Object>(_value); }
+
+  // Accessors, they throw std::bad_variant_access if the value is of another type.
+  bool as_bool() const { return std::get<bool>(_value); }
+  std::int64_t as_int() const;
+  double as_double() const;
+  const std::string &as_string() const { return std::get<std::string>(_value); }
+  const Array &as_array() const { return std::get<Array>(_value); }
+  Array &as_array() { return std::get<Array>(_value); }
+  const Object &as_object() const { return std::get<Object>(_value); }
+  Object &as_object() { return std::get<Object>(_value); }
+
+  // Returns member `key` of an object, or null if there is no such member or this isn't an object.
+  const Json &operator[](std::string_view key) const noexcept;
+
+  // Sets member `key` of an object, or of null which then becomes an object. Returns *this.
+  Json &set(std::string_view key, Json value);
+  // Appends to an array, or to null which then becomes an array. Returns *this.
+  Json &push_back(Json value);
+
+  void dump(std::ostream &os) const;
+  std::string dump() const;
+
+  // Parses a whole JSON document. Throws std::invalid_argument if `text` isn't valid JSON.
+  static Json parse(std::string_view text);
+
+  bool operator==(const Json &other) const { return _value == other._value; }
+  bool operator!=(const Json &other) const { return !(*this == other); }
+};
+
+// Writes `s` as a quoted and escaped JSON string, for output that is streamed rather than built.
+void write_json_string(std::ostream &os, std::string_view s);
+} // namespace LZN
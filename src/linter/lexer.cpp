@@ -0,0 +1,135 @@
+#include "lexer.hpp"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <linter/file_utils.hpp>
+#include <unordered_set>
+
+namespace {
+bool is_ident_start(char c) {
+  return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool is_ident_char(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+namespace fs = std::filesystem;
+} // namespace
+
+namespace LZN {
+std::vector<Token> tokenize(std::string_view src) {
+  std::vector<Token> tokens;
+  unsigned int line = 1;
+  std::size_t i = 0;
+  const std::size_t n = src.size();
+
+  while (i < n) {
+    const char c = src[i];
+
+    if (c == '\n') {
+      ++line;
+      ++i;
+    } else if (std::isspace(static_cast<unsigned char>(c))) {
+      ++i;
+    } else if (c == '%') {
+      while (i < n && src[i] != '\n')
+        ++i;
+    } else if (c == '/' && i + 1 < n && src[i + 1] == '*') {
+      i += 2;
+      while (i < n && !(src[i] == '*' && i + 1 < n && src[i + 1] == '/')) {
+        if (src[i] == '\n')
+          ++line;
+        ++i;
+      }
+      i = i + 2 > n ? n : i + 2;
+    } else if (c == '"') {
+      const std::size_t start = ++i;
+      while (i < n && src[i] != '"' && src[i] != '\n') {
+        if (src[i] == '\\')
+          ++i;
+        ++i;
+      }
+      tokens.push_back({Token::Kind::STRING, src.substr(start, std::min(i, n) - start), line});
+      if (i < n && src[i] == '"')
+        ++i;
+    } else if (c == '\'') {
+      const std::size_t start = ++i;
+      while (i < n && src[i] != '\'' && src[i] != '\n')
+        ++i;
+      tokens.push_back({Token::Kind::IDENT, src.substr(start, i - start), line});
+      if (i < n && src[i] == '\'')
+        ++i;
+    } else if (is_ident_start(c)) {
+      const std::size_t start = i;
+      while (i < n && is_ident_char(src[i]))
+        ++i;
+      tokens.push_back({Token::Kind::IDENT, src.substr(start, i - start), line});
+    } else if (std::isdigit(static_cast<unsigned char>(c))) {
+      const std::size_t start = i;
+      while (i < n && (is_ident_char(src[i]) || src[i] == '.') &&
+             !(src[i] == '.' && i + 1 < n && src[i + 1] == '.'))
+        ++i;
+      tokens.push_back({Token::Kind::OTHER, src.substr(start, i - start), line});
+    } else if (std::ispunct(static_cast<unsigned char>(c))) {
+      tokens.push_back({Token::Kind::PUNCT, src.substr(i, 1), line});
+      ++i;
+    } else {
+      tokens.push_back({Token::Kind::OTHER, src.substr(i, 1), line});
+      ++i;
+    }
+  }
+
+  return tokens;
+}
+
+std::vector<std::string_view> included_files(const std::vector<Token> &tokens) {
+  std::vector<std::string_view> files;
+  for (std::size_t i = 0; i + 1 < tokens.size(); ++i) {
+    if (tokens[i].is_ident("include") && tokens[i + 1].kind == Token::Kind::STRING)
+      files.push_back(tokens[i + 1].text);
+  }
+  return files;
+}
+
+std::optional<std::pair<std::string, bool>>
+resolve_include(std::string_view name, const std::string &from,
+                const std::vector<std::string> &includePath) {
+  std::error_code ec;
+  const fs::path path(name);
+  if (path.is_absolute())
+    return fs::is_regular_file(path, ec) ? std::make_optional(std::make_pair(path.string(), true))
+                                         : std::nullopt;
+
+  const fs::path local = fs::path(from).parent_path() / path;
+  if (fs::is_regular_file(local, ec))
+    return std::make_pair(local.string(), true);
+  for (const auto &dir : includePath) {
+    const fs::path candidate = fs::path(dir) / path;
+    if (fs::is_regular_file(candidate, ec))
+      return std::make_pair(candidate.string(), false);
+  }
+  return std::nullopt;
+}
+
+void walk_includes(const std::vector<std::string> &roots,
+                   const std::vector<std::string> &includePath,
+                   const std::function<void(const std::string &, std::string_view)> &visit,
+                   const std::function<void(std::string_view, const std::string &)> &include) {
+  std::vector<std::string> pending(roots.rbegin(), roots.rend());
+  std::unordered_set<std::string> seen(roots.begin(), roots.end());
+  while (!pending.empty()) {
+    const std::string file = std::move(pending.back());
+    pending.pop_back();
+    const std::string contents = read_file(file);
+    visit(file, contents);
+
+    const auto names = included_files(tokenize(contents));
+    for (auto it = names.rbegin(); it != names.rend(); ++it) {
+      auto resolved = resolve_include(*it, file, includePath);
+      include(*it, resolved ? resolved->first : std::string());
+      if (resolved && resolved->second && seen.insert(resolved->first).second)
+        pending.push_back(std::move(resolved->first));
+    }
+  }
+}
+} // namespace LZN
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace LZN {
+
+// A token from a lexical scan of a MiniZinc file. The scan is much cheaper than
+// `MiniZinc::parse` and is meant for quick questions such as what a file includes or declares,
+// not for linting.
+struct Token {
+  enum class Kind {
+    IDENT,  // an identifier or keyword, quoted identifiers ('+') are given without quotes
+    STRING, // a string literal, given without quotes and without unescaping
+    PUNCT,  // a single punctuation character
+    OTHER,  // numbers and anything else
+  };
+
+  Kind kind;
+  std::string_view text; // points into the scanned source
+  unsigned int line;     // 1-based
+
+  bool is(Kind k, std::string_view t) const noexcept { return kind == k && text == t; }
+  bool is_ident(std::string_view t) const noexcept { return is(Kind::IDENT, t); }
+  bool is_punct(char c) const noexcept { return is(Kind::PUNCT, std::string_view(&c, 1)); }
+};
+
+// Split `src` into tokens, comments are skipped.
+std::vector<Token> tokenize(std::string_view src);
+
+// The file names of all include items in `tokens`, in order.
+std::vector<std::string_view> included_files(const std::vector<Token> &tokens);
+
+// Where `name`, included from the file `from`, resolves to and whether it is a user file. Resolved
+// like `MiniZinc::parse` does: relative to the including file first, then in `includePath`, where
+// files aren't user files. Returns nullopt if it can't be resolved.
+std::optional<std::pair<std::string, bool>>
+resolve_include(std::string_view name, const std::string &from,
+                const std::vector<std::string> &includePath);
+
+// Scans `roots` and the user files they include, transitively. Every file is passed to
+// `visit(path, contents)` and every include to `include(name, resolved_path)`, where the path is
+// empty if it couldn't be resolved. Throws std::system_error if a file can't be read.
+void walk_includes(const std::vector<std::string> &roots,
+                   const std::vector<std::string> &includePath,
+                   const std::function<void(const std::string &, std::string_view)> &visit,
+                   const std::function<void(std::string_view, const std::string &)> &include);
+
+} // namespace LZN
@@ -0,0 +1,115 @@
+#include "mem_stats.hpp"
+#include <sys/resource.h>
+
+#ifdef LZN_MEM_STATS
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<std::uint64_t> allocations{0};
+std::atomic<std::uint64_t> bytes{0};
+std::atomic<std::uint64_t> live{0};
+std::atomic<std::uint64_t> peak{0};
+
+// Each allocation is preceded by its size, so that it can be subtracted when it is deleted.
+constexpr std::size_t HEADER = alignof(std::max_align_t);
+
+void raise_peak(std::uint64_t to) noexcept {
+  std::uint64_t p = peak.load(std::memory_order_relaxed);
+  while (to > p && !peak.compare_exchange_weak(p, to, std::memory_order_relaxed)) {}
+}
+
+void *counted_malloc(std::size_t size) noexcept {
+  void *base = std::malloc(size + HEADER);
+  if (base == nullptr)
+    return nullptr;
+  *static_cast<std::size_t *>(base) = size;
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  bytes.fetch_add(size, std::memory_order_relaxed);
+  raise_peak(live.fetch_add(size, std::memory_order_relaxed) + size);
+  return static_cast<char *>(base) + HEADER;
+}
+
+void *counted_new(std::size_t size) {
+  while (true) {
+    if (void *p = counted_malloc(size))
+      return p;
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+
+void counted_free(void *p) noexcept {
+  if (p == nullptr)
+    return;
+  char *base = static_cast<char *>(p) - HEADER;
+  live.fetch_sub(*reinterpret_cast<std::size_t *>(base), std::memory_order_relaxed);
+  std::free(base);
+}
+} // namespace
+
+// Over-aligned allocations keep the default operators, they aren't counted.
+void *operator new(std::size_t size) { return counted_new(size); }
+void *operator new[](std::size_t size) { return counted_new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return counted_malloc(size);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return counted_malloc(size);
+}
+void operator delete(void *p) noexcept { counted_free(p); }
+void operator delete[](void *p) noexcept { counted_free(p); }
+void operator delete(void *p, std::size_t) noexcept { counted_free(p); }
+void operator delete[](void *p, std::size_t) noexcept { counted_free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { counted_free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { counted_free(p); }
+
+namespace LZN {
+AllocCounters alloc_counters() noexcept {
+  return {allocations.load(std::memory_order_relaxed), bytes.load(std::memory_order_relaxed),
+          live.load(std::memory_order_relaxed)};
+}
+
+std::uint64_t peak_live_bytes() noexcept {
+  return peak.load(std::memory_order_relaxed);
+}
+
+std::uint64_t restart_peak() noexcept {
+  return peak.exchange(live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void restore_peak(std::uint64_t earlier) noexcept {
+  raise_peak(earlier);
+}
+} // namespace LZN
+#else
+namespace LZN {
+AllocCounters alloc_counters() noexcept {
+  return {};
+}
+
+std::uint64_t peak_live_bytes() noexcept {
+  return 0;
+}
+
+std::uint64_t restart_peak() noexcept {
+  return 0;
+}
+
+void restore_peak(std::uint64_t) noexcept {}
+} // namespace LZN
+#endif
+
+namespace LZN {
+long max_rss_kib() noexcept {
+  struct rusage usage {};
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  // Linux reports KiB.
+  return usage.ru_maxrss;
+}
+} // namespace LZN
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+namespace LZN {
+// What was allocated through operator new by the whole process. Only counted in builds with
+// LZN_MEM_STATS, which replace operator new and delete, otherwise everything stays zero.
+struct AllocCounters {
+  std::uint64_t allocations = 0;
+  std::uint64_t bytes = 0; // allocated in total
+  std::uint64_t live = 0;  // allocated and not yet deleted
+};
+
+#ifdef LZN_MEM_STATS
+constexpr bool counts_allocations = true;
+#else
+constexpr bool counts_allocations = false;
+#endif
+
+AllocCounters alloc_counters() noexcept;
+
+// The most bytes that were live at once since the last `restart_peak`.
+std::uint64_t peak_live_bytes() noexcept;
+// Restarts the peak from the bytes that are live now and returns the peak until now. To measure
+// nested spans, each one restarts the peak at its start and hands the returned value to
+// `restore_peak` at its end, so that the enclosing span still sees the peak of the nested one.
+std::uint64_t restart_peak() noexcept;
+void restore_peak(std::uint64_t earlier) noexcept;
+
+// The maximum resident set size of the process so far in KiB, from getrusage, or 0 if unknown.
+long max_rss_kib() noexcept;
+} // namespace LZN
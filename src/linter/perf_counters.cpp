@@ -0,0 +1,76 @@
+#include "perf_counters.hpp"
+#include <algorithm>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+constexpr std::array<std::uint64_t, LZN::PerfCounters::COUNT> CONFIGS = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES};
+
+int open_counter(std::uint64_t config) noexcept {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // Unprivileged processes may only count themselves in user space.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+} // namespace
+
+namespace LZN {
+PerfCounters::PerfCounters() {
+  for (std::size_t i = 0; i < COUNT; ++i) {
+    _fds[i] = open_counter(CONFIGS[i]);
+    if (_fds[i] < 0 && _reason.empty())
+      _reason = std::string(NAMES[i]) + ": " + std::strerror(errno);
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  for (int fd : _fds) {
+    if (fd >= 0)
+      close(fd);
+  }
+}
+
+PerfCounters::Values PerfCounters::read() const noexcept {
+  Values values{};
+  for (std::size_t i = 0; i < COUNT; ++i) {
+    std::uint64_t data[3]; // value, time enabled, time running
+    if (_fds[i] < 0 || ::read(_fds[i], data, sizeof(data)) != sizeof(data))
+      continue;
+    values[i] = data[2] > 0 && data[2] < data[1]
+                    ? static_cast<std::uint64_t>(static_cast<double>(data[0]) * data[1] / data[2])
+                    : data[0];
+  }
+  return values;
+}
+} // namespace LZN
+#else
+namespace LZN {
+PerfCounters::PerfCounters() : _reason("hardware counters are only read on Linux") {
+  _fds.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+PerfCounters::Values PerfCounters::read() const noexcept {
+  return {};
+}
+} // namespace LZN
+#endif
+
+namespace LZN {
+bool PerfCounters::any_available() const noexcept {
+  return std::any_of(_fds.begin(), _fds.end(), [](int fd) { return fd >= 0; });
+}
+} // namespace LZN
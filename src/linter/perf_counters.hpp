@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace LZN {
+// Hardware counters of the calling thread, from perf_event_open on Linux, for `--perf-counters`.
+// Counters that can't be opened, e.g. in containers or on other systems, are unavailable and read
+// as zero.
+class PerfCounters {
+public:
+  enum Counter { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, COUNT };
+  static constexpr std::array<const char *, COUNT> NAMES = {"cycles", "instructions",
+                                                            "cache-misses", "branch-misses"};
+
+  using Values = std::array<std::uint64_t, COUNT>;
+
+  PerfCounters();
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+  ~PerfCounters();
+
+  bool available(Counter c) const noexcept { return _fds[c] >= 0; }
+  bool any_available() const noexcept;
+  // Why the first counter that isn't available couldn't be opened, empty if all are available.
+  const std::string &unavailable_reason() const noexcept { return _reason; }
+
+  // The counts since the counters were opened, scaled up if the kernel had to multiplex them.
+  Values read() const noexcept;
+
+private:
+  std::array<int, COUNT> _fds;
+  std::string _reason;
+};
+} // namespace LZN
@@ -0,0 +1,127 @@
+#include "result_cache.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <linter/binary_io.hpp>
+#include <linter/file_utils.hpp>
+#include <linter/hashing.hpp>
+#include <linter/lexer.hpp>
+#include <linter/result_io.hpp>
+#include <sys/stat.h>
+#include <system_error>
+
+namespace {
+using namespace LZN;
+namespace fs = std::filesystem;
+
+constexpr char MAGIC[8] = {'L', 'Z', 'N', 'R', 'E', 'S', '\0', '\0'};
+
+// Hashes the size and modification time of a file. Cheaper than hashing its contents, for files
+// that only change when something is installed.
+void add_stat(Hasher &h, const std::string &path) {
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0) {
+    h.add(std::uint8_t{0});
+    return;
+  }
+  h.add(static_cast<std::uint64_t>(st.st_size))
+      .add(static_cast<std::int64_t>(st.st_mtim.tv_sec))
+      .add(static_cast<std::int64_t>(st.st_mtim.tv_nsec));
+}
+
+// Hashes every file of the standard library by name, size and modification time. Reading all of
+// their contents would cost more than a cache hit saves.
+void add_stdlib(Hasher &h, const std::vector<std::string> &includePath) {
+  for (const auto &dir : includePath) {
+    h.add_string(dir);
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(dir, ec); !ec && it != fs::end(it);
+         it.increment(ec)) {
+      if (it->is_regular_file(ec))
+        files.push_back(it->path().string());
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto &f : files) {
+      h.add_string(f);
+      add_stat(h, f);
+    }
+  }
+}
+
+} // namespace
+
+namespace LZN {
+std::uint64_t ResultCache::key(const std::string &model_filename,
+                               const std::vector<std::string> &datafiles,
+                               const std::vector<std::string> &includePath,
+                               const std::vector<const LintRule *> &rules) const {
+  Hasher h;
+  h.add(VERSION);
+  add_stat(h, "/proc/self/exe");
+  add_stdlib(h, includePath);
+
+  h.add(rules.size());
+  for (const LintRule *rule : rules)
+    h.add(rule->id);
+
+  // The model and data files are kept apart since they are parsed differently.
+  h.add(datafiles.size());
+  std::vector<std::string> roots{model_filename};
+  roots.insert(roots.end(), datafiles.begin(), datafiles.end());
+  walk_includes(
+      roots, includePath,
+      [&h](const std::string &file, std::string_view contents) {
+        h.add_string(file).add(contents.size()).add(contents);
+      },
+      [&h](std::string_view name, const std::string &resolved) {
+        h.add_string(name).add_string(resolved);
+      });
+  return h.value();
+}
+
+std::optional<std::vector<LintResult>> ResultCache::load(std::uint64_t key) const {
+  try {
+    const std::string entry = read_file(entry_path(key));
+    std::string_view in = entry;
+    if (in.substr(0, sizeof(MAGIC)) != std::string_view(MAGIC, sizeof(MAGIC)))
+      return std::nullopt;
+    in.remove_prefix(sizeof(MAGIC));
+    if (take_u32(in) != VERSION || take_u64(in) != key)
+      return std::nullopt;
+    auto results = take_results(in);
+    if (!in.empty())
+      return std::nullopt;
+    return results;
+  } catch (const std::system_error &) {
+  } catch (const std::out_of_range &) {}
+  return std::nullopt;
+}
+
+bool ResultCache::store(std::uint64_t key, const std::vector<LintResult> &results) const {
+  std::string out(MAGIC, sizeof(MAGIC));
+  put_u32(out, VERSION);
+  put_u64(out, key);
+  put_results(out, results);
+  return ensure_directory(_dir + "/results") && write_file_atomically(entry_path(key), out);
+}
+
+std::string ResultCache::entry_path(std::uint64_t key) const {
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+  return _dir + "/results/" + name;
+}
+
+std::vector<std::string> included_user_files(const std::string &filename,
+                                             const std::vector<std::string> &includePath) {
+  std::vector<std::string> files;
+  walk_includes(
+      {filename}, includePath,
+      [&files, &filename](const std::string &file, std::string_view) {
+        if (file != filename)
+          files.push_back(file);
+      },
+      [](std::string_view, const std::string &) {});
+  return files;
+}
+} // namespace LZN
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <linter/rules.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace LZN {
+// A persistent cache of lint results in a directory, shared by all runs and processes that use
+// it. Entries are keyed by a hash of everything that affects the results, so a change to any input
+// makes a new key and stale entries are never read, only left behind.
+class ResultCache {
+  std::string _dir;
+
+public:
+  // Bumped whenever the format of the entries or what goes into the key changes.
+  static constexpr std::uint32_t VERSION = 1;
+
+  explicit ResultCache(std::string dir) : _dir(std::move(dir)) {}
+
+  // The key for linting `model_filename` with `datafiles` and `rules`. It covers the contents of
+  // the model, the data files and every user file they include, transitively, where each include
+  // resolves to, the rules, the standard library in `includePath` and the linter executable.
+  // Throws std::system_error if one of the files can't be read.
+  std::uint64_t key(const std::string &model_filename, const std::vector<std::string> &datafiles,
+                    const std::vector<std::string> &includePath,
+                    const std::vector<const LintRule *> &rules) const;
+
+  // Returns the results stored for `key`, or nullopt if there are none or they can't be read.
+  std::optional<std::vector<LintResult>> load(std::uint64_t key) const;
+  // Stores `results` for `key`. Returns false on failure, the cache is only an optimization.
+  bool store(std::uint64_t key, const std::vector<LintResult> &results) const;
+
+  std::string entry_path(std::uint64_t key) const;
+};
+
+// The files that `filename` includes, transitively, that aren't found in `includePath`. They are
+// found with a lexical scan and resolved like `MiniZinc::parse` does: relative to the including
+// file first, then in `includePath`. Includes that can't be resolved are left out.
+std::vector<std::string> included_user_files(const std::string &filename,
+                                             const std::vector<std::string> &includePath);
+} // namespace LZN
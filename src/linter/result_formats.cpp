@@ -0,0 +1,258 @@
+#include "result_formats.hpp"
+#include <linter/overload.hpp>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <variant>
+
+namespace {
+using namespace LZN;
+
+constexpr const char *SARIF_SCHEMA = "https://json.schemastore.org/sarif-2.1.0.json";
+
+// A file URI for an absolute `path` and a relative reference for any other, which tools resolve
+// against the directory they were run in.
+std::string uri_reference(const std::string &path) {
+  const std::string encoded = percent_encode_path(path);
+  return !path.empty() && path[0] == '/' ? "file://" + encoded : encoded;
+}
+
+const std::string &category_name(Category category) {
+  return CATEGORY_NAMES[static_cast<std::size_t>(category)];
+}
+
+Json rule_to_json(const LintRule &rule) {
+  return Json::Object{
+      {"id", rule.id}, {"name", rule.name}, {"category", category_name(rule.category)}};
+}
+
+// The lines of `content`, or nothing if it has no region or they can't be read.
+std::optional<std::string> snippet(const FileContents &content, CachedFileReader *reader) {
+  if (reader == nullptr || content.filename.empty() || !content.is_valid())
+    return std::nullopt;
+  const auto lines = std::visit(
+      overload{
+          [](const std::monostate &) { return std::pair<unsigned int, unsigned int>(0, 0); },
+          [](const FileContents::OneLineMarked &olm) { return std::pair(olm.line, olm.line); },
+          [](const FileContents::MultiLine &ml) { return std::pair(ml.startline, ml.endline); },
+      },
+      content.region);
+  if (lines.first == 0)
+    return std::nullopt;
+
+  std::string text;
+  try {
+    for (auto [it, last] = reader->read(content.filename, lines.first, lines.second); it != last;
+         ++it) {
+      if (!text.empty())
+        text += '\n';
+      text.append(*it);
+    }
+  } catch (const std::system_error &) {
+    return std::nullopt;
+  }
+  return text;
+}
+
+// The region of `content` with 1-based lines and columns, end columns inclusive. Null if there is
+// none.
+Json region_to_json(const FileContents &content) {
+  return std::visit(overload{
+                        [](const std::monostate &) { return Json(); },
+                        [](const FileContents::OneLineMarked &olm) {
+                          Json region;
+                          region.set("start_line", olm.line)
+                              .set("start_column", olm.startcol)
+                              .set("end_line", olm.line);
+                          if (olm.endcol)
+                            region.set("end_column", *olm.endcol);
+                          return region;
+                        },
+                        [](const FileContents::MultiLine &ml) {
+                          Json region;
+                          region.set("start_line", ml.startline).set("end_line", ml.endline);
+                          return region;
+                        },
+                    },
+                    content.region);
+}
+
+// Sets the file, region and snippet of `content` in `j`.
+void set_location(Json &j, const FileContents &content, CachedFileReader *snippets) {
+  j.set("file", content.filename.empty() ? Json() : Json(content.filename))
+      .set("region", region_to_json(content));
+  if (auto text = snippet(content, snippets))
+    j.set("snippet", std::move(*text));
+}
+
+// The SARIF region of `content`, whose end columns are exclusive. Null if there is none.
+Json sarif_region(const FileContents &content, CachedFileReader *snippets) {
+  Json region = std::visit(overload{
+                               [](const std::monostate &) { return Json(); },
+                               [](const FileContents::OneLineMarked &olm) {
+                                 Json r;
+                                 r.set("startLine", olm.line)
+                                     .set("startColumn", olm.startcol)
+                                     .set("endLine", olm.line);
+                                 if (olm.endcol)
+                                   r.set("endColumn", *olm.endcol + 1);
+                                 return r;
+                               },
+                               [](const FileContents::MultiLine &ml) {
+                                 Json r;
+                                 r.set("startLine", ml.startline).set("endLine", ml.endline);
+                                 return r;
+                               },
+                           },
+                           content.region);
+  if (auto text = snippet(content, snippets))
+    region.set("snippet", Json::Object{{"text", std::move(*text)}});
+  return region;
+}
+
+// A SARIF physical location of `content`, which must name a file.
+Json sarif_physical_location(const FileContents &content, CachedFileReader *snippets) {
+  Json artifact = Json::Object{{"uri", uri_reference(content.filename)}};
+  Json location = Json::Object{{"artifactLocation", std::move(artifact)}};
+  Json region = sarif_region(content, snippets);
+  if (!region.is_null())
+    location.set("region", std::move(region));
+  return location;
+}
+
+Json sarif_result(const LintResult &r, std::size_t rule_index, CachedFileReader *snippets) {
+  Json result = Json::Object{
+      {"ruleId", std::to_string(r.rule->id)},
+      {"ruleIndex", rule_index},
+      {"level", "warning"},
+      {"message", Json::Object{{"text", r.message}}},
+  };
+  const bool located = !r.content.filename.empty();
+  if (located) {
+    result.set("locations",
+               Json::Array{Json::Object{
+                   {"physicalLocation", sarif_physical_location(r.content, snippets)}}});
+  }
+
+  Json related = Json::Array();
+  for (const auto &sub : r.sub_results) {
+    Json location = Json::Object{{"id", related.as_array().size()},
+                                 {"message", Json::Object{{"text", sub.message}}}};
+    if (!sub.content.filename.empty())
+      location.set("physicalLocation", sarif_physical_location(sub.content, snippets));
+    related.push_back(std::move(location));
+  }
+  if (!related.as_array().empty())
+    result.set("relatedLocations", std::move(related));
+
+  // A rewrite replaces the region of the result.
+  Json properties = Json::Object{{"category", category_name(r.rule->category)},
+                                 {"dependsOnInstance", r.depends_on_instance}};
+  if (r.rewrite && located && !std::holds_alternative<std::monostate>(r.content.region)) {
+    Json replacement = Json::Object{{"deletedRegion", sarif_region(r.content, nullptr)},
+                                    {"insertedContent", Json::Object{{"text", *r.rewrite}}}};
+    Json change = Json::Object{
+        {"artifactLocation", Json::Object{{"uri", uri_reference(r.content.filename)}}},
+        {"replacements", Json::Array{std::move(replacement)}}};
+    result.set("fixes", Json::Array{Json::Object{
+                            {"description", Json::Object{{"text", "rewrite"}}},
+                            {"artifactChanges", Json::Array{std::move(change)}}}});
+  } else if (r.rewrite) {
+    properties.set("rewrite", *r.rewrite);
+  }
+  result.set("properties", std::move(properties));
+  return result;
+}
+} // namespace
+
+namespace LZN {
+Json result_to_json(const LintResult &r, CachedFileReader *snippets) {
+  Json j = Json::Object{{"rule", rule_to_json(*r.rule)}};
+  set_location(j, r.content, snippets);
+  j.set("message", r.message)
+      .set("rewrite", r.rewrite ? Json(*r.rewrite) : Json())
+      .set("depends_on_instance", r.depends_on_instance);
+
+  Json subs = Json::Array();
+  for (const auto &sub : r.sub_results) {
+    Json s = Json::Object{{"message", sub.message}};
+    set_location(s, sub.content, snippets);
+    subs.push_back(std::move(s));
+  }
+  j.set("sub_results", std::move(subs));
+  return j;
+}
+
+void json_print(const std::vector<LintResult> &results, std::ostream &os,
+                CachedFileReader *snippets, const std::vector<const LintRule *> &cut_short) {
+  Json all = Json::Array();
+  all.as_array().reserve(results.size());
+  for (const auto &r : results)
+    all.push_back(result_to_json(r, snippets));
+  Json stopped = Json::Array();
+  for (const LintRule *rule : cut_short)
+    stopped.push_back(rule_to_json(*rule));
+  Json j;
+  j.set("results", std::move(all)).set("cut_short", std::move(stopped));
+  j.dump(os);
+  os << '\n';
+}
+
+void sarif_print(const std::vector<LintResult> &results, std::ostream &os,
+                 CachedFileReader *snippets, const std::vector<const LintRule *> &cut_short) {
+  // The rules that were reported or stopped, in the order they first were.
+  std::unordered_map<const LintRule *, std::size_t> rule_index;
+  Json rules = Json::Array();
+  auto index_of = [&](const LintRule *rule) {
+    auto [it, added] = rule_index.emplace(rule, rule_index.size());
+    if (added) {
+      rules.push_back(Json::Object{
+          {"id", std::to_string(rule->id)},
+          {"name", rule->name},
+          {"properties", Json::Object{{"category", category_name(rule->category)}}},
+      });
+    }
+    return it->second;
+  };
+
+  Json sarif_results = Json::Array();
+  for (const auto &r : results)
+    sarif_results.push_back(sarif_result(r, index_of(r.rule), snippets));
+
+  // A rule that was stopped still ran, so the invocation succeeded, but its results are incomplete.
+  Json notifications = Json::Array();
+  for (const LintRule *rule : cut_short) {
+    notifications.push_back(Json::Object{
+        {"level", "warning"},
+        {"message", Json::Object{{"text", std::string("rule ") + rule->name +
+                                              " was stopped early by its budget, its results "
+                                              "are incomplete"}}},
+        {"associatedRule",
+         Json::Object{{"id", std::to_string(rule->id)}, {"index", index_of(rule)}}},
+    });
+  }
+  Json invocation = Json::Object{{"executionSuccessful", true},
+                                 {"toolExecutionNotifications", std::move(notifications)}};
+
+  Json driver = Json::Object{{"name", "lzn"}, {"rules", std::move(rules)}};
+  Json run = Json::Object{{"tool", Json::Object{{"driver", std::move(driver)}}},
+                          {"invocations", Json::Array{std::move(invocation)}},
+                          {"results", std::move(sarif_results)}};
+  Json log = Json::Object{
+      {"$schema", SARIF_SCHEMA}, {"version", "2.1.0"}, {"runs", Json::Array{std::move(run)}}};
+  log.dump(os);
+  os << '\n';
+}
+
+void ndjson_print(const LintResult &r, std::ostream &os, CachedFileReader *snippets) {
+  result_to_json(r, snippets).dump(os);
+  os << '\n' << std::flush;
+}
+
+void ndjson_print_cut_short(const LintRule &rule, std::ostream &os) {
+  Json j = Json::Object{{"cut_short", rule_to_json(rule)}};
+  j.dump(os);
+  os << '\n' << std::flush;
+}
+} // namespace LZN
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <linter/file_utils.hpp>
+#include <linter/json.hpp>
+#include <linter/rules.hpp>
+#include <ostream>
+#include <vector>
+
+namespace LZN {
+// Machine-readable forms of lint results, for tools rather than people. Source files are only
+// read if `snippets` is given, to add the lines of each region to its result.
+
+// `r` as a JSON object: the id, name and category of its rule, its file and region, message,
+// rewrite, whether it depends on the instance and its subresults.
+Json result_to_json(const LintResult &r, CachedFileReader *snippets = nullptr);
+
+// Prints `results` to `os` as one JSON object with an array of results and an array of the rules
+// in `cut_short`, which were stopped early by their budget.
+void json_print(const std::vector<LintResult> &results, std::ostream &os,
+                CachedFileReader *snippets = nullptr,
+                const std::vector<const LintRule *> &cut_short = {});
+
+// Prints `results` to `os` as a SARIF 2.1.0 log, for code scanning tools. Each rule in `cut_short`
+// is reported as a tool execution notification of the invocation.
+void sarif_print(const std::vector<LintResult> &results, std::ostream &os,
+                 CachedFileReader *snippets = nullptr,
+                 const std::vector<const LintRule *> &cut_short = {});
+
+// Prints `r` to `os` as one line of JSON and flushes it, to stream results as they are found.
+void ndjson_print(const LintResult &r, std::ostream &os, CachedFileReader *snippets = nullptr);
+
+// Prints a line of JSON for `rule`, which was stopped early by its budget, as ndjson_print does.
+void ndjson_print_cut_short(const LintRule &rule, std::ostream &os);
+} // namespace LZN
@@ -0,0 +1,141 @@
+#include "result_io.hpp"
+#include <algorithm>
+#include <linter/binary_io.hpp>
+#include <linter/overload.hpp>
+#include <linter/registry.hpp>
+#include <set>
+
+namespace {
+using namespace LZN;
+
+constexpr char SHARD_MAGIC[8] = {'L', 'Z', 'N', 'S', 'H', 'R', 'D', '\0'};
+// Bumped whenever the format of shards or of the results in them changes.
+constexpr std::uint32_t SHARD_VERSION = 1;
+
+enum RegionTag : std::uint32_t { NONE, ONE_LINE, ONE_LINE_TO_END, MULTI_LINE };
+
+void put_contents(std::string &out, const FileContents &content) {
+  put_string(out, content.filename);
+  std::visit(overload{
+                 [&out](const std::monostate &) { put_u32(out, NONE); },
+                 [&out](const FileContents::OneLineMarked &olm) {
+                   put_u32(out, olm.endcol ? ONE_LINE : ONE_LINE_TO_END);
+                   put_u32(out, olm.line);
+                   put_u32(out, olm.startcol);
+                   if (olm.endcol)
+                     put_u32(out, *olm.endcol);
+                 },
+                 [&out](const FileContents::MultiLine &ml) {
+                   put_u32(out, MULTI_LINE);
+                   put_u32(out, ml.startline);
+                   put_u32(out, ml.endline);
+                 },
+             },
+             content.region);
+}
+
+FileContents::Region take_region(std::string_view &in) {
+  switch (take_u32(in)) {
+  case NONE: return std::monostate();
+  case ONE_LINE: {
+    const unsigned int line = take_u32(in);
+    const unsigned int startcol = take_u32(in);
+    return FileContents::OneLineMarked(line, startcol, take_u32(in));
+  }
+  case ONE_LINE_TO_END: {
+    const unsigned int line = take_u32(in);
+    return FileContents::OneLineMarked(line, take_u32(in));
+  }
+  case MULTI_LINE: {
+    const unsigned int startline = take_u32(in);
+    return FileContents::MultiLine(startline, take_u32(in));
+  }
+  default: throw std::out_of_range("invalid region");
+  }
+}
+} // namespace
+
+namespace LZN {
+void put_results(std::string &out, const std::vector<LintResult> &results) {
+  put_u32(out, static_cast<std::uint32_t>(results.size()));
+  for (const auto &r : results) {
+    put_u32(out, static_cast<std::uint32_t>(r.rule->id));
+    put_string(out, r.message);
+    put_contents(out, r.content);
+    put_u32(out, r.rewrite ? 1 : 0);
+    if (r.rewrite)
+      put_string(out, *r.rewrite);
+    put_u32(out, static_cast<std::uint32_t>(r.sub_results.size()));
+    for (const auto &sub : r.sub_results) {
+      put_string(out, sub.message);
+      put_contents(out, sub.content);
+    }
+    put_u32(out, r.depends_on_instance ? 1 : 0);
+  }
+}
+
+std::vector<LintResult> take_results(std::string_view &in) {
+  std::vector<LintResult> results;
+  for (std::uint32_t n = take_u32(in); n > 0; --n) {
+    // Registry::get throws std::out_of_range for unknown rules.
+    const LintRule *rule = Registry::get(static_cast<lintId>(take_u32(in)));
+    std::string message = take_string(in);
+    std::string filename = take_string(in);
+    LintResult &r =
+        results.emplace_back(take_region(in), filename.c_str(), rule, std::move(message));
+    if (take_u32(in) != 0)
+      r.rewrite = take_string(in);
+    for (std::uint32_t subs = take_u32(in); subs > 0; --subs) {
+      std::string sub_message = take_string(in);
+      std::string sub_filename = take_string(in);
+      r.emplace_subresult(std::move(sub_message), take_region(in), sub_filename.c_str());
+    }
+    r.depends_on_instance = take_u32(in) != 0;
+  }
+  return results;
+}
+
+std::string put_shard(const ShardResults &shard) {
+  std::string out(SHARD_MAGIC, sizeof(SHARD_MAGIC));
+  put_u32(out, SHARD_VERSION);
+  put_u32(out, shard.index);
+  put_u32(out, shard.count);
+  put_u32(out, static_cast<std::uint32_t>(shard.failed.size()));
+  for (const auto &model : shard.failed)
+    put_string(out, model);
+  put_results(out, shard.results);
+  return out;
+}
+
+ShardResults take_shard(std::string_view in) {
+  if (in.substr(0, sizeof(SHARD_MAGIC)) != std::string_view(SHARD_MAGIC, sizeof(SHARD_MAGIC)))
+    throw std::out_of_range("not a shard");
+  in.remove_prefix(sizeof(SHARD_MAGIC));
+  if (take_u32(in) != SHARD_VERSION)
+    throw std::out_of_range("shard of another version");
+  ShardResults shard;
+  shard.index = take_u32(in);
+  shard.count = take_u32(in);
+  for (std::uint32_t n = take_u32(in); n > 0; --n)
+    shard.failed.push_back(take_string(in));
+  shard.results = take_results(in);
+  if (!in.empty())
+    throw std::out_of_range("trailing bytes after shard");
+  return shard;
+}
+
+std::vector<LintResult> merge_shards(std::vector<ShardResults> shards) {
+  std::vector<LintResult> results;
+  std::set<ResultKey> seen;
+  for (auto &shard : shards) {
+    for (auto &r : shard.results) {
+      if (seen.insert(key_of(r)).second)
+        results.push_back(std::move(r));
+    }
+  }
+  // Results of the same rule at the same place, but with different messages, stay in the order
+  // of the shards.
+  std::stable_sort(results.begin(), results.end());
+  return results;
+}
+} // namespace LZN
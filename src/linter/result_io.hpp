@@ -0,0 +1,44 @@
+#pragma once
+
+#include <linter/rules.hpp>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace LZN {
+// A compact binary form of lint results, for storing them between runs or sending them between
+// processes. Rules are stored by id and looked up in the Registry when the results are read back,
+// so the results must be read by the same build of the linter that wrote them.
+void put_results(std::string &out, const std::vector<LintResult> &results);
+
+// Reads results written by `put_results` from the start of `in` and removes them from it. Throws
+// std::out_of_range if `in` is truncated or refers to a rule that doesn't exist.
+std::vector<LintResult> take_results(std::string_view &in);
+
+// The results of one of `count` shards of a run over many models, each shard linting every
+// `count`-th model on a machine of its own. `index` is 1-based.
+struct ShardResults {
+  unsigned int index = 1;
+  unsigned int count = 1;
+  std::vector<std::string> failed; // the models that couldn't be linted
+  std::vector<LintResult> results;
+};
+
+// Serializes `shard` for put_results, with a header that identifies the format. Shards must be
+// read back by the same build of the linter, on a machine with the same byte order.
+std::string put_shard(const ShardResults &shard);
+
+// Reads a shard written by `put_shard`. Throws std::out_of_range if `in` isn't one.
+ShardResults take_shard(std::string_view in);
+
+// The results of all `shards`, sorted and with every result only once.
+std::vector<LintResult> merge_shards(std::vector<ShardResults> shards);
+
+// Identifies a result across runs that found it separately, e.g. for different instances.
+using ResultKey = std::tuple<lintId, FileContents, std::string>;
+
+inline ResultKey key_of(const LintResult &r) {
+  return {r.rule->id, r.content, r.message};
+}
+} // namespace LZN
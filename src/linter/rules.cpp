@@ -6,17 +6,16 @@
 #include <minizinc/hash.hh>
 #include <minizinc/prettyprinter.hh>
 
-namespace {
+namespace LZN {
 template <typename T, typename F>
-const T &lazy_value(std::optional<T> &opt, F f) {
+const T &LintEnv::lazy_value(std::optional<T> &opt, const char *name, F f) {
   if (!opt) {
+    Timings::Scope scope(_timings, Timings::Kind::CACHE, name, _rule ? _rule->name : "");
     opt = f();
   }
   return *opt;
 }
-} // namespace
 
-namespace LZN {
 std::ostream &operator<<(std::ostream &os, const LintResult &value) {
   os << "(" << value.rule->name << ")";
   std::visit(overload{[&](const std::monostate &) { os << "None"; },
@@ -78,10 +77,11 @@ bool FileContents::is_valid() const noexcept {
 
 void LintEnv::add_result(LintResult lr) {
   _results.push_back(std::move(lr));
+  count_result();
 }
 
 const LintEnv::ECMap &LintEnv::equal_constrained() {
-  return lazy_value(_equal_constrained, [this]() {
+  return lazy_value(_equal_constrained, "equal_constrained", [this]() {
     LintEnv::ECMap ids;
     for (auto con : constraints()) {
       equal_constrained_variables(con, [&ids](const MiniZinc::BinOp *eq, const MiniZinc::Id *id) {
@@ -96,8 +96,8 @@ const LintEnv::ECMap &LintEnv::equal_constrained() {
 
 const LintEnv::VDVec &LintEnv::user_defined_variable_declarations() {
   using ExpressionId = MiniZinc::Expression::ExpressionId;
-  return lazy_value(_vardecls, [this, model = _model]() {
-    const auto s = userdef_only_builder()
+  return lazy_value(_vardecls, "user_defined_variable_declarations", [this, model = _model]() {
+    const auto s = cached_search_builder()
                        .in_vardecl()
                        .in_assign_rhs()
                        .in_constraint()
@@ -135,7 +135,7 @@ const LintEnv::VDVec &LintEnv::user_defined_variable_declarations() {
 }
 
 const LintEnv::AECMap &LintEnv::array_equal_constrained() {
-  return lazy_value(_array_equal_constrained, [this]() {
+  return lazy_value(_array_equal_constrained, "array_equal_constrained", [this]() {
     LintEnv::AECMap map;
 
     for (auto con : constraints()) {
@@ -154,8 +154,8 @@ const LintEnv::AECMap &LintEnv::array_equal_constrained() {
 }
 
 const LintEnv::UDFVec &LintEnv::user_defined_functions() {
-  return lazy_value(_user_defined_funcs, [this, model = _model]() {
-    const auto s = userdef_only_builder().in_function().build();
+  return lazy_value(_user_defined_funcs, "user_defined_functions", [this, model = _model]() {
+    const auto s = cached_search_builder().in_function().build();
     auto ms = s.search(model);
     LintEnv::UDFVec vec;
     while (ms.next()) {
@@ -176,24 +176,25 @@ const LintEnv::UDFVec &LintEnv::user_defined_functions() {
 
 const MiniZinc::SolveI *LintEnv::solve_item() {
   // TODO: why this instead of MiniZinc::Model::solveItem?
-  return lazy_value(_solve_item, [this, model = _model]() -> const MiniZinc::SolveI * {
-    const auto s = userdef_only_builder().in_solve().build();
-    auto ms = s.search(model);
-    while (ms.next()) {
-      return ms.cur_item()->cast<MiniZinc::SolveI>();
-    }
-    return nullptr;
-  });
+  return lazy_value(_solve_item, "solve_item",
+                    [this, model = _model]() -> const MiniZinc::SolveI * {
+                      const auto s = cached_search_builder().in_solve().build();
+                      auto ms = s.search(model);
+                      while (ms.next()) {
+                        return ms.cur_item()->cast<MiniZinc::SolveI>();
+                      }
+                      return nullptr;
+                    });
 }
 
 const LintEnv::VDSet &LintEnv::search_hinted_variables() {
-  return lazy_value(_search_hinted, [this]() {
+  return lazy_value(_search_hinted, "search_hinted_variables", [this]() {
     LintEnv::VDSet set;
     auto solve = solve_item();
     if (solve == nullptr || solve->ann().isEmpty())
       return set;
 
-    const auto s = userdef_only_builder().under(MiniZinc::Expression::E_ID).capture().build();
+    const auto s = cached_search_builder().under(MiniZinc::Expression::E_ID).capture().build();
 
     for (const auto *e : solve->ann()) {
       auto ms = s.search(e);
@@ -209,11 +210,11 @@ const LintEnv::VDSet &LintEnv::search_hinted_variables() {
 }
 
 const LintEnv::ExprVec &LintEnv::constraints() {
-  return lazy_value(_constraints, [this, model = _model]() {
+  return lazy_value(_constraints, "constraints", [this, model = _model]() {
     LintEnv::ExprVec vec;
 
     { // constraints in let
-      const auto s = userdef_only_builder()
+      const auto s = cached_search_builder()
                          .in_vardecl()
                          .in_assign_rhs()
                          .in_function_body()
@@ -234,7 +235,7 @@ const LintEnv::ExprVec &LintEnv::constraints() {
     }
 
     {
-      const auto s = userdef_only_builder().in_constraint().build();
+      const auto s = cached_search_builder().in_constraint().build();
       auto ms = s.search(model);
       while (ms.next()) {
         auto con = ms.cur_item()->cast<MiniZinc::ConstraintI>();
@@ -247,10 +248,10 @@ const LintEnv::ExprVec &LintEnv::constraints() {
 }
 
 const LintEnv::CSet &LintEnv::comprehensions() {
-  return lazy_value(_comprehensions, [this, model = _model]() {
+  return lazy_value(_comprehensions, "comprehensions", [this, model = _model]() {
     LintEnv::CSet set;
 
-    const auto s = userdef_only_builder()
+    const auto s = cached_search_builder()
                        .in_everywhere()
                        .under(MiniZinc::Expression::E_COMP)
                        .capture()
@@ -302,7 +303,60 @@ bool LintEnv::is_search_hinted(const MiniZinc::VarDecl *vd) {
 }
 
 SearchBuilder LintEnv::userdef_only_builder() const {
-  return SearchBuilder().only_user_defined(_includePath).recursive();
+  return cached_search_builder()
+      .cancel_on(_budget != nullptr ? &_budget->token : nullptr)
+      .trace_items(_timings != nullptr ? _timings->trace() : nullptr);
+}
+
+SearchBuilder LintEnv::cached_search_builder() const {
+  SearchStats *stats = nullptr;
+  if (_search_stats != nullptr)
+    stats = &(*_search_stats)[_rule != nullptr ? _rule->name : ""];
+  return SearchBuilder()
+      .only_user_defined(_includePath)
+      .recursive()
+      .only_items(_item_filter)
+      .skip_files(_opaque_files)
+      .cost_items(_item_costs)
+      .count_into(stats);
+}
+
+void LintEnv::count_result() {
+  if (_budget == nullptr)
+    return;
+  ++_budget->results;
+  if (_budget->max_results && _budget->results >= *_budget->max_results)
+    _budget->token.cancel();
+}
+
+void LintEnv::start_rule(const LintRule &rule) {
+  _rule = &rule;
+  _rule_start = _results.size();
+  if (_timings != nullptr)
+    _rule_stamp = _timings->stamp();
+  if (_budget == nullptr)
+    return;
+  _budget->token.reset(_budget->rule_time);
+  if (_budget->max_results && _budget->results >= *_budget->max_results)
+    _budget->token.cancel();
+}
+
+void LintEnv::finish_rule(const LintRule &rule) {
+  _rule = nullptr;
+  if (_budget != nullptr) {
+    if (_budget->max_results && _budget->results > *_budget->max_results) {
+      const std::size_t excess = std::min(_budget->results - *_budget->max_results,
+                                          _results.size() - _rule_start);
+      _results.erase(_results.end() - static_cast<std::ptrdiff_t>(excess), _results.end());
+      _budget->results -= excess;
+    }
+    if (_budget->token.was_cancelled())
+      _budget->cut_short.push_back(&rule);
+  }
+  if (_timings != nullptr) {
+    Timings::Entry &e = _timings->add(Timings::Kind::RULE, rule.name, _rule_stamp);
+    e.results = e.results.value_or(0) + (_results.size() - _rule_start);
+  }
 }
 
 void LintResult::set_rewrite(const MiniZinc::Expression *expr) {
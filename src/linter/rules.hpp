@@ -1,6 +1,9 @@
 #pragma once
 
+#include <chrono>
+#include <linter/cancellation.hpp>
 #include <linter/searcher.hpp>
+#include <linter/timings.hpp>
 #include <minizinc/model.hh>
 #include <optional>
 #include <string>
@@ -13,6 +16,7 @@ namespace LZN {
 
 // forward declare
 struct LintResult;
+class LintRule;
 
 // type used for the ids of LintRules.
 using lintId = unsigned int;
@@ -30,6 +34,18 @@ enum class Category {
 inline const std::vector<std::string> CATEGORY_NAMES = {"challenge", "style", "unsure",
                                                         "performance", "redundant"};
 
+// Limits on the work of the rules of a run, shared by its LintEnvs. Rules are stopped
+// cooperatively: the searches they get from `userdef_only_builder` end early once a limit is
+// reached, and the rule finishes with the results it found until then.
+struct Budget {
+  std::optional<std::chrono::milliseconds> rule_time; // for each rule, no limit if not given
+  std::optional<std::size_t> max_results;             // for all rules, no limit if not given
+
+  CancellationToken token;                 // of the rule that is running
+  std::size_t results = 0;                 // found by all rules so far
+  std::vector<const LintRule *> cut_short; // the rules that were stopped early, in order
+};
+
 // Environment where rules get their information and where they store their information.
 // Some commonly performed searches are cached here as well.
 class LintEnv {
@@ -81,6 +97,32 @@ class LintEnv {
   using CSet = std::unordered_set<const MiniZinc::Comprehension *>;
   std::optional<CSet> _comprehensions;
 
+  // if not nullptr, searches from `userdef_only_builder` only look in these items
+  const ItemSet *_item_filter = nullptr;
+  // if not nullptr, searches from `userdef_only_builder` skip what comes from these files
+  const std::vector<std::string> *_opaque_files = nullptr;
+
+  // if not nullptr, the limits of each rule that runs, see `start_rule`
+  Budget *_budget = nullptr;
+  // if not nullptr, where the time of each rule and cached search is added
+  Timings *_timings = nullptr;
+  // if not nullptr, where the work of the searches is counted, by the rule that made them
+  SearchStatsByRule *_search_stats = nullptr;
+  // if not nullptr, where the cost of each top-level item is added
+  ItemCosts *_item_costs = nullptr;
+  // the rule that is running, the number of results and the time when it started
+  const LintRule *_rule = nullptr;
+  std::size_t _rule_start = 0;
+  Timings::Stamp _rule_stamp{};
+
+  // the value of a cached search `name`, computed by `f` the first time
+  template <typename T, typename F>
+  const T &lazy_value(std::optional<T> &opt, const char *name, F f);
+
+  // as `userdef_only_builder`, but never cancelled, for searches whose results are cached
+  SearchBuilder cached_search_builder() const;
+  void count_result();
+
 public:
   LintEnv(const MiniZinc::Model *model, MiniZinc::Env &env,
           const std::vector<std::string> &includePath)
@@ -89,7 +131,9 @@ public:
   // Add a LintResult, can be constructed in-place.
   template <typename... Args>
   decltype(_results)::reference emplace_result(Args &&...args) {
-    return _results.emplace_back(std::forward<Args>(args)...);
+    auto &result = _results.emplace_back(std::forward<Args>(args)...);
+    count_result();
+    return result;
   }
   void add_result(LintResult lr);
 
@@ -120,22 +164,88 @@ public:
 
   // return a builder that filters out everything (functions and includes) that is not user defined.
   SearchBuilder userdef_only_builder() const;
+
+  // Restrict the searches of `userdef_only_builder` to `items`, or lift the restriction with
+  // nullptr. Only meant for running item-local rules, the cached searches above are restricted too.
+  void only_items(const ItemSet *items) { _item_filter = items; }
+
+  // Make what comes from `files`, usually the data files, opaque to searches from
+  // `userdef_only_builder`. The declarations they assign still have their right-hand sides, only
+  // searches don't enter them. A rule that wants to search the data calls `skip_files(nullptr)`.
+  void opaque_files(const std::vector<std::string> *files) { _opaque_files = files; }
+
+  // Hold each rule to the limits of `budget`, or lift them with nullptr. The same budget may be
+  // shared by several environments of one run.
+  void budget(Budget *budget) { _budget = budget; }
+
+  // Returns true if the budget stopped the rule that is running. A rule whose results follow from
+  // what its searches didn't find, e.g. declarations without uses, must not report them then.
+  bool cut_short() const noexcept { return _budget != nullptr && _budget->token.was_cancelled(); }
+
+  // Add the time of each rule, with its number of results, and of each cached search to
+  // `timings`, or stop measuring with nullptr. A cached search is attributed to the rule that
+  // first used it. If the timings are traced, so is each top-level item that the searches from
+  // `userdef_only_builder` enter.
+  void timings(Timings *timings) { _timings = timings; }
+
+  // Count the work of the searches of each rule in `stats`, or stop counting with nullptr. As with
+  // the timings, a cached search is counted for the rule that first used it. Only counted in
+  // builds with LZN_SEARCH_STATS.
+  void search_stats(SearchStatsByRule *stats) { _search_stats = stats; }
+
+  // Add the time that searches, including the cached ones, spend in each top-level item to
+  // `costs`, or stop with nullptr.
+  void item_costs(ItemCosts *costs) { _item_costs = costs; }
+
+  // Called by LintRule::run around each rule. Once the budget is exhausted, searches from
+  // `userdef_only_builder` end early. Results above the limit are dropped when the rule finishes
+  // and a rule that was stopped is added to the budget's `cut_short`.
+  void start_rule(const LintRule &rule);
+  void finish_rule(const LintRule &rule);
+};
+
+// What a rule needs to look at to produce its results.
+enum class Scope {
+  MODEL, // Anything in the model.
+  ITEM,  // Each result only depends on the top-level item it is in, including the types of its
+         // expressions. Such rules may be run on a subset of the items.
+};
+
+// Whether a rule looks at what the data files of an instance assign.
+enum class Data {
+  USED,   // The results may differ between instances, e.g. if a variable is assigned by the data.
+  UNUSED, // The results are the same for every instance, they may be found without any data.
+};
+
+// Whether a rule looks at what typechecking adds to a model: types, the declarations of
+// identifiers and introduced items.
+enum class Types {
+  USED,   // The rule must run on a typechecked model.
+  UNUSED, // The rule may run on a model that is only parsed, with the same results.
 };
 
 // A lint rule. Contains necessary metadata and a function to perform analysis.
 class LintRule {
 protected:
-  constexpr LintRule(lintId id, const char *name, Category cat)
-      : id(id), name(name), category(cat) {}
+  constexpr LintRule(lintId id, const char *name, Category cat, Scope scope = Scope::MODEL,
+                     Data data = Data::USED, Types types = Types::USED)
+      : id(id), name(name), category(cat), scope(scope), data(data), types(types) {}
   ~LintRule() = default;
 
 public:
   const lintId id;         // an id that must be unique
   const char *const name;  // a unique printable name
   const Category category; // a category a rule fits in to
+  const Scope scope;       // what the rule looks at
+  const Data data;         // whether the rule looks at the data
+  const Types types;       // whether the rule looks at types
 
   // Perform the analysis
-  void run(LintEnv &env) const { do_run(env); }
+  void run(LintEnv &env) const {
+    env.start_rule(*this);
+    do_run(env);
+    env.finish_rule(*this);
+  }
 
 private:
   virtual void do_run(LintEnv &env) const = 0;
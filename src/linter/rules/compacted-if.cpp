@@ -7,7 +7,8 @@ using namespace LZN;
 
 class CompactedIf : public LintRule {
 public:
-  constexpr CompactedIf() : LintRule(20, "compacted-if", Category::PERFORMANCE) {}
+  constexpr CompactedIf()
+      : LintRule(20, "compacted-if", Category::PERFORMANCE, Scope::ITEM, Data::UNUSED) {}
 
 private:
   using ExpressionId = MiniZinc::Expression::ExpressionId;
@@ -6,7 +6,9 @@ using namespace LZN;
 
 class ElementPredicate : public LintRule {
 public:
-  constexpr ElementPredicate() : LintRule(15, "element-predicate", Category::STYLE) {}
+  constexpr ElementPredicate()
+      : LintRule(15, "element-predicate", Category::STYLE, Scope::ITEM, Data::UNUSED,
+                 Types::UNUSED) {}
 
 private:
   using ExpressionId = MiniZinc::Expression::ExpressionId;
@@ -32,6 +32,9 @@ private:
     }
 
     equal_constrained_functions(env, non_func);
+    // Calls that a stopped search didn't get to would leave functionally defined variables here.
+    if (env.cut_short())
+      return;
 
     for (auto vd : non_func) {
       const auto &loc = vd->loc();
@@ -11,7 +11,8 @@ using namespace LZN;
 
 class GlobalConstraintReified : public LintRule {
 public:
-  constexpr GlobalConstraintReified() : LintRule(17, "global-reified", Category::UNSURE) {}
+  constexpr GlobalConstraintReified()
+      : LintRule(17, "global-reified", Category::UNSURE, Scope::MODEL, Data::UNUSED) {}
 
 private:
   using ExpressionId = MiniZinc::Expression::ExpressionId;
@@ -6,7 +6,8 @@ using namespace LZN;
 
 class GlobalsInFunction : public LintRule {
 public:
-  constexpr GlobalsInFunction() : LintRule(5, "globals-in-function", Category::STYLE) {}
+  constexpr GlobalsInFunction()
+      : LintRule(5, "globals-in-function", Category::STYLE, Scope::MODEL, Data::UNUSED) {}
 
 private:
   using ExpressionId = MiniZinc::Expression::ExpressionId;
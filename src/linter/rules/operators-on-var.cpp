@@ -8,7 +8,8 @@ using namespace LZN;
 
 class OperatorsOnVar : public LintRule {
 public:
-  constexpr OperatorsOnVar() : LintRule(18, "operator-on-var", Category::UNSURE) {}
+  constexpr OperatorsOnVar()
+      : LintRule(18, "operator-on-var", Category::UNSURE, Scope::ITEM, Data::UNUSED) {}
 
 private:
   using ExpressionId = MiniZinc::Expression::ExpressionId;
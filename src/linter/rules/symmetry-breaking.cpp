@@ -7,7 +7,9 @@ using namespace LZN;
 
 class SymmetryBreaking : public LintRule {
 public:
-  constexpr SymmetryBreaking() : LintRule(6, "symmetry-breaking", Category::UNSURE) {}
+  constexpr SymmetryBreaking()
+      : LintRule(6, "symmetry-breaking", Category::UNSURE, Scope::MODEL, Data::UNUSED,
+                 Types::UNUSED) {}
 
 private:
   using ExpressionId = MiniZinc::Expression::ExpressionId;
@@ -211,7 +211,12 @@ private:
         find_uses_searcher(env, EID::E_CALL),
     };
 
-    for (auto unused : find_unused(env, sear)) {
+    const ThingSet unused_things = find_unused(env, sear);
+    // Uses that a stopped search didn't get to would look like unused declarations.
+    if (env.cut_short())
+      return;
+
+    for (auto unused : unused_things) {
       if (std::holds_alternative<const MiniZinc::FunctionI *>(unused)) {
         auto fi = std::get<const MiniZinc::FunctionI *>(unused);
         auto &loc = fi->loc();
@@ -7,7 +7,8 @@ using namespace LZN;
 
 class VarInGen : public LintRule {
 public:
-  constexpr VarInGen() : LintRule(7, "var-in-gen", Category::UNSURE) {}
+  constexpr VarInGen()
+      : LintRule(7, "var-in-gen", Category::UNSURE, Scope::ITEM, Data::UNUSED) {}
 
 private:
   virtual void do_run(LintEnv &env) const override {
@@ -7,7 +7,8 @@ using namespace LZN;
 
 class VarInIfWhere : public LintRule {
 public:
-  constexpr VarInIfWhere() : LintRule(26, "var-in-if-where", Category::UNSURE) {}
+  constexpr VarInIfWhere()
+      : LintRule(26, "var-in-if-where", Category::UNSURE, Scope::ITEM, Data::UNUSED) {}
 
 private:
   virtual void do_run(LintEnv &env) const override {
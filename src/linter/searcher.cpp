@@ -1,9 +1,18 @@
 #include "searcher.hpp"
 #include <algorithm>
 #include <linter/file_utils.hpp>
+#include <linter/item_costs.hpp>
 #include <minizinc/astiterator.hh>
 #include <minizinc/model.hh>
 
+// Adds `n` to a counter of `stats` if it isn't nullptr, in builds with LZN_SEARCH_STATS only.
+#ifdef LZN_SEARCH_STATS
+#define LZN_COUNT(stats, counter, n)                                                              \
+  ((stats) != nullptr ? static_cast<void>((stats)->counter += (n)) : static_cast<void>(0))
+#else
+#define LZN_COUNT(stats, counter, n) static_cast<void>(0)
+#endif
+
 namespace {
 using namespace LZN;
 
@@ -33,10 +42,44 @@ std::size_t children_of(const MiniZinc::Expression *root,
   MiniZinc::top_down(childExtractor, const_cast<MiniZinc::Expression *>(root));
   return childExtractor.new_children;
 }
+
+// Returns true if `loc` is in one of `files`.
+bool is_from(const std::vector<std::string> &files, const MiniZinc::Location &loc) {
+  if (files.empty())
+    return false;
+  const MiniZinc::ASTString filename = loc.filename();
+  if (filename.size() == 0)
+    return false;
+  const std::string_view name(filename.c_str(), filename.size());
+  return std::any_of(files.begin(), files.end(),
+                     [name](const std::string &f) { return f == name; });
+}
 } // namespace
 
 namespace LZN::Impl {
 
+void ItemSpan::enter(const MiniZinc::Item *item, std::uint64_t queued) {
+  leave(queued);
+  if (_trace == nullptr && _costs == nullptr)
+    return;
+  _item = item;
+  _queued = queued;
+  if (_trace != nullptr)
+    _start = Trace::Clock::now();
+  if (_costs != nullptr)
+    _costs->enter(item);
+}
+
+void ItemSpan::leave(std::uint64_t queued) {
+  if (_item == nullptr)
+    return;
+  if (_costs != nullptr)
+    _costs->leave(_item, queued - _queued);
+  if (_trace != nullptr)
+    _trace->add(item_label(_item), "item", _start);
+  _item = nullptr;
+}
+
 bool SearchLocs::should_visit(const MiniZinc::Item *i) const {
   assert(i != nullptr);
   using I = MiniZinc::Item;
@@ -79,12 +122,17 @@ bool SearchNode::run_filter(const MiniZinc::Expression *p,
 
 bool ExprSearcher::next() {
   while (!dfs_stack.empty()) {
+    if (cancellation != nullptr && cancellation->cancelled()) {
+      abort();
+      return false;
+    }
     const MiniZinc::Expression *cur = dfs_stack.back();
     dfs_stack.pop_back();
 
     if (!path.empty() && path.back() == cur) {
       path.pop_back();
       if (!hits.empty() && hits.back() == cur) {
+        LZN_COUNT(stats, backtracks, 1);
         hits.pop_back();
         --nodes_pos;
         if (nodes.at(nodes_pos).is_under()) {
@@ -98,6 +146,7 @@ bool ExprSearcher::next() {
 
     const SearchNode &tar = nodes.at(nodes_pos);
     if (tar.match(cur)) {
+      LZN_COUNT(stats, matches, 1);
       hits.push_back(cur);
       ++nodes_pos;
     } else {
@@ -124,6 +173,9 @@ ExprSearcher::PathIters ExprSearcher::current_path() const {
 
 void ExprSearcher::queue_children_of(const MiniZinc::Expression *cur) {
   auto filter = [this, cur](const MiniZinc::Expression *root, const MiniZinc::Expression *child) {
+    if (skipped_files != nullptr && is_from(*skipped_files, child->loc()))
+      return false;
+
     if (global_filters != nullptr) {
       if (!std::all_of(global_filters->begin(), global_filters->end(),
                        [=](ExprFilterFun f) { return f(root, child); }))
@@ -138,7 +190,7 @@ void ExprSearcher::queue_children_of(const MiniZinc::Expression *cur) {
   };
 
   std::size_t size_before = dfs_stack.size();
-  children_of(cur, dfs_stack);
+  [[maybe_unused]] const std::size_t extracted = children_of(cur, dfs_stack);
   auto beg = dfs_stack.begin() + size_before;
   const auto end = dfs_stack.end();
   dfs_stack.erase(std::remove_if(beg, end,
@@ -146,6 +198,10 @@ void ExprSearcher::queue_children_of(const MiniZinc::Expression *cur) {
                                    return !filter(cur, child);
                                  }),
                   end);
+  queued += dfs_stack.size() - size_before;
+  LZN_COUNT(stats, nodes_expanded, 1);
+  LZN_COUNT(stats, filter_calls, extracted);
+  LZN_COUNT(stats, children_queued, dfs_stack.size() - size_before);
 }
 
 const MiniZinc::Expression *ExprSearcher::capture(std::size_t n) const {
@@ -271,9 +327,12 @@ bool ModelSearcher::next_starting_point() {
 }
 
 bool ModelSearcher::next_item() {
+  [[maybe_unused]] SearchStats *stats = search.counters();
+  item_span.leave(queued_nodes());
   advance_iters();
   item_child = 0;
-  for (; !iters.empty(); advance_iters(), item_child = 0) {
+  // Only an item that isn't returned gets to the increment, so it is counted as skipped there.
+  for (; !iters.empty(); LZN_COUNT(stats, items_skipped, 1), advance_iters(), item_child = 0) {
     const MiniZinc::Item *cur = iters_top();
 
     if (search.is_user_defined_only()) {
@@ -298,8 +357,16 @@ bool ModelSearcher::next_item() {
       iters_push(inc->m());
     }
 
-    if (search.locations.should_visit(cur))
+    if (search.onlyItems != nullptr && search.onlyItems->count(cur) == 0)
+      continue;
+
+    if (search.skippedFiles != nullptr && is_from(*search.skippedFiles, cur->loc()))
+      continue;
+
+    if (search.locations.should_visit(cur)) {
+      item_span.enter(cur, queued_nodes());
       return true;
+    }
   }
   return false;
 }
@@ -335,15 +402,26 @@ void ModelSearcher::iters_push(const MiniZinc::Model *m) {
   iters_pushed = true;
 }
 
+ModelSearcher::~ModelSearcher() {
+  item_span.leave(queued_nodes());
+}
+
+std::uint64_t ModelSearcher::queued_nodes() const noexcept {
+  return expr_searcher ? expr_searcher->queued_nodes() : 0;
+}
+
 ExprSearcher::PathIters ModelSearcher::current_path() const {
   assert(expr_searcher);
   return expr_searcher.value().current_path();
 }
 
 ModelSearcher::ModelSearcher(const MiniZinc::Model *m, const Search &search)
-    : model(m), search(search), iters_pushed(false), item_child(0) {
+    : model(m), search(search), iters_pushed(false), item_child(0),
+      item_span(search.trace, search.itemCosts) {
   if (!search.nodes.empty()) {
-    expr_searcher.emplace(search.nodes, &search.global_filters);
+    expr_searcher.emplace(search.nodes, &search.global_filters, search.skippedFiles,
+                          search.cancellation);
+    expr_searcher->count_into(search.counters());
   }
   iters_push(m);
 }
@@ -352,6 +430,17 @@ ModelSearcher::ModelSearcher(const MiniZinc::Model *m, const Search &search)
 
 namespace LZN {
 
+SearchStats &SearchStats::operator+=(const SearchStats &other) noexcept {
+  searches += other.searches;
+  nodes_expanded += other.nodes_expanded;
+  children_queued += other.children_queued;
+  filter_calls += other.filter_calls;
+  matches += other.matches;
+  backtracks += other.backtracks;
+  items_skipped += other.items_skipped;
+  return *this;
+}
+
 bool Search::is_user_defined_include(const MiniZinc::IncludeI *incl) const noexcept {
   assert(incl != nullptr);
   if (includePath == nullptr)
@@ -369,6 +458,15 @@ bool Search::ModelSearcher::next() {
   if (iters.empty())
     return false;
 
+  if (search.cancellation != nullptr && search.cancellation->cancelled()) {
+    // Stay finished, whatever is asked next.
+    iters = {};
+    item_span.leave(queued_nodes());
+    if (expr_searcher)
+      expr_searcher->abort();
+    return false;
+  }
+
   if (is_items_only()) {
     return next_item();
   }
@@ -393,6 +491,7 @@ bool Search::ModelSearcher::next() {
 void Search::ModelSearcher::skip_item() {
   if (!is_items_only()) {
     assert(expr_searcher);
+    LZN_COUNT(search.counters(), items_skipped, 1);
     expr_searcher->abort();
     next_item();
   }
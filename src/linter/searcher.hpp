@@ -1,12 +1,22 @@
 #pragma once
+#include <cstdint>
+#include <linter/cancellation.hpp>
+#include <linter/trace.hpp>
+#include <map>
 #include <minizinc/ast.hh>
 #include <minizinc/model.hh>
 #include <optional>
 #include <stack>
+#include <string>
+#include <unordered_set>
+#include <utility>
 #include <variant>
 
 namespace LZN {
 
+// A set of top-level items.
+using ItemSet = std::unordered_set<const MiniZinc::Item *>;
+
 // function type for filters.
 using ExprFilterFun = bool (*)(const MiniZinc::Expression *root, const MiniZinc::Expression *child);
 
@@ -20,6 +30,24 @@ bool filter_global_comprehension_body(const MiniZinc::Expression *root,
 
 // forward reference
 class Search;
+class ItemCosts;
+
+// The work done by searches, see `SearchBuilder::count_into`. Only counted in builds with
+// LZN_SEARCH_STATS, otherwise the counters stay zero and counting costs nothing.
+struct SearchStats {
+  std::uint64_t searches = 0;        // Search objects whose counts were added
+  std::uint64_t nodes_expanded = 0;  // expressions whose children were queued
+  std::uint64_t children_queued = 0; // children queued after filtering
+  std::uint64_t filter_calls = 0;    // children run through the filters
+  std::uint64_t matches = 0;         // expressions that matched the next node of the path
+  std::uint64_t backtracks = 0;      // matches given up to look for further hits
+  std::uint64_t items_skipped = 0;   // top-level items passed over by ModelSearcher
+
+  SearchStats &operator+=(const SearchStats &other) noexcept;
+};
+
+// The work of the searches of each rule, by its name.
+using SearchStatsByRule = std::map<std::string, SearchStats>;
 
 } // namespace LZN
 
@@ -34,6 +62,66 @@ struct SearchLocs {
   bool any() const;
 };
 
+// The counts of one Search, added to a sink when the search is destroyed. A moved search hands
+// its counts over, a copied one starts from zero.
+class StatsAccount {
+  SearchStats _stats;
+  SearchStats *_sink;
+
+public:
+  explicit StatsAccount(SearchStats *sink) noexcept : _sink(sink) {}
+  StatsAccount(const StatsAccount &other) noexcept : _sink(other._sink) {}
+  StatsAccount(StatsAccount &&other) noexcept
+      : _stats(other._stats), _sink(std::exchange(other._sink, nullptr)) {}
+  StatsAccount &operator=(const StatsAccount &other) noexcept {
+    settle();
+    _stats = SearchStats();
+    _sink = other._sink;
+    return *this;
+  }
+  StatsAccount &operator=(StatsAccount &&other) noexcept {
+    settle();
+    _stats = other._stats;
+    _sink = std::exchange(other._sink, nullptr);
+    return *this;
+  }
+  ~StatsAccount() { settle(); }
+
+  SearchStats &stats() noexcept { return _stats; }
+
+private:
+  void settle() noexcept {
+    if (_sink == nullptr)
+      return;
+    *_sink += _stats;
+    ++_sink->searches;
+  }
+};
+
+// The top-level item a ModelSearcher is in, from when the searcher enters it until it leaves it.
+// The span is added to a Trace and its cost to ItemCosts, if they are given. The cost includes
+// the expressions queued in the item, which the searcher tells from its running count `queued`.
+// A moved searcher hands the item over.
+class ItemSpan {
+  Trace *_trace;
+  ItemCosts *_costs;
+  const MiniZinc::Item *_item = nullptr;
+  Trace::Clock::time_point _start;
+  std::uint64_t _queued = 0; // when the item was entered
+
+public:
+  ItemSpan(Trace *trace, ItemCosts *costs) noexcept : _trace(trace), _costs(costs) {}
+  ItemSpan(ItemSpan &&other) noexcept
+      : _trace(other._trace), _costs(other._costs), _item(std::exchange(other._item, nullptr)),
+        _start(other._start), _queued(other._queued) {}
+  ItemSpan(const ItemSpan &) = delete;
+  ItemSpan &operator=(const ItemSpan &) = delete;
+  ItemSpan &operator=(ItemSpan &&) = delete;
+
+  void enter(const MiniZinc::Item *item, std::uint64_t queued);
+  void leave(std::uint64_t queued);
+};
+
 class SearchNode {
 public:
   enum class Attachement { direct, under };
@@ -71,15 +159,24 @@ public:
 class ExprSearcher {
   const std::vector<SearchNode> &nodes;
   const std::vector<ExprFilterFun> *global_filters;
+  const std::vector<std::string> *skipped_files; // expressions from these files are not entered
+  CancellationToken *cancellation;               // the search ends early once it is cancelled
+#ifdef LZN_SEARCH_STATS
+  SearchStats *stats = nullptr; // where the work is counted, if anywhere
+#endif
   std::vector<const MiniZinc::Expression *> path;
   std::vector<const MiniZinc::Expression *> dfs_stack;
   std::vector<const MiniZinc::Expression *> hits; // TODO: heap allocated array instead?
   std::size_t nodes_pos;
+  std::uint64_t queued = 0; // expressions queued since the searcher was made
 
 public:
   ExprSearcher(const std::vector<SearchNode> &nodes,
-               const std::vector<ExprFilterFun> *global_filters = nullptr)
-      : nodes(nodes), global_filters(global_filters), nodes_pos(0) {
+               const std::vector<ExprFilterFun> *global_filters = nullptr,
+               const std::vector<std::string> *skipped_files = nullptr,
+               CancellationToken *cancellation = nullptr)
+      : nodes(nodes), global_filters(global_filters), skipped_files(skipped_files),
+        cancellation(cancellation), nodes_pos(0) {
     assert(!nodes.empty());
     hits.reserve(nodes.size());
   }
@@ -89,6 +186,13 @@ public:
   void new_search(const MiniZinc::Expression *);
   void abort();
   bool next();
+  std::uint64_t queued_nodes() const noexcept { return queued; }
+  // Count the work in `s`, only in builds with LZN_SEARCH_STATS.
+  void count_into([[maybe_unused]] SearchStats *s) noexcept {
+#ifdef LZN_SEARCH_STATS
+    stats = s;
+#endif
+  }
 
   using PathIter = decltype(path)::const_reverse_iterator;
   using PathIters = std::pair<PathIter, PathIter>;
@@ -107,8 +211,10 @@ protected:
   bool iters_pushed;
   std::stack<std::pair<MiniZinc::Model::const_iterator, MiniZinc::Model::const_iterator>> iters;
   std::size_t item_child;
+  ItemSpan item_span;
 
   ModelSearcher(const MiniZinc::Model *m, const Search &search);
+  ~ModelSearcher();
 
 public:
   ModelSearcher(const ModelSearcher &) = delete;
@@ -124,6 +230,7 @@ protected:
   const MiniZinc::Item *iters_top() const;
   void iters_push(const MiniZinc::Model *);
   ExprSearcher::PathIters current_path() const;
+  std::uint64_t queued_nodes() const noexcept;
 };
 
 } // namespace LZN::Impl
@@ -140,12 +247,40 @@ class Search {
   const std::vector<std::string>
       *includePath; // Include paths to determine where stdlib functions are
   bool recursive;   // Whether or not to recursively lint included models
+  const ItemSet *onlyItems; // If not nullptr, only these top-level items are searched in
+  const std::vector<std::string>
+      *skippedFiles; // If not nullptr, items and expressions from these files are skipped
+  CancellationToken *cancellation; // If not nullptr, searches end early once it is cancelled
+  Trace *trace; // If not nullptr, each top-level item that is searched is added to it as a span
+  ItemCosts *itemCosts; // If not nullptr, the cost of each top-level item is added to it
+#ifdef LZN_SEARCH_STATS
+  mutable Impl::StatsAccount account; // The work of the searches, added to a sink at the end
+#endif
 
   Search(std::vector<Impl::SearchNode> nodes, Impl::SearchLocs locations, std::size_t numcaptures,
          std::vector<ExprFilterFun> global_filters, const std::vector<std::string> *includePath,
-         bool recursive)
+         bool recursive, const ItemSet *onlyItems, const std::vector<std::string> *skippedFiles,
+         CancellationToken *cancellation, Trace *trace, ItemCosts *itemCosts,
+         [[maybe_unused]] SearchStats *statsSink)
       : nodes(std::move(nodes)), locations(std::move(locations)), numcaptures(numcaptures),
-        global_filters(std::move(global_filters)), includePath(includePath), recursive(recursive) {}
+        global_filters(std::move(global_filters)), includePath(includePath), recursive(recursive),
+        onlyItems(onlyItems), skippedFiles(skippedFiles), cancellation(cancellation), trace(trace),
+        itemCosts(itemCosts)
+#ifdef LZN_SEARCH_STATS
+        ,
+        account(statsSink)
+#endif
+  {
+  }
+
+  // Where the searchers count their work, nullptr without LZN_SEARCH_STATS.
+  SearchStats *counters() const noexcept {
+#ifdef LZN_SEARCH_STATS
+    return &account.stats();
+#else
+    return nullptr;
+#endif
+  }
 
   friend class SearchBuilder;
   friend class Impl::ModelSearcher;
@@ -183,8 +318,11 @@ public:
   private:
     ExpressionSearcher(const std::vector<Impl::SearchNode> &nodes,
                        const std::vector<ExprFilterFun> *global_filters,
+                       const std::vector<std::string> *skipped_files,
+                       CancellationToken *cancellation, SearchStats *counters,
                        const MiniZinc::Expression *e)
-        : Impl::ExprSearcher(nodes, global_filters) {
+        : Impl::ExprSearcher(nodes, global_filters, skipped_files, cancellation) {
+      count_into(counters);
       new_search(e);
     }
 
@@ -209,10 +347,16 @@ public:
   ModelSearcher search(const MiniZinc::Model *) && = delete;
   // Search an expression
   ExpressionSearcher search(const MiniZinc::Expression *e) const & {
-    return ExpressionSearcher(nodes, &global_filters, e);
+    return ExpressionSearcher(nodes, &global_filters, skippedFiles, cancellation, counters(), e);
   }
   ExpressionSearcher search(const MiniZinc::Expression *) && = delete;
 
+  // The work of the searches made so far, all zero without LZN_SEARCH_STATS.
+  SearchStats stats() const noexcept {
+    const SearchStats *c = counters();
+    return c != nullptr ? *c : SearchStats();
+  }
+
   // Returns true if an include-statement includes a non-library model.
   bool is_user_defined_include(const MiniZinc::IncludeI *) const noexcept;
   bool is_recursive() const noexcept;
@@ -228,6 +372,12 @@ class SearchBuilder {
   std::vector<ExprFilterFun> global_filters;
   const std::vector<std::string> *includePath = nullptr;
   bool _recursive = false;
+  const ItemSet *onlyItems = nullptr;
+  const std::vector<std::string> *skippedFiles = nullptr;
+  CancellationToken *cancellation = nullptr;
+  Trace *trace = nullptr;
+  ItemCosts *itemCosts = nullptr;
+  SearchStats *statsSink = nullptr;
 
   using Attach = Impl::SearchNode::Attachement;
 
@@ -251,6 +401,48 @@ public:
     return *this;
   }
 
+  // ModelSearcher only searches in the top-level items in `items`, or in all items if it is
+  // nullptr. Included models are still recursed into. ExprSearcher unaffected.
+  SearchBuilder &only_items(const ItemSet *items) {
+    onlyItems = items;
+    return *this;
+  }
+
+  // Skip the top-level items and expressions that come from `files`, e.g. the values in data files,
+  // or nothing if it is nullptr. Applies to both ModelSearcher and ExprSearcher.
+  SearchBuilder &skip_files(const std::vector<std::string> *files) {
+    skippedFiles = files;
+    return *this;
+  }
+
+  // End searches early, as if nothing more was found, once `token` is cancelled, or never if it is
+  // nullptr. Applies to both ModelSearcher and ExprSearcher.
+  SearchBuilder &cancel_on(CancellationToken *token) {
+    cancellation = token;
+    return *this;
+  }
+
+  // Add each top-level item that a ModelSearcher enters to `t` as a span, until it leaves the item,
+  // or don't trace items with nullptr.
+  SearchBuilder &trace_items(Trace *t) {
+    trace = t;
+    return *this;
+  }
+
+  // Add the time that ModelSearchers spend in each top-level item and the expressions they queue
+  // there to `costs`, or don't with nullptr.
+  SearchBuilder &cost_items(ItemCosts *costs) {
+    itemCosts = costs;
+    return *this;
+  }
+
+  // Add the work of the searches to `sink` when the Search is destroyed, or nowhere if it is
+  // nullptr. Only counted in builds with LZN_SEARCH_STATS.
+  SearchBuilder &count_into(SearchStats *sink) {
+    statsSink = sink;
+    return *this;
+  }
+
   // Specify that a type of top-level item should be searched in.
   SearchBuilder &in_include(bool visit = true) {
     locations.use_ii = visit;
@@ -362,7 +554,8 @@ public:
   // Construct the Search.
   Search build() {
     return Search(std::move(nodes), std::move(locations), numcaptures, std::move(global_filters),
-                  includePath, _recursive);
+                  includePath, _recursive, onlyItems, skippedFiles, cancellation, trace,
+                  itemCosts, statsSink);
   }
 };
 } // namespace LZN
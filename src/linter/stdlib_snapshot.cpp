@@ -0,0 +1,417 @@
+#include "stdlib_snapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <linter/hashing.hpp>
+#include <linter/lexer.hpp>
+#include <sstream>
+#include <sys/stat.h>
+#include <system_error>
+
+namespace {
+using namespace LZN;
+namespace fs = std::filesystem;
+
+constexpr char MAGIC[8] = {'L', 'Z', 'N', 'S', 'N', 'A', 'P', '\0'};
+
+// The on-disk layout is: Header, FileRec[num_files], IncludeRec[num_includes],
+// DeclRec[num_decls] and finally all strings. Files are sorted by path and declarations by name.
+struct Header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t num_files;
+  std::uint64_t hash;
+  std::uint32_t num_includes;
+  std::uint32_t num_decls;
+  std::uint64_t strings_size;
+};
+
+struct FileRec {
+  std::uint32_t path_off, path_len;
+  std::uint32_t first_include, num_includes;
+};
+
+struct IncludeRec {
+  std::uint32_t target;
+};
+
+struct DeclRec {
+  std::uint32_t name_off, name_len;
+  std::uint32_t file, line;
+  std::uint16_t kind, arity;
+};
+
+template <typename T>
+T read_at(std::string_view bytes, std::size_t offset) {
+  T value;
+  std::memcpy(&value, bytes.data() + offset, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void append(std::string &out, const T &value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+std::size_t files_offset() {
+  return sizeof(Header);
+}
+
+std::size_t includes_offset(const Header &h) {
+  return files_offset() + h.num_files * sizeof(FileRec);
+}
+
+std::size_t decls_offset(const Header &h) {
+  return includes_offset(h) + h.num_includes * sizeof(IncludeRec);
+}
+
+std::size_t strings_offset(const Header &h) {
+  return decls_offset(h) + h.num_decls * sizeof(DeclRec);
+}
+
+// All `.mzn` files below `dir` as sorted generic paths relative to `dir`.
+std::vector<std::string> stdlib_files(const std::string &dir) {
+  std::vector<std::string> files;
+  for (const auto &entry : fs::recursive_directory_iterator(dir)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".mzn")
+      files.push_back(fs::relative(entry.path(), dir).generic_string());
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+// Hashes the size and modification time of a file, like the result cache does for the standard
+// library. Reading every file would cost more than loading the snapshot saves.
+void add_stat(Hasher &h, const std::string &path) {
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0) {
+    h.add(std::uint8_t{0});
+    return;
+  }
+  h.add(static_cast<std::uint64_t>(st.st_size))
+      .add(static_cast<std::int64_t>(st.st_mtim.tv_sec))
+      .add(static_cast<std::int64_t>(st.st_mtim.tv_nsec));
+}
+
+// Counts the parameters of a parameter list that starts at `open`, which must be a '('.
+unsigned int count_params(const std::vector<Token> &tokens, std::size_t open) {
+  if (open + 1 < tokens.size() && tokens[open + 1].is_punct(')'))
+    return 0;
+  unsigned int commas = 0;
+  int depth = 0;
+  for (std::size_t i = open; i < tokens.size(); ++i) {
+    const Token &t = tokens[i];
+    if (t.is_punct('(') || t.is_punct('[') || t.is_punct('{')) {
+      ++depth;
+    } else if (t.is_punct(')') || t.is_punct(']') || t.is_punct('}')) {
+      if (--depth == 0)
+        break;
+    } else if (depth == 1 && t.is_punct(',')) {
+      ++commas;
+    }
+  }
+  return commas + 1;
+}
+
+struct ScannedDecl {
+  std::string_view name;
+  StdlibSnapshot::DeclKind kind;
+  unsigned int arity;
+  unsigned int line;
+};
+
+// Finds the declarations of predicates, functions, tests and annotations in `tokens`.
+std::vector<ScannedDecl> scan_declarations(const std::vector<Token> &tokens) {
+  using Kind = StdlibSnapshot::DeclKind;
+  std::vector<ScannedDecl> decls;
+
+  auto add = [&](std::size_t name_idx, Kind kind) {
+    const std::size_t next = name_idx + 1;
+    const unsigned int arity =
+        next < tokens.size() && tokens[next].is_punct('(') ? count_params(tokens, next) : 0;
+    decls.push_back({tokens[name_idx].text, kind, arity, tokens[name_idx].line});
+  };
+
+  for (std::size_t i = 0; i + 1 < tokens.size(); ++i) {
+    const Token &t = tokens[i];
+    if (t.kind != Token::Kind::IDENT)
+      continue;
+
+    if (t.text == "predicate" || t.text == "test" || t.text == "annotation") {
+      if (tokens[i + 1].kind != Token::Kind::IDENT)
+        continue;
+      const Kind kind = t.text == "predicate" ? Kind::PREDICATE
+                        : t.text == "test"    ? Kind::TEST
+                                              : Kind::ANNOTATION;
+      add(i + 1, kind);
+    } else if (t.text == "function") {
+      // function <type-inst>: name(...), the type-inst may contain anything but a ';'
+      for (std::size_t j = i + 1; j + 2 < tokens.size() && !tokens[j].is_punct(';'); ++j) {
+        if (tokens[j].is_punct(':') && tokens[j + 1].kind == Token::Kind::IDENT &&
+            (tokens[j + 2].is_punct('(') || tokens[j + 2].is_punct('=') ||
+             tokens[j + 2].is_punct(';'))) {
+          add(j + 1, Kind::FUNCTION);
+          break;
+        }
+      }
+    }
+  }
+  return decls;
+}
+} // namespace
+
+namespace LZN {
+
+std::uint64_t stdlib_stat_key(const std::string &stdlib_dir) {
+  Hasher h;
+  for (const auto &file : stdlib_files(stdlib_dir)) {
+    h.add_string(file);
+    add_stat(h, (fs::path(stdlib_dir) / file).string());
+  }
+  return h.value();
+}
+
+StdlibSnapshot::StdlibSnapshot(MappedFile mapping) : _mapping(std::move(mapping)) {
+  _bytes = _mapping->contents();
+}
+
+StdlibSnapshot::StdlibSnapshot(std::string storage) : _storage(std::move(storage)) {
+  _bytes = _storage;
+}
+
+StdlibSnapshot::StdlibSnapshot(StdlibSnapshot &&other) noexcept
+    : _mapping(std::move(other._mapping)), _storage(std::move(other._storage)) {
+  _bytes = _mapping ? _mapping->contents() : std::string_view(_storage);
+  other._bytes = {};
+}
+
+StdlibSnapshot &StdlibSnapshot::operator=(StdlibSnapshot &&other) noexcept {
+  _mapping = std::move(other._mapping);
+  _storage = std::move(other._storage);
+  _bytes = _mapping ? _mapping->contents() : std::string_view(_storage);
+  other._bytes = {};
+  return *this;
+}
+
+std::string StdlibSnapshot::snapshot_path(const std::string &cache_dir, std::uint64_t hash) {
+  std::ostringstream oss;
+  oss << cache_dir << "/stdlib-" << std::hex << hash << std::dec << ".v" << VERSION << ".snap";
+  return oss.str();
+}
+
+bool StdlibSnapshot::is_valid(std::string_view bytes, std::uint64_t hash) noexcept {
+  if (bytes.size() < sizeof(Header))
+    return false;
+  const auto h = read_at<Header>(bytes, 0);
+  if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version != VERSION || h.hash != hash ||
+      strings_offset(h) + h.strings_size != bytes.size())
+    return false;
+
+  // Every string and index must be in range, so that the lookups can't fail on a corrupt file.
+  auto in_strings = [&h](std::uint32_t off, std::uint32_t len) {
+    return off <= h.strings_size && len <= h.strings_size - off;
+  };
+  for (std::uint32_t i = 0; i < h.num_files; ++i) {
+    const auto rec = read_at<FileRec>(bytes, files_offset() + i * sizeof(FileRec));
+    if (!in_strings(rec.path_off, rec.path_len) || rec.first_include > h.num_includes ||
+        rec.num_includes > h.num_includes - rec.first_include)
+      return false;
+  }
+  for (std::uint32_t i = 0; i < h.num_includes; ++i) {
+    const auto rec = read_at<IncludeRec>(bytes, includes_offset(h) + i * sizeof(IncludeRec));
+    if (rec.target >= h.num_files && rec.target != NO_FILE)
+      return false;
+  }
+  for (std::uint32_t i = 0; i < h.num_decls; ++i) {
+    const auto rec = read_at<DeclRec>(bytes, decls_offset(h) + i * sizeof(DeclRec));
+    if (!in_strings(rec.name_off, rec.name_len) || rec.file >= h.num_files)
+      return false;
+  }
+  return true;
+}
+
+std::string StdlibSnapshot::build(const std::string &stdlib_dir, std::uint64_t hash) {
+  const std::vector<std::string> paths = stdlib_files(stdlib_dir);
+  auto index_of = [&paths](const std::string &p) -> std::uint32_t {
+    auto it = std::lower_bound(paths.begin(), paths.end(), p);
+    if (it == paths.end() || *it != p)
+      return NO_FILE;
+    return static_cast<std::uint32_t>(it - paths.begin());
+  };
+
+  std::string strings;
+  auto add_string = [&strings](std::string_view s) {
+    auto off = static_cast<std::uint32_t>(strings.size());
+    strings.append(s);
+    return std::make_pair(off, static_cast<std::uint32_t>(s.size()));
+  };
+
+  std::vector<FileRec> files;
+  std::vector<IncludeRec> includes;
+  std::vector<DeclRec> decls;
+
+  for (std::uint32_t fi = 0; fi < paths.size(); ++fi) {
+    const std::string contents = read_file((fs::path(stdlib_dir) / paths[fi]).string());
+    const std::vector<Token> tokens = tokenize(contents);
+
+    FileRec rec;
+    std::tie(rec.path_off, rec.path_len) = add_string(paths[fi]);
+    rec.first_include = static_cast<std::uint32_t>(includes.size());
+
+    // Includes are resolved like MiniZinc does it: first relative to the including file, then
+    // relative to the root of the standard library.
+    const fs::path parent = fs::path(paths[fi]).parent_path();
+    for (auto inc : included_files(tokens)) {
+      const fs::path inc_path(std::string{inc});
+      std::uint32_t target = index_of((parent / inc_path).lexically_normal().generic_string());
+      if (target == NO_FILE)
+        target = index_of(inc_path.lexically_normal().generic_string());
+      includes.push_back({target});
+    }
+    rec.num_includes = static_cast<std::uint32_t>(includes.size()) - rec.first_include;
+    files.push_back(rec);
+
+    for (const auto &d : scan_declarations(tokens)) {
+      DeclRec drec;
+      std::tie(drec.name_off, drec.name_len) = add_string(d.name);
+      drec.file = fi;
+      drec.line = d.line;
+      drec.kind = static_cast<std::uint16_t>(d.kind);
+      drec.arity = static_cast<std::uint16_t>(d.arity);
+      decls.push_back(drec);
+    }
+  }
+
+  std::sort(decls.begin(), decls.end(), [&strings](const DeclRec &a, const DeclRec &b) {
+    return std::string_view(strings).substr(a.name_off, a.name_len) <
+           std::string_view(strings).substr(b.name_off, b.name_len);
+  });
+
+  Header h;
+  std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+  h.version = VERSION;
+  h.num_files = static_cast<std::uint32_t>(files.size());
+  h.hash = hash;
+  h.num_includes = static_cast<std::uint32_t>(includes.size());
+  h.num_decls = static_cast<std::uint32_t>(decls.size());
+  h.strings_size = strings.size();
+
+  std::string out;
+  out.reserve(strings_offset(h) + strings.size());
+  append(out, h);
+  for (const auto &f : files)
+    append(out, f);
+  for (const auto &i : includes)
+    append(out, i);
+  for (const auto &d : decls)
+    append(out, d);
+  out.append(strings);
+  return out;
+}
+
+StdlibSnapshot StdlibSnapshot::load_or_build(const std::string &stdlib_dir,
+                                             const std::string &cache_dir) {
+  const std::uint64_t hash = stdlib_stat_key(stdlib_dir);
+
+  if (!cache_dir.empty()) {
+    const std::string path = snapshot_path(cache_dir, hash);
+    try {
+      MappedFile mapping(path);
+      if (is_valid(mapping.contents(), hash))
+        return StdlibSnapshot(std::move(mapping));
+    } catch (const std::system_error &) {
+      // missing or unreadable, build a new one below
+    }
+
+    std::string bytes = build(stdlib_dir, hash);
+    if (ensure_directory(cache_dir) && write_file_atomically(path, bytes)) {
+      try {
+        MappedFile mapping(path);
+        if (is_valid(mapping.contents(), hash))
+          return StdlibSnapshot(std::move(mapping));
+      } catch (const std::system_error &) {}
+    }
+    return StdlibSnapshot(std::move(bytes));
+  }
+
+  return StdlibSnapshot(build(stdlib_dir, hash));
+}
+
+std::uint64_t StdlibSnapshot::stat_key() const noexcept {
+  return read_at<Header>(_bytes, 0).hash;
+}
+
+std::size_t StdlibSnapshot::num_files() const noexcept {
+  return read_at<Header>(_bytes, 0).num_files;
+}
+
+std::string_view StdlibSnapshot::file(std::uint32_t i) const {
+  const auto h = read_at<Header>(_bytes, 0);
+  if (i >= h.num_files)
+    throw std::out_of_range("no such file in snapshot");
+  const auto rec = read_at<FileRec>(_bytes, files_offset() + i * sizeof(FileRec));
+  return _bytes.substr(strings_offset(h) + rec.path_off, rec.path_len);
+}
+
+std::optional<std::uint32_t>
+StdlibSnapshot::find_file(std::string_view relative_path) const noexcept {
+  std::uint32_t lo = 0;
+  std::uint32_t hi = static_cast<std::uint32_t>(num_files());
+  while (lo < hi) {
+    const std::uint32_t mid = lo + (hi - lo) / 2;
+    const std::string_view f = file(mid);
+    if (f == relative_path)
+      return mid;
+    if (f < relative_path)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return std::nullopt;
+}
+
+std::vector<std::uint32_t> StdlibSnapshot::includes(std::uint32_t file) const {
+  const auto h = read_at<Header>(_bytes, 0);
+  if (file >= h.num_files)
+    throw std::out_of_range("no such file in snapshot");
+  const auto rec = read_at<FileRec>(_bytes, files_offset() + file * sizeof(FileRec));
+  std::vector<std::uint32_t> res;
+  res.reserve(rec.num_includes);
+  for (std::uint32_t i = 0; i < rec.num_includes; ++i) {
+    const auto inc = read_at<IncludeRec>(
+        _bytes, includes_offset(h) + (rec.first_include + i) * sizeof(IncludeRec));
+    res.push_back(inc.target);
+  }
+  return res;
+}
+
+std::vector<StdlibSnapshot::Decl> StdlibSnapshot::declarations(std::string_view name) const {
+  const auto h = read_at<Header>(_bytes, 0);
+  const std::size_t strings = strings_offset(h);
+  auto decl_at = [&](std::uint32_t i) {
+    return read_at<DeclRec>(_bytes, decls_offset(h) + i * sizeof(DeclRec));
+  };
+  auto name_of = [&](const DeclRec &d) { return _bytes.substr(strings + d.name_off, d.name_len); };
+
+  // binary search for the first declaration not less than `name`
+  std::uint32_t lo = 0;
+  std::uint32_t hi = h.num_decls;
+  while (lo < hi) {
+    const std::uint32_t mid = lo + (hi - lo) / 2;
+    if (name_of(decl_at(mid)) < name)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  std::vector<Decl> res;
+  for (std::uint32_t i = lo; i < h.num_decls; ++i) {
+    const auto d = decl_at(i);
+    if (name_of(d) != name)
+      break;
+    res.push_back({name_of(d), static_cast<DeclKind>(d.kind), d.arity, d.file, d.line});
+  }
+  return res;
+}
+
+} // namespace LZN
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <linter/file_utils.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LZN {
+
+// Returns a hash of the names, sizes and modification times of all `.mzn` files below
+// `stdlib_dir`. Only the files are stat'ed, none is read. The key changes whenever the standard
+// library is changed or installed again and is used to tell if cached data is stale.
+std::uint64_t stdlib_stat_key(const std::string &stdlib_dir);
+
+// An index of the declarations and includes of every file in a standard library directory. It is
+// built with a lexical scan and stored on disk in a compact binary format under its
+// `stdlib_stat_key`, so that later runs only stat the files and map the index instead of reading
+// and scanning every file again.
+//
+// NOTE: libminizinc can't serialize or restore its AST, so this does not replace
+// `MiniZinc::parse`. It answers questions about the standard library without parsing it, for
+// example which files must be loaded to get a declaration of some identifier.
+class StdlibSnapshot {
+public:
+  // Bumped whenever the binary format or the scanner changes.
+  static constexpr std::uint32_t VERSION = 1;
+  static constexpr std::uint32_t NO_FILE = UINT32_MAX;
+
+  enum class DeclKind : std::uint16_t { PREDICATE, FUNCTION, TEST, ANNOTATION };
+
+  // A top-level function-like declaration.
+  struct Decl {
+    std::string_view name;
+    DeclKind kind;
+    unsigned int arity; // number of parameters
+    std::uint32_t file; // index of the declaring file
+    unsigned int line;  // line of the name in the file
+  };
+
+private:
+  std::optional<MappedFile> _mapping;
+  std::string _storage; // used instead of `_mapping` when the snapshot couldn't be stored
+  std::string_view _bytes;
+
+  explicit StdlibSnapshot(MappedFile mapping);
+  explicit StdlibSnapshot(std::string storage);
+
+  // Returns true if `bytes` is a snapshot of this version with the given hash, with all offsets in
+  // range.
+  static bool is_valid(std::string_view bytes, std::uint64_t hash) noexcept;
+  // Scans every file in `stdlib_dir` and returns a serialized snapshot.
+  static std::string build(const std::string &stdlib_dir, std::uint64_t hash);
+
+public:
+  StdlibSnapshot(StdlibSnapshot &&) noexcept;
+  StdlibSnapshot &operator=(StdlibSnapshot &&) noexcept;
+
+  // Loads the snapshot of `stdlib_dir` from `cache_dir`. It is built and stored first if it is
+  // missing or stale. If `cache_dir` is empty or not writable, the snapshot is only kept in
+  // memory.
+  static StdlibSnapshot load_or_build(const std::string &stdlib_dir, const std::string &cache_dir);
+
+  // The path to the file a snapshot of `stdlib_dir` is stored in.
+  static std::string snapshot_path(const std::string &cache_dir, std::uint64_t hash);
+
+  // The `stdlib_stat_key` the snapshot was built for.
+  std::uint64_t stat_key() const noexcept;
+
+  // The files, as paths relative to the standard library directory.
+  std::size_t num_files() const noexcept;
+  std::string_view file(std::uint32_t i) const;
+  std::optional<std::uint32_t> find_file(std::string_view relative_path) const noexcept;
+
+  // The files that `file` includes, unresolvable includes are `NO_FILE`.
+  std::vector<std::uint32_t> includes(std::uint32_t file) const;
+
+  // All declarations named `name`.
+  std::vector<Decl> declarations(std::string_view name) const;
+};
+} // namespace LZN
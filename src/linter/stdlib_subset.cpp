@@ -0,0 +1,196 @@
+#include "stdlib_subset.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <linter/file_utils.hpp>
+#include <linter/hashing.hpp>
+#include <linter/lexer.hpp>
+#include <linter/stdlib_snapshot.hpp>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+using namespace LZN;
+namespace fs = std::filesystem;
+
+// Bumped whenever what goes into the copies changes.
+constexpr std::uint32_t VERSION = 1;
+
+// Operators are used without their names showing up as identifiers, so their overloads are always
+// kept. Operators that are words, like `div`, are identifiers.
+constexpr const char *OPERATORS[] = {"<->", "->", "<-", "\\/", "/\\", "<", ">",  "<=",
+                                     ">=",  "==", "=",  "!=", "..", "++", "+", "-",
+                                     "*",   "/",  "^",  "~+", "~-", "~*", "~=", "~!="};
+
+using FileSet = std::unordered_set<std::uint32_t>;
+
+// Adds `file` and every file it includes, transitively, to `files`.
+void add_closure(const StdlibSnapshot &snapshot, std::uint32_t file, FileSet &files) {
+  std::vector<std::uint32_t> pending = {file};
+  while (!pending.empty()) {
+    const std::uint32_t f = pending.back();
+    pending.pop_back();
+    if (f == StdlibSnapshot::NO_FILE || !files.insert(f).second)
+      continue;
+    for (auto inc : snapshot.includes(f))
+      pending.push_back(inc);
+  }
+}
+
+void add_identifiers(std::string_view contents, std::vector<std::string> &names) {
+  for (const Token &t : tokenize(contents)) {
+    if (t.kind == Token::Kind::IDENT)
+      names.emplace_back(t.text);
+  }
+}
+
+// Returns true if `tokens` are nothing but include items.
+bool only_includes(const std::vector<Token> &tokens) {
+  if (tokens.size() % 3 != 0)
+    return false;
+  for (std::size_t i = 0; i < tokens.size(); i += 3) {
+    if (!tokens[i].is_ident("include") || tokens[i + 1].kind != Token::Kind::STRING ||
+        !tokens[i + 2].is_punct(';'))
+      return false;
+  }
+  return true;
+}
+
+// A file of the standard library that is included by a user file and may be shadowed by a copy.
+struct Shadowed {
+  std::string name;                  // the included name, a file directly in the stdlib directory
+  std::vector<std::string> includes; // the names the file includes
+  std::vector<FileSet> closures;     // the files loaded by each of the includes
+  std::vector<bool> needed;          // whether each of the includes is kept in the copy
+};
+} // namespace
+
+namespace LZN {
+std::vector<std::string> reduced_include_path(const std::vector<std::string> &roots,
+                                              const std::vector<std::string> &includePath,
+                                              const std::string &cache_dir) {
+  std::error_code ec;
+  const auto stdlib_dir =
+      std::find_if(includePath.begin(), includePath.end(), [&ec](const std::string &dir) {
+        return fs::is_regular_file(fs::path(dir) / "stdlib.mzn", ec);
+      });
+  if (cache_dir.empty() || stdlib_dir == includePath.end())
+    return includePath;
+
+  std::vector<std::string> names(std::begin(OPERATORS), std::end(OPERATORS));
+  std::vector<std::string> candidates;
+  walk_includes(
+      roots, includePath,
+      [&names](const std::string &, std::string_view contents) {
+        add_identifiers(contents, names);
+      },
+      [&](std::string_view name, const std::string &resolved) {
+        const fs::path path(name);
+        if (!path.has_parent_path() && !resolved.empty() &&
+            resolved == (fs::path(*stdlib_dir) / path).string())
+          candidates.emplace_back(name);
+      });
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+  if (candidates.empty())
+    return includePath;
+
+  const StdlibSnapshot snapshot = StdlibSnapshot::load_or_build(*stdlib_dir, cache_dir);
+  auto read = [&snapshot, &stdlib_dir](std::uint32_t file) {
+    return MappedFile((fs::path(*stdlib_dir) / std::string(snapshot.file(file))).string());
+  };
+
+  FileSet always;
+  if (auto stdlib = snapshot.find_file("stdlib.mzn"))
+    add_closure(snapshot, *stdlib, always);
+
+  std::vector<Shadowed> shadowed;
+  // Which include of which shadowed file loads a file, there may be several.
+  std::unordered_map<std::uint32_t, std::vector<std::pair<std::size_t, std::size_t>>> owners;
+  for (const auto &name : candidates) {
+    const auto file = snapshot.find_file(name);
+    if (!file || always.count(*file) > 0)
+      continue;
+    const std::vector<std::uint32_t> includes = snapshot.includes(*file);
+    const MappedFile mapping = read(*file);
+    const std::vector<Token> tokens = tokenize(mapping.contents());
+    if (includes.empty() || !only_includes(tokens) ||
+        std::count(includes.begin(), includes.end(), StdlibSnapshot::NO_FILE) > 0)
+      continue;
+
+    Shadowed s;
+    s.name = name;
+    for (auto inc : included_files(tokens))
+      s.includes.emplace_back(inc);
+    s.closures.resize(includes.size());
+    s.needed.assign(includes.size(), false);
+    for (std::size_t i = 0; i < includes.size(); ++i) {
+      add_closure(snapshot, includes[i], s.closures[i]);
+      for (auto f : s.closures[i])
+        owners[f].emplace_back(shadowed.size(), i);
+    }
+    shadowed.push_back(std::move(s));
+  }
+  if (shadowed.empty())
+    return includePath;
+
+  // Keep every include that loads a declaration of a name, then look for the names used there.
+  std::unordered_set<std::string> looked_up;
+  FileSet scanned;
+  while (!names.empty()) {
+    const std::string name = std::move(names.back());
+    names.pop_back();
+    if (!looked_up.insert(name).second)
+      continue;
+    for (const auto &decl : snapshot.declarations(name)) {
+      const auto it = owners.find(decl.file);
+      if (it == owners.end())
+        continue;
+      for (const auto &[si, ii] : it->second) {
+        Shadowed &s = shadowed[si];
+        if (s.needed[ii])
+          continue;
+        s.needed[ii] = true;
+        for (auto f : s.closures[ii]) {
+          if (scanned.insert(f).second)
+            add_identifiers(read(f).contents(), names);
+        }
+      }
+    }
+  }
+
+  Hasher h;
+  h.add(VERSION).add(snapshot.stat_key()).add_string(*stdlib_dir);
+  std::vector<std::pair<std::string, std::string>> copies;
+  for (const auto &s : shadowed) {
+    if (std::all_of(s.needed.begin(), s.needed.end(), [](bool n) { return n; }))
+      continue;
+    std::string contents = "% " + s.name + " reduced by lzn to what the model uses\n";
+    for (std::size_t i = 0; i < s.includes.size(); ++i) {
+      if (s.needed[i])
+        contents += "include \"" + s.includes[i] + "\";\n";
+    }
+    h.add_string(s.name).add_string(contents);
+    copies.emplace_back(s.name, std::move(contents));
+  }
+  if (copies.empty())
+    return includePath;
+
+  // The directory is named after its contents, so a directory that exists is never stale.
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(h.value()));
+  const std::string dir = cache_dir + "/stdlib-subsets/" + hex;
+  for (const auto &[name, contents] : copies) {
+    const std::string path = dir + "/" + name;
+    if (!fs::is_regular_file(path, ec) &&
+        !(ensure_directory(dir) && write_file_atomically(path, contents)))
+      return includePath;
+  }
+
+  std::vector<std::string> reduced = {dir + "/"};
+  reduced.insert(reduced.end(), includePath.begin(), includePath.end());
+  return reduced;
+}
+} // namespace LZN
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace LZN {
+// Returns an include path that loads less of the standard library for the user files `roots` and
+// the files they include, but gives the same model.
+//
+// A lexical scan of the user files collects every identifier they mention. Each file of the
+// standard library that they include and that does nothing but include other files, such as
+// `globals.mzn`, is shadowed by a copy that only includes those of its files that declare one of
+// the identifiers, or an identifier used by such a file in turn. Every overload of a name is kept,
+// so the same declarations are chosen when typechecking. The files that `stdlib.mzn` includes are
+// always loaded in full, typechecking inserts calls to them that can't be seen in the source.
+//
+// The copies are stored below `cache_dir` and their directory is put in front of `includePath`.
+// Returns `includePath` itself if nothing can be left out or the copies can't be stored. Throws
+// std::system_error if a file can't be read.
+std::vector<std::string> reduced_include_path(const std::vector<std::string> &roots,
+                                              const std::vector<std::string> &includePath,
+                                              const std::string &cache_dir);
+} // namespace LZN
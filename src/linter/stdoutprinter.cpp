@@ -1,59 +1,57 @@
 #include "stdoutprinter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <limits>
 #include <linter/file_utils.hpp>
 #include <linter/overload.hpp>
 #include <rang.hpp>
+#include <string_view>
 #include <variant>
 
 namespace {
 using namespace LZN;
-using Lines = std::vector<std::string>;
-using LinesIter = Lines::const_iterator;
 
-constexpr const char *BAR_PREFIX = "   |     ";
-constexpr const char *ARROW_PREFIX = "   ^     ";
-constexpr const std::size_t MAX_LINE = 200;
+constexpr std::string_view BAR_PREFIX = "   |     ";
+constexpr std::string_view ARROW_PREFIX = "   ^     ";
+constexpr std::string_view ELLIPSIS = "...";
+constexpr std::size_t MAX_LINE = 200;
+// The output is collected and written in blocks of about this size.
+constexpr std::size_t BLOCK_SIZE = 64 * 1024;
 
-void print_marker(unsigned int startcol, unsigned int endcol) {
-  assert(endcol >= startcol && startcol > 0 && endcol > 0);
-  for (unsigned int i = 0; i < startcol - 1 && i < MAX_LINE; i++) {
-    std::cout << ' ';
-  }
-  std::cout << '^';
-  for (unsigned int i = startcol + 1; i <= endcol && i <= MAX_LINE; i++) {
-    std::cout << '~';
-  }
-}
+// The escape codes that rang would write, or none.
+struct Palette {
+  std::string_view error;      // bright red and bold
+  std::string_view note;       // bright green
+  std::string_view marker;     // bright yellow and bold
+  std::string_view sub_marker; // bright cyan and bold
+  std::string_view rule;       // bright magenta and bold
+  std::string_view bold;
+  std::string_view reset;
+};
 
-Lines split_lines(const std::string &s) {
-  Lines lines;
-  const char delim = '\n';
-  std::size_t start = 0;
-  while (start < s.length()) {
-    const std::size_t found = s.find(delim, start);
-    if (found == std::string::npos) {
-      break;
-    }
-    lines.push_back(s.substr(start, found - start));
-    start = found + 1;
-  }
-  if (start < s.length()) {
-    lines.push_back(s.substr(start));
+constexpr Palette COLORED = {"\033[91m\033[1m", "\033[92m", "\033[93m\033[1m", "\033[96m\033[1m",
+                             "\033[95m\033[1m", "\033[1m", "\033[0m"};
+constexpr Palette PLAIN = {"", "", "", "", "", "", ""};
+
+// Returns the palette for `os`, as rang decides it for its control mode.
+const Palette &palette_for(const std::ostream &os) {
+  using namespace rang::rang_implementation;
+  switch (controlMode().load()) {
+  case rang::control::Force: return COLORED;
+  case rang::control::Auto: return supportsColor() && isTerminal(os.rdbuf()) ? COLORED : PLAIN;
+  default: return PLAIN;
   }
-  return lines;
 }
 
-std::size_t indentation(const std::string &s) {
+std::size_t indentation(std::string_view s) {
   std::size_t i = 0;
-  for (const auto c : s) {
-    if (std::isspace(c))
-      ++i;
-    else
-      break;
-  }
+  while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i])))
+    ++i;
   return i;
 }
 
-std::size_t largest_common_indentation(LinesIter beg, LinesIter end) {
+template <typename It> std::size_t largest_common_indentation(It beg, It end) {
   assert(beg != end);
   std::size_t lci = std::numeric_limits<std::size_t>::max();
   for (; beg != end; ++beg) {
@@ -62,42 +60,6 @@ std::size_t largest_common_indentation(LinesIter beg, LinesIter end) {
   return lci;
 }
 
-std::size_t print_line(const std::string &s, std::size_t start = 0,
-                       std::size_t maximum = MAX_LINE) {
-  constexpr const char *elips = "...";
-  assert(maximum >= std::strlen(elips));
-  if (start >= s.length())
-    return 0;
-  const bool too_long = s.length() - start > maximum;
-  const std::size_t end = too_long ? maximum - std::strlen(elips) + start : s.length();
-  // TODO: handle the case of multi-byte characters
-
-  for (std::size_t i = start; i < end; ++i) {
-    if (std::isspace(s[i]))
-      std::cout << ' ';
-    else
-      std::cout << s[i];
-  }
-
-  if (too_long)
-    std::cout << "...";
-
-  return end - start + (too_long ? std::strlen(elips) : 0);
-}
-
-template <typename P>
-void print_lines_prefixed(LinesIter begin, LinesIter end, P &prefix) {
-  if (begin == end)
-    return;
-
-  const std::size_t lci = largest_common_indentation(begin, end);
-  for (; begin != end; ++begin) {
-    std::cout << prefix();
-    print_line(*begin, lci);
-    std::cout << std::endl;
-  }
-}
-
 auto prefixer(bool use_arrow = false) {
   return [print_arrow = use_arrow]() mutable {
     if (print_arrow) {
@@ -108,84 +70,6 @@ auto prefixer(bool use_arrow = false) {
   };
 }
 
-void print_code(const FileContents &contents, CachedFileReader &reader, bool is_subresult = false) {
-  if (contents.is_empty())
-    return;
-
-  if (!contents.is_valid()) {
-    std::cout << rang::fgB::red << rang::style::bold
-              << "Couldn't print because file location is invalid" << rang::style::reset
-              << std::endl;
-    return;
-  }
-
-  auto prefix = prefixer(is_subresult);
-
-  auto output_error = [](auto &err) {
-    std::cout << rang::fgB::red << rang::style::bold << "Couldn't read file because '" << err.what()
-              << "'" << rang::style::reset << std::endl;
-  };
-
-  std::visit(overload{
-                 [&](const std::monostate &) { std::cout << prefix() << std::endl; },
-                 [&](const FileContents::MultiLine &ml) {
-                   CachedFileReader::FileIter iter;
-                   try {
-                     iter = reader.read(contents.filename, ml.startline, ml.endline);
-                   } catch (std::system_error &err) {
-                     output_error(err);
-                     return;
-                   }
-                   print_lines_prefixed(iter.first, iter.second, prefix);
-                   std::cout << prefix() << std::endl;
-                 },
-                 [&](const FileContents::OneLineMarked &olm) {
-                   CachedFileReader::FileIter iter;
-                   try {
-                     iter = reader.read(contents.filename, olm.line, olm.line);
-                   } catch (std::system_error &err) {
-                     output_error(err);
-                     return;
-                   }
-                   if (iter.first == iter.second)
-                     return;
-                   const auto &line = *iter.first;
-                   const std::size_t ind = indentation(line);
-                   std::cout << prefix();
-                   std::size_t printed_len = print_line(line, ind);
-                   std::cout << std::endl;
-                   std::cout << prefix() << (is_subresult ? rang::fgB::cyan : rang::fgB::yellow)
-                             << rang::style::bold;
-                   const unsigned int start_col = olm.startcol - ind;
-                   const unsigned int end_col = olm.endcol ? olm.endcol.value() - ind
-                                                           : static_cast<unsigned int>(printed_len);
-                   print_marker(start_col, end_col);
-                   std::cout << rang::style::reset << std::endl;
-                 },
-             },
-             contents.region);
-}
-
-void file_position(const FileContents &contents) {
-  if (contents.is_empty())
-    return;
-
-  std::cout << rang::style::bold << contents.filename << ':';
-  std::visit(overload{
-                 [](const std::monostate &) {},
-                 [&](const FileContents::MultiLine &ml) {
-                   std::cout << ml.startline << '-' << ml.endline << ':';
-                 },
-                 [&](const FileContents::OneLineMarked &olm) {
-                   std::cout << olm.line << '.' << olm.startcol;
-                   if (olm.endcol)
-                     std::cout << '-' << olm.line << '.' << olm.endcol.value();
-                   std::cout << ':';
-                 },
-             },
-             contents.region);
-}
-
 std::vector<const LintResult::Sub *> notes_first(const std::vector<LintResult::Sub> &subres) {
   std::vector<const LintResult::Sub *> res;
   res.reserve(subres.size());
@@ -197,42 +81,222 @@ std::vector<const LintResult::Sub *> notes_first(const std::vector<LintResult::S
   return res;
 }
 
-void print_subresults(const LintResult &lintrule, CachedFileReader &reader) {
-  for (const auto *r : notes_first(lintrule.sub_results)) {
-    if (r->content.is_empty()) {
-      std::cout << rang::fgB::green << "NOTE: " << rang::style::reset << r->message << std::endl;
-    } else {
-      file_position(r->content);
-      std::cout << rang::style::reset;
-      std::cout << ' ' << r->message << std::endl;
-      print_code(r->content, reader, true);
+// Renders results into a buffer that is written to the stream whenever it holds a block, so that
+// the stream is neither written nor flushed line by line.
+class Renderer {
+  std::ostream &_os;
+  CachedFileReader &_reader;
+  const Palette &_colors;
+  std::string _buf;
+  std::vector<std::string_view> _lines; // of the rewrite being printed
+
+  Renderer &operator<<(std::string_view s) {
+    _buf.append(s);
+    return *this;
+  }
+  Renderer &operator<<(char c) {
+    _buf.push_back(c);
+    return *this;
+  }
+  Renderer &operator<<(unsigned int n) {
+    char digits[std::numeric_limits<unsigned int>::digits10 + 1];
+    _buf.append(digits, std::to_chars(digits, digits + sizeof(digits), n).ptr);
+    return *this;
+  }
+
+  // Appends the characters of `s` from `start` on, at most `maximum` of them with whitespace
+  // shown as spaces. Returns the number of characters appended.
+  std::size_t line(std::string_view s, std::size_t start = 0, std::size_t maximum = MAX_LINE) {
+    assert(maximum >= ELLIPSIS.size());
+    if (start >= s.size())
+      return 0;
+    const bool too_long = s.size() - start > maximum;
+    const std::size_t end = too_long ? maximum - ELLIPSIS.size() + start : s.size();
+    // TODO: handle the case of multi-byte characters
+
+    const std::size_t first = _buf.size();
+    _buf.append(s.substr(start, end - start));
+    std::replace_if(
+        _buf.begin() + static_cast<std::ptrdiff_t>(first), _buf.end(),
+        [](char c) { return std::isspace(static_cast<unsigned char>(c)); }, ' ');
+
+    if (too_long)
+      _buf.append(ELLIPSIS);
+
+    return end - start + (too_long ? ELLIPSIS.size() : 0);
+  }
+
+  void marker(unsigned int startcol, unsigned int endcol) {
+    assert(endcol >= startcol && startcol > 0 && endcol > 0);
+    _buf.append(std::min<std::size_t>(startcol - 1, MAX_LINE), ' ');
+    _buf.push_back('^');
+    if (endcol > startcol && startcol < MAX_LINE)
+      _buf.append(std::min<std::size_t>(endcol, MAX_LINE) - startcol, '~');
+  }
+
+  template <typename It, typename P> void lines_prefixed(It begin, It end, P &prefix) {
+    if (begin == end)
+      return;
+
+    const std::size_t lci = largest_common_indentation(begin, end);
+    for (; begin != end; ++begin) {
+      *this << prefix();
+      line(*begin, lci);
+      *this << '\n';
     }
   }
-}
 
-void print_one_result(const LintResult &r, CachedFileReader &reader) {
-  file_position(r.content);
-  std::cout << rang::style::reset;
-  if (!r.content.is_empty())
-    std::cout << ' ';
-  std::cout << r.message << rang::fgB::magenta << rang::style::bold << " [" << r.rule->name << '('
-            << r.rule->id << ")]" << rang::style::reset << std::endl;
-  print_code(r.content, reader);
-  if (r.rewrite) {
-    std::cout << "rewrite as: " << std::endl;
-    auto prefix = prefixer();
-    auto lines = split_lines(r.rewrite.value());
-    print_lines_prefixed(lines.cbegin(), lines.cend(), prefix);
-  }
-  print_subresults(r, reader);
-}
+  void code(const FileContents &contents, bool is_subresult = false) {
+    if (contents.is_empty())
+      return;
+
+    if (!contents.is_valid()) {
+      *this << _colors.error << "Couldn't print because file location is invalid"
+            << _colors.reset << '\n';
+      return;
+    }
+
+    auto prefix = prefixer(is_subresult);
+
+    auto output_error = [this](auto &err) {
+      *this << _colors.error << "Couldn't read file because '" << err.what() << '\''
+            << _colors.reset << '\n';
+    };
+
+    std::visit(overload{
+                   [&](const std::monostate &) { *this << prefix() << '\n'; },
+                   [&](const FileContents::MultiLine &ml) {
+                     CachedFileReader::FileIter iter;
+                     try {
+                       iter = _reader.read(contents.filename, ml.startline, ml.endline);
+                     } catch (std::system_error &err) {
+                       output_error(err);
+                       return;
+                     }
+                     lines_prefixed(iter.first, iter.second, prefix);
+                     *this << prefix() << '\n';
+                   },
+                   [&](const FileContents::OneLineMarked &olm) {
+                     CachedFileReader::FileIter iter;
+                     try {
+                       iter = _reader.read(contents.filename, olm.line, olm.line);
+                     } catch (std::system_error &err) {
+                       output_error(err);
+                       return;
+                     }
+                     if (iter.first == iter.second)
+                       return;
+                     const auto &text = *iter.first;
+                     const std::size_t ind = indentation(text);
+                     *this << prefix();
+                     std::size_t printed_len = line(text, ind);
+                     *this << '\n'
+                           << prefix() << (is_subresult ? _colors.sub_marker : _colors.marker);
+                     const unsigned int start_col = olm.startcol - ind;
+                     const unsigned int end_col = olm.endcol
+                                                      ? olm.endcol.value() - ind
+                                                      : static_cast<unsigned int>(printed_len);
+                     marker(start_col, end_col);
+                     *this << _colors.reset << '\n';
+                   },
+               },
+               contents.region);
+  }
+
+  void file_position(const FileContents &contents) {
+    if (contents.is_empty())
+      return;
+
+    *this << _colors.bold << contents.filename << ':';
+    std::visit(overload{
+                   [](const std::monostate &) {},
+                   [&](const FileContents::MultiLine &ml) {
+                     *this << ml.startline << '-' << ml.endline << ':';
+                   },
+                   [&](const FileContents::OneLineMarked &olm) {
+                     *this << olm.line << '.' << olm.startcol;
+                     if (olm.endcol)
+                       *this << '-' << olm.line << '.' << olm.endcol.value();
+                     *this << ':';
+                   },
+               },
+               contents.region);
+  }
+
+  void subresults(const LintResult &lintrule) {
+    for (const auto *r : notes_first(lintrule.sub_results)) {
+      if (r->content.is_empty()) {
+        *this << _colors.note << "NOTE: " << _colors.reset << r->message << '\n';
+      } else {
+        file_position(r->content);
+        *this << _colors.reset << ' ' << r->message << '\n';
+        code(r->content, true);
+      }
+    }
+  }
+
+  // The lines of `s`, without copying them. A last line without a newline counts too.
+  const std::vector<std::string_view> &split_lines(std::string_view s) {
+    _lines.clear();
+    while (!s.empty()) {
+      const std::size_t eol = std::min(s.find('\n'), s.size());
+      _lines.push_back(s.substr(0, eol));
+      s.remove_prefix(std::min(eol + 1, s.size()));
+    }
+    return _lines;
+  }
+
+public:
+  Renderer(std::ostream &os, CachedFileReader &reader)
+      : _os(os), _reader(reader), _colors(palette_for(os)) {
+    _buf.reserve(BLOCK_SIZE);
+  }
+
+  void result(const LintResult &r) {
+    file_position(r.content);
+    *this << _colors.reset;
+    if (!r.content.is_empty())
+      *this << ' ';
+    *this << r.message << _colors.rule << " [" << r.rule->name << '(' << r.rule->id << ")]"
+          << _colors.reset << '\n';
+    code(r.content);
+    if (r.rewrite) {
+      *this << "rewrite as: \n";
+      auto prefix = prefixer();
+      const auto &lines = split_lines(r.rewrite.value());
+      lines_prefixed(lines.cbegin(), lines.cend(), prefix);
+    }
+    subresults(r);
+
+    if (_buf.size() >= BLOCK_SIZE)
+      write();
+  }
+
+  void write() {
+    _os.write(_buf.data(), static_cast<std::streamsize>(_buf.size()));
+    _buf.clear();
+  }
+
+  // Writes what is left and flushes the stream.
+  void finish() {
+    write();
+    _os.flush();
+  }
+};
 } // namespace
 
 namespace LZN {
-void stdout_print(const std::vector<LintResult> &results) {
+void stdout_print(const std::vector<LintResult> &results, std::ostream &os) {
   CachedFileReader reader;
+  stdout_print(results, os, reader);
+}
+
+void stdout_print(const std::vector<LintResult> &results, std::ostream &os,
+                  CachedFileReader &reader) {
+  Renderer renderer(os, reader);
   for (auto &r : results) {
-    print_one_result(r, reader);
+    renderer.result(r);
   }
+  renderer.finish();
 }
 } // namespace LZN
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <iostream>
+#include <linter/file_utils.hpp>
 #include <linter/rules.hpp>
 #include <vector>
 
 namespace LZN {
-// Print all results in `results` to stdout with pretty colors.
-void stdout_print(const std::vector<LintResult> &results);
+// Print all results in `results` to stdout, or `os`, with pretty colors.
+void stdout_print(const std::vector<LintResult> &results, std::ostream &os = std::cout);
+// As above, but code is read through `reader`, which may know of files that aren't on disk.
+void stdout_print(const std::vector<LintResult> &results, std::ostream &os,
+                  CachedFileReader &reader);
 } // namespace LZN
@@ -0,0 +1,181 @@
+#include "timings.hpp"
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+using namespace LZN;
+
+const char *kind_name(Timings::Kind kind) {
+  switch (kind) {
+  case Timings::Kind::PHASE: return "phase";
+  case Timings::Kind::CACHE: return "cache";
+  case Timings::Kind::RULE: return "rule";
+  }
+  return "";
+}
+} // namespace
+
+namespace LZN {
+Timings::Scope::Scope(Timings *timings, Kind kind, std::string name, std::string first_used_by)
+    : _timings(timings), _kind(kind), _name(std::move(name)),
+      _first_used_by(std::move(first_used_by)),
+      _start(timings != nullptr ? timings->stamp() : Stamp()) {}
+
+Timings::Scope::~Scope() {
+  if (_timings == nullptr)
+    return;
+  Entry &e = _timings->add(_kind, _name, _start);
+  if (e.first_used_by.empty())
+    e.first_used_by = std::move(_first_used_by);
+}
+
+Timings::Stamp Timings::Stamp::with_memory() noexcept {
+  Stamp s = now();
+  s.memory = true;
+  s.allocated = alloc_counters();
+  s.outer_peak = restart_peak();
+  s.max_rss_kib = LZN::max_rss_kib();
+  return s;
+}
+
+Timings::Stamp Timings::stamp() const noexcept {
+  Stamp s = _memory ? Stamp::with_memory() : Stamp::now();
+  // Last, so that the counts leave out the stamp itself.
+  if (_counters != nullptr)
+    s.counters = _counters->read();
+  return s;
+}
+
+Timings::Entry &Timings::add(Kind kind, const std::string &name, const Stamp &start) {
+  std::optional<PerfCounters::Values> counters;
+  if (start.counters && _counters != nullptr)
+    counters = _counters->read();
+  const Stamp end = Stamp::now();
+  const std::string key = std::string(kind_name(kind)) + ' ' + name;
+  auto it = _index.find(key);
+  if (it == _index.end()) {
+    it = _index.emplace(key, _entries.size()).first;
+    _entries.push_back(Entry{kind, name, "", {}, {}, 0, std::nullopt, std::nullopt, std::nullopt});
+  }
+  Entry &e = _entries[it->second];
+  e.wall += end.wall - start.wall;
+  const double cpu_ms = 1000.0 * static_cast<double>(end.cpu - start.cpu) / CLOCKS_PER_SEC;
+  e.cpu += std::chrono::duration<double, std::milli>(cpu_ms);
+  ++e.calls;
+  if (counters) {
+    PerfCounters::Values &c = e.counters ? *e.counters : e.counters.emplace();
+    for (std::size_t i = 0; i < c.size(); ++i)
+      c[i] += (*counters)[i] - (*start.counters)[i];
+  }
+  if (start.memory) {
+    const AllocCounters allocated = alloc_counters();
+    const std::uint64_t peak = peak_live_bytes();
+    restore_peak(start.outer_peak);
+    Memory &m = e.memory ? *e.memory : e.memory.emplace();
+    m.allocations += allocated.allocations - start.allocated.allocations;
+    m.bytes += allocated.bytes - start.allocated.bytes;
+    m.peak = std::max(m.peak, peak > start.allocated.live ? peak - start.allocated.live : 0);
+    m.max_rss_kib += max_rss_kib() - start.max_rss_kib;
+  }
+  if (_trace != nullptr)
+    _trace->add(name, kind_name(kind), start.wall);
+  return e;
+}
+
+void Timings::print(std::ostream &os) const {
+  const auto flags = os.flags();
+  os << std::left << std::setw(6) << "kind" << std::setw(36) << "name" << std::right
+     << std::setw(11) << "wall ms" << std::setw(11) << "cpu ms" << std::setw(7) << "calls"
+     << std::setw(9) << "results" << "  first used by\n";
+  os << std::fixed << std::setprecision(2);
+  for (const auto &e : _entries) {
+    os << std::left << std::setw(6) << kind_name(e.kind) << std::setw(36) << e.name << std::right
+       << std::setw(11) << e.wall.count() << std::setw(11) << e.cpu.count() << std::setw(7)
+       << e.calls << std::setw(9);
+    if (e.results)
+      os << *e.results;
+    else
+      os << "";
+    if (!e.first_used_by.empty())
+      os << "  " << e.first_used_by;
+    os << '\n';
+  }
+  os.flags(flags);
+}
+
+void Timings::print_memory(std::ostream &os) const {
+  const auto flags = os.flags();
+  const auto mib = [](double bytes) { return bytes / (1024 * 1024); };
+  os << std::left << std::setw(6) << "kind" << std::setw(36) << "name" << std::right
+     << std::setw(13) << "allocations" << std::setw(14) << "allocated MiB" << std::setw(11)
+     << "peak MiB" << std::setw(15) << "max RSS +MiB" << '\n';
+  os << std::fixed << std::setprecision(2);
+  for (const auto &e : _entries) {
+    if (!e.memory)
+      continue;
+    const Memory &m = *e.memory;
+    os << std::left << std::setw(6) << kind_name(e.kind) << std::setw(36) << e.name << std::right
+       << std::setw(13) << m.allocations << std::setw(14) << mib(static_cast<double>(m.bytes))
+       << std::setw(11) << mib(static_cast<double>(m.peak)) << std::setw(15)
+       << static_cast<double>(m.max_rss_kib) / 1024 << '\n';
+  }
+  os.flags(flags);
+}
+
+void Timings::print_counters(std::ostream &os) const {
+  if (_counters == nullptr)
+    return;
+  const auto flags = os.flags();
+  os << std::left << std::setw(6) << "kind" << std::setw(36) << "name" << std::right;
+  for (std::size_t i = 0; i < PerfCounters::COUNT; ++i) {
+    if (_counters->available(static_cast<PerfCounters::Counter>(i)))
+      os << std::setw(15) << PerfCounters::NAMES[i];
+  }
+  os << '\n';
+  for (const auto &e : _entries) {
+    if (!e.counters)
+      continue;
+    os << std::left << std::setw(6) << kind_name(e.kind) << std::setw(36) << e.name << std::right;
+    for (std::size_t i = 0; i < PerfCounters::COUNT; ++i) {
+      if (_counters->available(static_cast<PerfCounters::Counter>(i)))
+        os << std::setw(15) << (*e.counters)[i];
+    }
+    os << '\n';
+  }
+  os.flags(flags);
+}
+
+Json Timings::to_json() const {
+  Json::Array entries;
+  for (const auto &e : _entries) {
+    Json j;
+    j.set("kind", kind_name(e.kind))
+        .set("name", e.name)
+        .set("wall_ms", e.wall.count())
+        .set("cpu_ms", e.cpu.count())
+        .set("calls", e.calls);
+    if (e.results)
+      j.set("results", *e.results);
+    if (!e.first_used_by.empty())
+      j.set("first_used_by", e.first_used_by);
+    if (e.memory) {
+      Json m;
+      m.set("allocations", e.memory->allocations)
+          .set("bytes", e.memory->bytes)
+          .set("peak_bytes", e.memory->peak)
+          .set("max_rss_kib", e.memory->max_rss_kib);
+      j.set("memory", std::move(m));
+    }
+    if (e.counters && _counters != nullptr) {
+      Json c;
+      for (std::size_t i = 0; i < PerfCounters::COUNT; ++i) {
+        if (_counters->available(static_cast<PerfCounters::Counter>(i)))
+          c.set(PerfCounters::NAMES[i], (*e.counters)[i]);
+      }
+      j.set("counters", std::move(c));
+    }
+    entries.push_back(std::move(j));
+  }
+  return entries;
+}
+} // namespace LZN
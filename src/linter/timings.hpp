@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <ctime>
+#include <cstdint>
+#include <linter/json.hpp>
+#include <linter/mem_stats.hpp>
+#include <linter/perf_counters.hpp>
+#include <linter/trace.hpp>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace LZN {
+// Wall and CPU time spent in the phases of a run, in each cached analysis of LintEnv and in each
+// rule, for `--timings`. Times of the same name add up, e.g. for a rule run in two environments.
+// Each span that is measured can also be added to a Trace on its own, for `--trace`. With
+// `memory`, what each span allocates is measured too, for `--mem-stats`, and with hardware
+// counters, what each span counts, for `--perf-counters`.
+class Timings {
+public:
+  enum class Kind { PHASE, CACHE, RULE };
+
+  // What a span allocated and how much memory it needed.
+  struct Memory {
+    std::uint64_t allocations = 0; // through operator new, see AllocCounters
+    std::uint64_t bytes = 0;       // allocated in total
+    std::uint64_t peak = 0;        // the most bytes live at once, above those live at the start
+    long max_rss_kib = 0;          // by how much the maximum resident set size grew
+  };
+
+  struct Entry {
+    Kind kind;
+    std::string name;
+    std::string first_used_by; // the rule that made a cache be built, if any
+    std::chrono::duration<double, std::milli> wall{0};
+    std::chrono::duration<double, std::milli> cpu{0};
+    unsigned int calls = 0;
+    std::optional<std::size_t> results; // found by a rule
+    std::optional<Memory> memory;       // added up, except for the peak, which is the largest
+    std::optional<PerfCounters::Values> counters; // added up
+  };
+
+  // A point in wall and CPU time, in memory if `memory` is set and in the hardware counters if
+  // they were read.
+  struct Stamp {
+    std::chrono::steady_clock::time_point wall;
+    std::clock_t cpu;
+    bool memory = false;
+    AllocCounters allocated{};
+    std::uint64_t outer_peak = 0; // of the enclosing span, see restart_peak
+    long max_rss_kib = 0;
+    std::optional<PerfCounters::Values> counters{};
+
+    static Stamp now() noexcept { return {std::chrono::steady_clock::now(), std::clock()}; }
+    // Also restarts the peak of live bytes, the stamp must be passed to `add` in reverse order
+    // of the other stamps with memory.
+    static Stamp with_memory() noexcept;
+  };
+
+  // Measures from its construction to its destruction, if it has a Timings to add to.
+  class Scope {
+    Timings *_timings;
+    Kind _kind;
+    std::string _name;
+    std::string _first_used_by;
+    Stamp _start;
+
+  public:
+    Scope(Timings *timings, Kind kind, std::string name, std::string first_used_by = "");
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+    ~Scope();
+  };
+
+  explicit Timings(bool memory = false) noexcept : _memory(memory) {}
+
+  // A stamp to start a span with, which measures what these timings measure.
+  Stamp stamp() const noexcept;
+
+  // Adds the time since `start` to the entry `name` of `kind`, creating it if it is new. If
+  // `start` measured memory or read the counters, so does the span.
+  Entry &add(Kind kind, const std::string &name, const Stamp &start);
+
+  const std::vector<Entry> &entries() const noexcept { return _entries; }
+
+  // Add every span that is measured to `trace` as well, or stop with nullptr.
+  void trace(Trace *trace) noexcept { _trace = trace; }
+  Trace *trace() const noexcept { return _trace; }
+
+  // Read `counters` around every span that is measured, or stop with nullptr.
+  void counters(const PerfCounters *counters) noexcept { _counters = counters; }
+
+  // Prints a table with a row for each entry, in the order they first ran.
+  void print(std::ostream &os) const;
+  // Prints a table with a row for each entry whose memory was measured.
+  void print_memory(std::ostream &os) const;
+  // Prints a table with a row for each entry whose hardware counters were read, with a column
+  // for each available counter.
+  void print_counters(std::ostream &os) const;
+  // The entries as an array of objects, for tools that collect timings.
+  Json to_json() const;
+
+private:
+  std::vector<Entry> _entries;
+  std::unordered_map<std::string, std::size_t> _index; // by kind and name
+  Trace *_trace = nullptr;
+  const PerfCounters *_counters = nullptr;
+  bool _memory;
+};
+} // namespace LZN
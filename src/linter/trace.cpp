@@ -0,0 +1,32 @@
+#include "trace.hpp"
+#include <functional>
+#include <thread>
+#include <unistd.h>
+
+namespace LZN {
+void Trace::add(std::string name, const char *category, Clock::time_point start, Json args) {
+  const Clock::time_point end = Clock::now();
+  using us = std::chrono::duration<double, std::micro>;
+  // Viewers want small numbers for thread ids, hashes only have to tell threads apart.
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id()) % 1000000;
+  Json event;
+  event.set("name", std::move(name))
+      .set("cat", category)
+      .set("ph", "X")
+      .set("ts", us(start - _origin).count())
+      .set("dur", us(end - start).count())
+      .set("pid", getpid())
+      .set("tid", tid);
+  if (!args.is_null())
+    event.set("args", std::move(args));
+  std::lock_guard<std::mutex> lock(_mutex);
+  _events.push_back(std::move(event));
+}
+
+Json Trace::to_json() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  Json j;
+  j.set("traceEvents", _events).set("displayTimeUnit", "ms");
+  return j;
+}
+} // namespace LZN
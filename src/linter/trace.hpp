@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+#include <linter/json.hpp>
+#include <mutex>
+#include <string>
+
+namespace LZN {
+// Events of a run in the Trace Event Format, for `--trace`. The file it writes can be loaded into
+// chrome://tracing or Perfetto to see which rule and which item the time goes to. Each event is
+// a span of the process and thread that added it, so spans of the same thread nest.
+class Trace {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  Trace() : _origin(Clock::now()) {}
+
+  // Adds the span `name` of `category` from `start` until now. May be called from any thread.
+  void add(std::string name, const char *category, Clock::time_point start, Json args = Json());
+
+  // The events as a JSON object with a "traceEvents" array.
+  Json to_json() const;
+
+private:
+  Clock::time_point _origin;
+  mutable std::mutex _mutex;
+  Json::Array _events;
+};
+} // namespace LZN
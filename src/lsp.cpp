@@ -0,0 +1,508 @@
+#include "lsp.hpp"
+#include "driver.hpp"
+#include "ipc.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <linter/file_utils.hpp>
+#include <linter/json.hpp>
+#include <linter/overload.hpp>
+#include <map>
+#include <optional>
+#include <poll.h>
+#include <sstream>
+#include <tuple>
+#include <unistd.h>
+#include <variant>
+
+namespace {
+using namespace LZN;
+
+// JSON-RPC error codes.
+constexpr int PARSE_ERROR = -32700;
+constexpr int INVALID_REQUEST = -32600;
+constexpr int METHOD_NOT_FOUND = -32601;
+constexpr int INVALID_PARAMS = -32602;
+
+// LSP constants.
+constexpr int SEVERITY_ERROR = 1;
+constexpr int SEVERITY_WARNING = 2;
+constexpr int SEVERITY_INFORMATION = 3;
+constexpr int SEVERITY_HINT = 4;
+constexpr int TAG_UNNECESSARY = 1;
+constexpr int SYNC_FULL = 1;
+
+struct RpcError {
+  int code;
+  std::string message;
+};
+
+// Reads and writes messages framed by a Content-Length header.
+class Channel {
+  int in_fd;
+  int out_fd;
+  std::string buffer;
+
+  // Returns the length of the content if `headers` has a valid Content-Length.
+  static std::optional<std::size_t> content_length(std::string_view headers) {
+    constexpr std::string_view name = "content-length:";
+    std::string lower(headers);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    const std::size_t at = lower.find(name);
+    if (at == std::string::npos)
+      return std::nullopt;
+    const char *start = lower.c_str() + at + name.size();
+    char *end = nullptr;
+    const unsigned long long n = std::strtoull(start, &end, 10);
+    if (end == start)
+      return std::nullopt;
+    return static_cast<std::size_t>(n);
+  }
+
+  bool fill() {
+    char chunk[65536];
+    while (true) {
+      const ssize_t n = ::read(in_fd, chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return false;
+      buffer.append(chunk, static_cast<std::size_t>(n));
+      return true;
+    }
+  }
+
+public:
+  Channel(int in_fd, int out_fd) : in_fd(in_fd), out_fd(out_fd) {}
+
+  // Returns the next message, or std::nullopt at end of input.
+  std::optional<std::string> read() {
+    while (true) {
+      const std::size_t end = buffer.find("\r\n\r\n");
+      if (end != std::string::npos) {
+        const auto length = content_length(std::string_view(buffer).substr(0, end));
+        const std::size_t start = end + 4;
+        if (!length) {
+          // Without a length there is no telling where the message ends, drop the headers.
+          buffer.erase(0, start);
+          continue;
+        }
+        if (buffer.size() - start >= *length) {
+          std::string body = buffer.substr(start, *length);
+          buffer.erase(0, start + *length);
+          return body;
+        }
+      }
+      if (!fill())
+        return std::nullopt;
+    }
+  }
+
+  // Returns true if another message has already arrived, at least partly.
+  bool has_pending() const {
+    if (!buffer.empty())
+      return true;
+    pollfd pfd{in_fd, POLLIN, 0};
+    return ::poll(&pfd, 1, 0) > 0;
+  }
+
+  void write(const Json &msg) {
+    const std::string body = msg.dump();
+    const std::string frame = "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    write_full(out_fd, frame.data(), frame.size());
+  }
+};
+
+std::string uri_to_path(std::string_view uri) {
+  constexpr std::string_view scheme = "file://";
+  if (uri.substr(0, scheme.size()) == scheme)
+    uri.remove_prefix(scheme.size());
+  auto is_hex = [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; };
+  std::string path;
+  for (std::size_t i = 0; i < uri.size(); ++i) {
+    if (uri[i] == '%' && i + 3 <= uri.size() && is_hex(uri[i + 1]) && is_hex(uri[i + 2])) {
+      path.push_back(static_cast<char>(std::stoi(std::string(uri.substr(i + 1, 2)), nullptr, 16)));
+      i += 2;
+    } else {
+      path.push_back(uri[i]);
+    }
+  }
+  return path;
+}
+
+std::string path_to_uri(std::string_view path) {
+  return "file://" + percent_encode_path(path);
+}
+
+// The lines of a document, to find where lines end.
+using Lines = std::vector<std::string_view>;
+
+Lines split_lines(std::string_view text) {
+  Lines lines;
+  std::size_t start = 0;
+  while (start <= text.size()) {
+    std::size_t end = text.find('\n', start);
+    if (end == std::string_view::npos)
+      end = text.size();
+    std::string_view line = text.substr(start, end - start);
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    lines.push_back(line);
+    start = end + 1;
+  }
+  return lines;
+}
+
+// The number of UTF-16 code units in the first `bytes` bytes of the UTF-8 `line`.
+std::size_t utf16_length(std::string_view line, std::size_t bytes) {
+  std::size_t units = 0;
+  for (std::size_t i = 0; i < std::min(bytes, line.size()); ++i) {
+    const auto c = static_cast<unsigned char>(line[i]);
+    if ((c & 0xC0) != 0x80) // the first byte of a character
+      units += c >= 0xF0 ? 2 : 1;
+  }
+  return units;
+}
+
+Json position(unsigned int line, std::size_t character) {
+  return Json::Object{{"line", line}, {"character", character}};
+}
+
+// The LSP range of `content`. Lines and columns in MiniZinc start at 1, count bytes and end
+// columns are inclusive. `lines` are the lines of the file if they are known, to find where lines
+// end and, if `utf16`, to count columns in UTF-16 code units.
+Json to_range(const FileContents &content, const Lines *lines, bool utf16) {
+  auto known = [lines](unsigned int line) {
+    return lines != nullptr && line > 0 && line <= lines->size();
+  };
+  auto column = [&](unsigned int line, std::size_t bytes) {
+    return utf16 && known(line) ? utf16_length((*lines)[line - 1], bytes) : bytes;
+  };
+  auto line_end = [&](unsigned int line) -> std::size_t {
+    return known(line) ? column(line, (*lines)[line - 1].size()) : 0;
+  };
+  auto range = [](Json start, Json end) {
+    return Json::Object{{"start", std::move(start)}, {"end", std::move(end)}};
+  };
+  return std::visit(
+      overload{
+          [&](const std::monostate &) { return range(position(0, 0), position(0, 0)); },
+          [&](const FileContents::OneLineMarked &olm) {
+            const unsigned int line = olm.line > 0 ? olm.line - 1 : 0;
+            const std::size_t start = column(olm.line, olm.startcol > 0 ? olm.startcol - 1 : 0);
+            const std::size_t end = olm.endcol ? column(olm.line, *olm.endcol) : line_end(olm.line);
+            return range(position(line, start), position(line, std::max(start, end)));
+          },
+          [&](const FileContents::MultiLine &ml) {
+            const unsigned int start = ml.startline > 0 ? ml.startline - 1 : 0;
+            const unsigned int end = ml.endline > 0 ? ml.endline - 1 : 0;
+            return range(position(start, 0), position(end, line_end(ml.endline)));
+          },
+      },
+      content.region);
+}
+
+bool ranges_overlap(const Json &a, const Json &b) {
+  auto pos = [](const Json &p) {
+    return std::make_tuple(p["line"].as_int(), p["character"].as_int());
+  };
+  return !(pos(a["end"]) < pos(b["start"]) || pos(b["end"]) < pos(a["start"]));
+}
+
+int severity(Category cat) {
+  switch (cat) {
+  case Category::CHALLENGE:
+  case Category::PERFORMANCE: return SEVERITY_WARNING;
+  case Category::STYLE:
+  case Category::UNSURE: return SEVERITY_INFORMATION;
+  case Category::REDUNDANT: return SEVERITY_HINT;
+  }
+  return SEVERITY_INFORMATION;
+}
+
+struct Document {
+  std::string path;
+  std::string text;
+  std::int64_t version = 0;
+  bool dirty = true;
+  std::vector<LintResult> results;
+  std::optional<std::string> error; // why the document couldn't be (fully) linted
+  IncrementalLinter linter;         // reuses results between versions of the document
+};
+
+class Server {
+  const Arguments &args;
+  Channel &channel;
+  std::map<std::string, Document> documents; // by uri
+  bool shutdown_requested = false;
+  bool utf16 = true; // whether positions count UTF-16 code units rather than bytes
+  std::optional<int> exit_status;
+
+  Json diagnostic(const LintResult &r, const Lines &lines) const {
+    Json diag = Json::Object{
+        {"range", to_range(r.content, &lines, utf16)},
+        {"severity", severity(r.rule->category)},
+        {"code", r.rule->name},
+        {"source", "lzn"},
+    };
+    std::string message = r.message;
+    Json related = Json::Array();
+    for (const auto &sub : r.sub_results) {
+      if (sub.content.filename.empty()) {
+        message += "\nNOTE: " + sub.message;
+        continue;
+      }
+      related.push_back(Json::Object{
+          {"location", Json::Object{{"uri", path_to_uri(sub.content.filename)},
+                                    {"range", to_range(sub.content, nullptr, utf16)}}},
+          {"message", sub.message},
+      });
+    }
+    diag.set("message", std::move(message));
+    if (!related.as_array().empty())
+      diag.set("relatedInformation", std::move(related));
+    if (r.rule->category == Category::REDUNDANT)
+      diag.set("tags", Json::Array{TAG_UNNECESSARY});
+    return diag;
+  }
+
+  // The position of the first "path:line.col" in a MiniZinc error message.
+  static Json error_range(const std::string &error, const std::string &path) {
+    const std::size_t at = error.find(path + ":");
+    unsigned int line = 0;
+    if (at != std::string::npos) {
+      const char *start = error.c_str() + at + path.size() + 1;
+      line = static_cast<unsigned int>(std::strtoul(start, nullptr, 10));
+    }
+    const unsigned int l = line > 0 ? line - 1 : 0;
+    return Json::Object{{"start", position(l, 0)}, {"end", position(l + 1, 0)}};
+  }
+
+  void publish(const std::string &uri, const Document &doc) {
+    Json diagnostics = Json::Array();
+    if (doc.error) {
+      diagnostics.push_back(Json::Object{
+          {"range", error_range(*doc.error, doc.path)},
+          {"severity", SEVERITY_ERROR},
+          {"source", "lzn"},
+          {"message", *doc.error},
+      });
+    }
+    const Lines lines = split_lines(doc.text);
+    for (const auto &r : doc.results) {
+      if (r.content.filename == doc.path || r.content.is_empty())
+        diagnostics.push_back(diagnostic(r, lines));
+    }
+    notify("textDocument/publishDiagnostics",
+           Json::Object{{"uri", uri}, {"version", doc.version}, {"diagnostics", diagnostics}});
+  }
+
+  void lint(const std::string &uri, Document &doc) {
+    std::ostringstream err;
+    bool typechecked = true;
+    auto results = lint_results(args, doc.path, {}, err, doc.text, &doc.linter, &typechecked);
+    if (results) {
+      // A document with type errors still gets the results of the rules that don't use types.
+      doc.results = std::move(*results);
+      doc.error.reset();
+      if (!typechecked)
+        doc.error = err.str();
+    } else {
+      doc.results.clear();
+      doc.error = err.str();
+    }
+    doc.dirty = false;
+    publish(uri, doc);
+  }
+
+  Document &document(const Json &params) {
+    const auto it = documents.find(params["textDocument"]["uri"].as_string());
+    if (it == documents.end())
+      throw RpcError{INVALID_PARAMS, "unknown document"};
+    return it->second;
+  }
+
+  void did_change(const Json &params) {
+    Document &doc = document(params);
+    // With full sync every change holds the whole text of the document.
+    for (const auto &change : params["contentChanges"].as_array())
+      doc.text = change["text"].as_string();
+    doc.version = params["textDocument"]["version"].as_int();
+    doc.dirty = true;
+  }
+
+  Json code_actions(const Json &params) {
+    const std::string &uri = params["textDocument"]["uri"].as_string();
+    const Document &doc = document(params);
+    const Lines lines = split_lines(doc.text);
+    Json actions = Json::Array();
+    for (const auto &r : doc.results) {
+      if (!r.rewrite || r.content.filename != doc.path)
+        continue;
+      Json range = to_range(r.content, &lines, utf16);
+      if (!ranges_overlap(range, params["range"]))
+        continue;
+      Json edit = Json::Object{{"range", range}, {"newText", *r.rewrite}};
+      actions.push_back(Json::Object{
+          {"title", std::string("Rewrite as: ") + *r.rewrite},
+          {"kind", "quickfix"},
+          {"diagnostics", Json::Array{diagnostic(r, lines)}},
+          {"edit", Json::Object{{"changes", Json::Object{{uri, Json::Array{std::move(edit)}}}}}},
+      });
+    }
+    return actions;
+  }
+
+  // Returns the result of a request, or nothing for notifications.
+  Json dispatch(const std::string &method, const Json &params) {
+    if (method == "initialize") {
+      // MiniZinc counts columns in bytes, so use UTF-8 positions if the client can.
+      const Json &encodings = params["capabilities"]["general"]["positionEncodings"];
+      if (encodings.is_array()) {
+        const auto &array = encodings.as_array();
+        utf16 = std::find(array.begin(), array.end(), Json("utf-8")) == array.end();
+      }
+      Json capabilities = Json::Object{
+          {"textDocumentSync", Json::Object{{"openClose", true}, {"change", SYNC_FULL}}},
+          {"codeActionProvider", Json::Object{{"codeActionKinds", Json::Array{"quickfix"}}}},
+      };
+      if (!utf16)
+        capabilities.set("positionEncoding", "utf-8");
+      return Json::Object{
+          {"capabilities", std::move(capabilities)},
+          {"serverInfo", Json::Object{{"name", "lzn"}}},
+      };
+    }
+    if (method == "shutdown") {
+      shutdown_requested = true;
+      return nullptr;
+    }
+    if (method == "exit") {
+      exit_status = shutdown_requested ? EXIT_SUCCESS : EXIT_FAILURE;
+      return nullptr;
+    }
+    if (method == "textDocument/didOpen") {
+      const Json &td = params["textDocument"];
+      Document &doc = documents[td["uri"].as_string()];
+      doc.path = uri_to_path(td["uri"].as_string());
+      doc.text = td["text"].as_string();
+      doc.version = td["version"].as_int();
+      doc.dirty = true;
+      return nullptr;
+    }
+    if (method == "textDocument/didChange") {
+      did_change(params);
+      return nullptr;
+    }
+    if (method == "textDocument/didSave") {
+      // An included file may have changed on disk.
+      for (auto &[uri, doc] : documents)
+        doc.dirty = true;
+      return nullptr;
+    }
+    if (method == "textDocument/didClose") {
+      const std::string uri = params["textDocument"]["uri"].as_string();
+      documents.erase(uri);
+      notify("textDocument/publishDiagnostics",
+             Json::Object{{"uri", uri}, {"diagnostics", Json::Array()}});
+      return nullptr;
+    }
+    if (method == "textDocument/codeAction")
+      return code_actions(params);
+
+    throw RpcError{METHOD_NOT_FOUND, "unknown method: " + method};
+  }
+
+  void notify(const char *method, Json params) {
+    channel.write(
+        Json::Object{{"jsonrpc", "2.0"}, {"method", method}, {"params", std::move(params)}});
+  }
+
+  void respond_error(const Json &id, int code, const std::string &message) {
+    channel.write(Json::Object{{"jsonrpc", "2.0"},
+                               {"id", id},
+                               {"error", Json::Object{{"code", code}, {"message", message}}}});
+  }
+
+  void handle(const std::string &body) {
+    Json msg;
+    try {
+      msg = Json::parse(body);
+    } catch (const std::invalid_argument &e) {
+      respond_error(nullptr, PARSE_ERROR, e.what());
+      return;
+    }
+    if (!msg.is_object()) {
+      respond_error(nullptr, INVALID_REQUEST, "not an object");
+      return;
+    }
+
+    const Json &id = msg["id"];
+    const bool is_request = !id.is_null();
+    if (!msg["method"].is_string()) {
+      // A response to a request we never make, or garbage.
+      if (is_request && msg["result"].is_null() && msg["error"].is_null())
+        respond_error(id, INVALID_REQUEST, "missing method");
+      return;
+    }
+    const std::string &method = msg["method"].as_string();
+
+    try {
+      Json result = dispatch(method, msg["params"]);
+      if (is_request)
+        channel.write(Json::Object{{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}});
+    } catch (const RpcError &e) {
+      // Unknown notifications, such as "$/..." ones, are ignored.
+      if (is_request)
+        respond_error(id, e.code, e.message);
+    } catch (const std::bad_variant_access &) {
+      if (is_request)
+        respond_error(id, INVALID_PARAMS, "invalid parameters for " + method);
+    }
+  }
+
+public:
+  Server(const Arguments &args, Channel &channel) : args(args), channel(channel) {}
+
+  int run() {
+    while (!exit_status) {
+      auto body = channel.read();
+      if (!body)
+        return EXIT_FAILURE;
+      handle(*body);
+
+      // Lint once a burst of edits is over, rather than after each keystroke.
+      if (channel.has_pending())
+        continue;
+      for (auto &[uri, doc] : documents) {
+        if (doc.dirty)
+          lint(uri, doc);
+      }
+    }
+    return *exit_status;
+  }
+};
+} // namespace
+
+namespace LZN {
+int serve_lsp(const Arguments &args) {
+  // Anything printed to stdout, e.g. by libminizinc, would corrupt the protocol. Keep the real
+  // stdout for the protocol and send everything else to stderr.
+  std::cout.flush();
+  const int out_fd = ::dup(STDOUT_FILENO);
+  if (out_fd < 0 || ::dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+    std::perror("dup");
+    return EXIT_FAILURE;
+  }
+
+  Channel channel(STDIN_FILENO, out_fd);
+  Server server(args, channel);
+  const int status = server.run();
+  ::close(out_fd);
+  return status;
+}
+} // namespace LZN
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "argparse.hpp"
+
+namespace LZN {
+// Run a Language Server Protocol server on stdin and stdout until the client asks it to exit.
+// Open documents are kept in memory, linted when they change and their results are published as
+// diagnostics, with subresults as related information and rewrites as quick-fixes. Returns an exit
+// status for the process.
+int serve_lsp(const Arguments &args);
+} // namespace LZN
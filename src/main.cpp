@@ -1,13 +1,21 @@
 #include "argparse.hpp"
+#include "batch.hpp"
+#include "driver.hpp"
+#include "gitdiff.hpp"
+#include "lsp.hpp"
+#include "processpool.hpp"
+#include "project.hpp"
+#include "server.hpp"
+#include "shard.hpp"
+#include "watch.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
-#include <linter/registry.hpp>
-#include <linter/stdoutprinter.hpp>
-#include <minizinc/file_utils.hh>
-#include <minizinc/parser.hh>
-#include <minizinc/typecheck.hh>
+#include <iterator>
 
-int main(int argc, char *argv[]) {
-  const LZN::ArgRes res = LZN::parse_args(argc, argv);
+namespace {
+// Returns the exit status if `res` is an error or a request for help, which are handled here.
+std::optional<int> handle_non_arguments(const LZN::ArgRes &res) {
   if (auto err = std::get_if<LZN::ArgError>(&res); err != nullptr) {
     std::cerr << err->msg << std::endl;
     std::cerr << "print usage information with '--help'" << std::endl;
@@ -19,51 +27,99 @@ int main(int argc, char *argv[]) {
     return EXIT_SUCCESS;
   }
 
-  const LZN::Arguments args = std::get<LZN::Arguments>(res);
-  std::vector<std::string> filenames = {args.model_filename};
-
-  // parse and typecheck
-  MiniZinc::GCLock lock;
-  std::vector<std::string> includePaths = {
-      MiniZinc::FileUtils::file_path(MiniZinc::FileUtils::share_directory()) + "/std/"};
-  std::stringstream errstream;
-  MiniZinc::Env env;
-  MiniZinc::Model *m = MiniZinc::parse(env, filenames, args.datafiles, "", "", includePaths, false,
-                                       false, false, false, errstream);
-
-  char empty_check;
-  if (errstream.readsome(&empty_check, 1) == 1) {
-    std::cerr << "parse errors:" << std::endl;
-    std::cerr << empty_check;
-    errstream >> std::cerr.rdbuf();
-  }
-  if (m == nullptr)
-    return EXIT_FAILURE;
+  return std::nullopt;
+}
 
-  std::vector<MiniZinc::TypeError> typeErrors;
-  try {
-    MiniZinc::typecheck(env, m, typeErrors, true, false);
-  } catch (MiniZinc::TypeError &te) {
-    typeErrors.push_back(te);
-    ;
+int lint(const LZN::Arguments &args) {
+  if (!args.git_diff.empty()) {
+    auto changed = LZN::git_changed_lines(args.git_diff, std::cerr);
+    if (!changed)
+      return EXIT_FAILURE;
+    LZN::Arguments with_changes = args;
+    with_changes.git_diff.clear();
+    if (!with_changes.changed_lines)
+      with_changes.changed_lines.emplace();
+    with_changes.changed_lines->insert(with_changes.changed_lines->end(), changed->begin(),
+                                       changed->end());
+    return lint(with_changes);
   }
-  if (!typeErrors.empty()) {
-    std::cerr << "type errors:" << std::endl;
-    for (auto &te : typeErrors) {
-      std::cerr << te.loc() << ":" << std::endl;
-      std::cerr << te.what() << ": " << te.msg() << std::endl;
+
+  if (!args.stats.empty()) {
+    if (args.model_filename == "-") {
+      const std::string text(std::istreambuf_iterator<char>(std::cin), {});
+      return LZN::print_census(args, LZN::STDIN_MODEL_NAME, args.datafiles, std::cout, std::cerr,
+                               text);
     }
+    return LZN::print_census(args, args.model_filename, args.datafiles, std::cout, std::cerr);
+  }
+
+  if (args.instances)
+    return LZN::lint_instances(args);
+
+  if (args.merge)
+    return LZN::merge_saved_shards(args);
+
+  if (!args.save_results.empty())
+    return LZN::save_shard(args);
+
+  if (args.project)
+    return LZN::lint_project(args);
+
+  if (args.jobs > 0 || args.shard_count > 0)
+    return LZN::lint_in_process_pool(args, args.models, std::max(args.jobs, 1U));
+
+  if (args.model_filename == "-") {
+    const std::string text(std::istreambuf_iterator<char>(std::cin), {});
+    return LZN::lint_model(args, LZN::STDIN_MODEL_NAME, args.datafiles, std::cout, std::cerr,
+                           text);
+  }
+
+  return LZN::lint_model(args, args.model_filename, args.datafiles, std::cout, std::cerr);
+}
+
+// Handles a request to the server.
+int handle_request(int argc, char *argv[]) {
+  const LZN::ArgRes res = LZN::parse_args(argc, argv);
+  if (auto status = handle_non_arguments(res))
+    return *status;
+
+  const LZN::Arguments &args = std::get<LZN::Arguments>(res);
+  if (!args.serve_socket.empty() || !args.connect_socket.empty() || args.lsp || args.watch) {
+    std::cerr << "'--serve', '--connect', '--lsp' and '--watch' can't be sent to a server"
+              << std::endl;
     return EXIT_FAILURE;
   }
+  return lint(args);
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const LZN::ArgRes res = LZN::parse_args(argc, argv);
+  if (auto status = handle_non_arguments(res))
+    return *status;
 
-  // run linter
-  LZN::LintEnv lenv(m, env, includePaths);
-  for (auto rule : LZN::Registry::iter()) {
-    if (!LZN::is_rule_ignored(args, *rule))
-      rule->run(lenv);
+  const LZN::Arguments args = std::get<LZN::Arguments>(res);
+
+  if (!args.serve_socket.empty())
+    return LZN::serve(args.serve_socket, handle_request);
+
+  if (args.lsp)
+    return LZN::serve_lsp(args);
+
+  if (args.watch)
+    return LZN::watch(args);
+
+  if (!args.connect_socket.empty()) {
+    if (auto status = LZN::run_on_server(args.connect_socket, args.forwarded_args))
+      return *status;
+    std::perror(args.connect_socket.c_str());
+    return EXIT_FAILURE;
   }
 
-  LZN::stdout_print(lenv.results());
+  if (const char *server = std::getenv("LZN_SERVER"); server != nullptr && *server != '\0') {
+    if (auto status = LZN::run_on_server(server, {argv + 1, argv + argc}))
+      return *status;
+  }
 
-  return EXIT_SUCCESS;
+  return lint(args);
 }
@@ -0,0 +1,262 @@
+#include "processpool.hpp"
+#include "driver.hpp"
+#include "ipc.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <linter/result_io.hpp>
+#include <new>
+#include <optional>
+#include <poll.h>
+#include <rang.hpp>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+using namespace LZN;
+
+// Messages from a worker to the parent.
+constexpr char MSG_STARTED = 'S'; // payload: model index
+constexpr char MSG_RESULT = 'R';  // payload: model index, status, stdout and stderr
+
+struct Worker {
+  pid_t pid;
+  int fd;                               // read end of the pipe from the worker, -1 when closed
+  std::optional<std::uint32_t> current; // the model currently being linted
+};
+
+[[noreturn]] void worker_main(std::uint32_t count, const Job &job,
+                              std::atomic<std::uint32_t> *queue, int fd, bool color) {
+  // rang only detects terminals on std::cout itself, the parent knows better.
+  rang::setControlMode(color ? rang::control::Force : rang::control::Off);
+
+  while (true) {
+    const std::uint32_t idx = queue->fetch_add(1);
+    if (idx >= count)
+      break;
+
+    std::string started;
+    put_u32(started, idx);
+    if (!write_message(fd, MSG_STARTED, started))
+      break;
+
+    std::ostringstream out;
+    std::ostringstream err;
+    int status;
+    try {
+      status = job(idx, out, err);
+    } catch (const std::exception &e) {
+      err << e.what() << std::endl;
+      status = EXIT_FAILURE;
+    }
+
+    std::string result;
+    put_u32(result, idx);
+    put_u32(result, static_cast<std::uint32_t>(status));
+    put_string(result, out.str());
+    put_string(result, err.str());
+    if (!write_message(fd, MSG_RESULT, result))
+      break;
+  }
+
+  ::close(fd);
+  // Skip static destructors, they belong to the parent.
+  ::_exit(EXIT_SUCCESS);
+}
+
+// Reads one message from `w`. Returns false and closes the worker's pipe on end-of-file or
+// failure.
+bool handle_message(Worker &w, const std::vector<std::string> &names,
+                    std::vector<std::optional<JobOutput>> &outputs) {
+  Message msg;
+  if (!read_message(w.fd, msg)) {
+    ::close(w.fd);
+    w.fd = -1;
+    if (w.current) {
+      outputs[*w.current] =
+          JobOutput{EXIT_FAILURE, "", "worker crashed while linting " + names[*w.current] + "\n"};
+      w.current.reset();
+    }
+    return false;
+  }
+
+  std::string_view payload = msg.payload;
+  try {
+    switch (msg.tag) {
+    case MSG_STARTED: w.current = take_u32(payload); break;
+    case MSG_RESULT: {
+      const std::uint32_t idx = take_u32(payload);
+      const int status = static_cast<int>(take_u32(payload));
+      std::string out = take_string(payload);
+      std::string err = take_string(payload);
+      if (idx < outputs.size())
+        outputs[idx] = JobOutput{status, std::move(out), std::move(err)};
+      w.current.reset();
+      break;
+    }
+    default: break;
+    }
+  } catch (const std::out_of_range &) {
+    // A malformed message, the job it was about is reported as never run.
+  }
+  return true;
+}
+} // namespace
+
+namespace LZN {
+void run_in_process_pool(const std::vector<std::string> &names, unsigned int jobs, const Job &job,
+                        const std::function<void(std::uint32_t, const JobOutput &)> &done) {
+  if (names.empty())
+    return;
+  if (jobs > names.size())
+    jobs = static_cast<unsigned int>(names.size());
+  const auto count = static_cast<std::uint32_t>(names.size());
+
+  // The shared queue is just the index of the next job to run.
+  void *shared = ::mmap(nullptr, sizeof(std::atomic<std::uint32_t>), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) {
+    std::perror("mmap");
+    for (std::uint32_t i = 0; i < count; ++i)
+      done(i, JobOutput{EXIT_FAILURE, "", ""});
+    return;
+  }
+  auto queue = new (shared) std::atomic<std::uint32_t>(0);
+
+  const bool color = ::isatty(STDOUT_FILENO) == 1;
+  // Don't let the workers inherit and print whatever is buffered.
+  std::cout.flush();
+  std::cerr.flush();
+
+  std::vector<Worker> workers;
+  for (unsigned int j = 0; j < jobs; ++j) {
+    int fds[2];
+    if (::pipe(fds) != 0) {
+      std::perror("pipe");
+      break;
+    }
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+      std::perror("fork");
+      ::close(fds[0]);
+      ::close(fds[1]);
+      break;
+    }
+    if (pid == 0) {
+      ::close(fds[0]);
+      for (const auto &w : workers)
+        ::close(w.fd);
+      worker_main(count, job, queue, fds[1], color);
+    }
+    ::close(fds[1]);
+    workers.push_back(Worker{pid, fds[0], std::nullopt});
+  }
+
+  std::vector<std::optional<JobOutput>> outputs(count);
+  std::uint32_t next_done = 0;
+  auto report_ready = [&]() {
+    for (; next_done < count && outputs[next_done]; ++next_done)
+      done(next_done, *outputs[next_done]);
+  };
+
+  while (true) {
+    std::vector<pollfd> fds;
+    std::vector<Worker *> polled;
+    for (auto &w : workers) {
+      if (w.fd >= 0) {
+        fds.push_back(pollfd{w.fd, POLLIN, 0});
+        polled.push_back(&w);
+      }
+    }
+    if (fds.empty())
+      break;
+
+    if (::poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      std::perror("poll");
+      break;
+    }
+
+    for (std::size_t i = 0; i < fds.size(); ++i) {
+      if (fds[i].revents != 0)
+        handle_message(*polled[i], names, outputs);
+    }
+    report_ready();
+  }
+
+  for (auto &w : workers) {
+    if (w.fd >= 0)
+      ::close(w.fd);
+    ::waitpid(w.pid, nullptr, 0);
+  }
+
+  for (std::uint32_t i = 0; i < count; ++i) {
+    if (!outputs[i])
+      outputs[i] = JobOutput{EXIT_FAILURE, "", "never linted: " + names[i] + "\n"};
+  }
+  report_ready();
+
+  ::munmap(shared, sizeof(std::atomic<std::uint32_t>));
+}
+
+std::vector<LintedJob> lint_each(
+    const std::vector<std::string> &names, unsigned int jobs,
+    const std::function<std::optional<std::vector<LintResult>>(std::uint32_t, std::ostream &err)>
+        &lint) {
+  const Job job = [&](std::uint32_t i, std::ostream &out, std::ostream &err) {
+    auto results = lint(i, err);
+    if (!results)
+      return EXIT_FAILURE;
+    std::string bytes;
+    put_results(bytes, *results);
+    out << bytes;
+    return EXIT_SUCCESS;
+  };
+
+  std::vector<LintedJob> linted(names.size());
+  auto done = [&](std::uint32_t i, const JobOutput &o) {
+    linted[i].err = o.err;
+    if (o.status != EXIT_SUCCESS)
+      return;
+    try {
+      std::string_view in = o.out;
+      linted[i].results = take_results(in);
+    } catch (const std::out_of_range &) {
+      linted[i].err += "invalid results from worker for " + names[i] + "\n";
+    }
+  };
+
+  if (jobs > 1) {
+    run_in_process_pool(names, jobs, job, done);
+  } else {
+    for (std::uint32_t i = 0; i < names.size(); ++i) {
+      std::ostringstream out;
+      std::ostringstream err;
+      const int status = job(i, out, err);
+      done(i, JobOutput{status, out.str(), err.str()});
+    }
+  }
+  return linted;
+}
+
+int lint_in_process_pool(const Arguments &args, const std::vector<std::string> &models,
+                        unsigned int jobs) {
+  int status = EXIT_SUCCESS;
+  run_in_process_pool(
+      models, jobs,
+      [&](std::uint32_t i, std::ostream &out, std::ostream &err) {
+        return lint_model(args, models[i], {}, out, err);
+      },
+      [&status](std::uint32_t, const JobOutput &o) {
+        std::cout << o.out << std::flush;
+        std::cerr << o.err << std::flush;
+        if (o.status != EXIT_SUCCESS)
+          status = EXIT_FAILURE;
+      });
+  return status;
+}
+} // namespace LZN
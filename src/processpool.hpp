@@ -0,0 +1,50 @@
+#pragma once
+
+#include "argparse.hpp"
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace LZN {
+// A pool of forked processes that run jobs side by side. Each process parses its models and the
+// standard library on its own, nothing parsed is shared between them.
+
+// What a job run by a worker printed, and its exit status.
+struct JobOutput {
+  int status;
+  std::string out;
+  std::string err;
+};
+
+// A job gets its index and streams for its output, and returns an exit status.
+using Job = std::function<int(std::uint32_t index, std::ostream &out, std::ostream &err)>;
+
+// Run `job` for every index of `names` in a pool of `jobs` forked worker processes. `done` is
+// called in the parent with the output of every job, in order of index, as soon as that job and
+// all before it have finished. A job whose worker crashed fails with a message about its name.
+void run_in_process_pool(const std::vector<std::string> &names, unsigned int jobs, const Job &job,
+                        const std::function<void(std::uint32_t, const JobOutput &)> &done);
+
+// The results of one job of lint_each, or nullopt if it failed, and what it printed to `err`.
+struct LintedJob {
+  std::optional<std::vector<LintResult>> results;
+  std::string err;
+};
+
+// Lints every index of `names` with `lint`, in a pool of `jobs` worker processes if more than one
+// and in this process otherwise. Workers send their results back with put_results.
+std::vector<LintedJob> lint_each(
+    const std::vector<std::string> &names, unsigned int jobs,
+    const std::function<std::optional<std::vector<LintResult>>(std::uint32_t, std::ostream &err)>
+        &lint);
+
+// Lint every model in `models` with a pool of `jobs` forked worker processes. Workers take models
+// from a shared queue and parse, typecheck and lint them on their own, so libminizinc never sees
+// more than one thread. The output of each model is printed in the same order as `models`.
+// Returns an exit status for the process, which is a failure if any model failed.
+int lint_in_process_pool(const Arguments &args, const std::vector<std::string> &models,
+                        unsigned int jobs);
+} // namespace LZN
@@ -0,0 +1,116 @@
+#include "project.hpp"
+#include "driver.hpp"
+#include "processpool.hpp"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <linter/file_utils.hpp>
+#include <linter/result_cache.hpp>
+#include <linter/result_io.hpp>
+#include <map>
+#include <set>
+#include <sstream>
+#include <system_error>
+#include <unordered_set>
+
+namespace {
+using namespace LZN;
+
+// The user files that at least two of `models` include, by canonical path.
+std::vector<std::string> shared_includes(const std::vector<std::string> &models,
+                                         const std::vector<std::string> &includePath) {
+  std::map<std::string, std::size_t> included_by;
+  for (const auto &model : models) {
+    std::set<std::string> files;
+    try {
+      for (const auto &file : included_user_files(model, includePath))
+        files.insert(canonical_path(file));
+    } catch (const std::system_error &) {
+      // Let the parser report the file that can't be read.
+    }
+    files.erase(canonical_path(model));
+    for (const auto &file : files)
+      ++included_by[file];
+  }
+
+  std::vector<std::string> shared;
+  for (const auto &[file, count] : included_by) {
+    if (count > 1)
+      shared.push_back(file);
+  }
+  return shared;
+}
+} // namespace
+
+namespace LZN {
+int lint_project(const Arguments &args) {
+  const std::vector<const LintRule *> rules = enabled_rules(args);
+  std::vector<const LintRule *> item_rules;
+  std::copy_if(rules.begin(), rules.end(), std::back_inserter(item_rules),
+               [](const LintRule *rule) { return rule->scope == Scope::ITEM; });
+
+  const std::vector<std::string> shared = shared_includes(args.models, stdlib_include_paths());
+  const std::unordered_set<std::string> all_shared(shared.begin(), shared.end());
+
+  // Each shared file leaves the others to themselves. Its errors don't matter, a file that needs
+  // declarations from the models including it is simply linted with them.
+  std::vector<LintedJob> of_shared;
+  if (!item_rules.empty()) {
+    of_shared = lint_each(shared, args.jobs, [&](std::uint32_t i, std::ostream &) {
+      std::unordered_set<std::string> others = all_shared;
+      others.erase(shared[i]);
+      std::ostringstream ignored;
+      Focus focus;
+      focus.skipped_files = &others;
+      return lint_results(item_rules, shared[i], {}, ignored, std::nullopt, nullptr, focus,
+                          Monitor(), args.cache_dir);
+    });
+  }
+
+  std::unordered_set<std::string> linted;
+  for (std::size_t i = 0; i < of_shared.size(); ++i) {
+    if (of_shared[i].results)
+      linted.insert(shared[i]);
+  }
+
+  const std::vector<LintedJob> of_models =
+      lint_each(args.models, args.jobs, [&](std::uint32_t i, std::ostream &err) {
+        Focus focus;
+        focus.skipped_files = &linted;
+        return lint_results(rules, args.models[i], {}, err, std::nullopt, nullptr, focus,
+                            Monitor(), args.cache_dir);
+      });
+
+  // JSON and SARIF are one document for the whole project, other formats are printed model by
+  // model.
+  const bool one_document = args.format == "json" || args.format == "sarif";
+  CachedFileReader reader;
+  std::set<ResultKey> printed;
+  std::vector<LintResult> fresh;
+  auto print_new = [&](const std::vector<LintResult> &results) {
+    std::copy_if(results.begin(), results.end(), std::back_inserter(fresh),
+                 [&printed](const LintResult &r) { return printed.insert(key_of(r)).second; });
+    if (!one_document) {
+      print_results(args, fresh, std::cout, reader);
+      fresh.clear();
+    }
+  };
+
+  for (const auto &s : of_shared) {
+    if (s.results)
+      print_new(*s.results);
+  }
+
+  int status = EXIT_SUCCESS;
+  for (const auto &m : of_models) {
+    std::cerr << m.err << std::flush;
+    if (m.results)
+      print_new(*m.results);
+    else
+      status = EXIT_FAILURE;
+  }
+  if (one_document)
+    print_results(args, fresh, std::cout, reader);
+  return status;
+}
+} // namespace LZN
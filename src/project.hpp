@@ -0,0 +1,13 @@
+#pragma once
+
+#include "argparse.hpp"
+
+namespace LZN {
+// Lint every model of `args.models` as one project, in `args.jobs` worker processes if given.
+// User files that several models include are linted once on their own with the rules that look at
+// single items, whose results there don't depend on the model, and those rules skip them when the
+// models are linted. A shared file that can't be loaded on its own is linted with each model
+// instead. The results of the shared files are printed first, then those of each model, and every
+// result only once. Returns an exit status for the process, which is a failure if any model failed.
+int lint_project(const Arguments &args);
+} // namespace LZN
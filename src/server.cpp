@@ -0,0 +1,206 @@
+#include "server.hpp"
+#include "ipc.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <rang.hpp>
+#include <sstream>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+using namespace LZN;
+
+// Messages from a client to the server.
+constexpr char MSG_REQUEST = 'Q'; // payload: color, cwd, stdin and the arguments
+// Messages from the server to a client.
+constexpr char MSG_STDOUT = 'o'; // payload: output
+constexpr char MSG_STDERR = 'e'; // payload: output
+constexpr char MSG_EXIT = 'x';   // payload: exit status
+
+// Any local user may connect, so a request may not make the server allocate more than this.
+constexpr std::uint32_t MAX_REQUEST_SIZE = 64 * 1024 * 1024;
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void request_stop(int) {
+  stop_requested = 1;
+}
+
+// Redirects the standard streams for as long as it lives.
+class StreamRedirect {
+  std::istringstream in;
+  MessageStreamBuf out;
+  MessageStreamBuf err;
+  std::streambuf *old_in;
+  std::streambuf *old_out;
+  std::streambuf *old_err;
+
+public:
+  StreamRedirect(int fd, std::string input)
+      : in(std::move(input)), out(fd, MSG_STDOUT), err(fd, MSG_STDERR),
+        old_in(std::cin.rdbuf(in.rdbuf())), old_out(std::cout.rdbuf(&out)),
+        old_err(std::cerr.rdbuf(&err)) {}
+  ~StreamRedirect() {
+    std::cout.flush();
+    std::cerr.flush();
+    std::cin.rdbuf(old_in);
+    std::cout.rdbuf(old_out);
+    std::cerr.rdbuf(old_err);
+  }
+};
+
+int handle_request(int fd, RequestHandler handler) {
+  Message msg;
+  if (!read_message(fd, msg, MAX_REQUEST_SIZE) || msg.tag != MSG_REQUEST)
+    return EXIT_FAILURE;
+
+  bool color;
+  std::string cwd;
+  std::string input;
+  std::vector<std::string> args = {"lzn"};
+  try {
+    std::string_view payload = msg.payload;
+    color = take_u32(payload) != 0;
+    cwd = take_string(payload);
+    input = take_string(payload);
+    for (std::uint32_t n = take_u32(payload); n > 0; --n)
+      args.push_back(take_string(payload));
+  } catch (const std::out_of_range &) {
+    return EXIT_FAILURE;
+  }
+
+  rang::setControlMode(color ? rang::control::Force : rang::control::Off);
+
+  int status = EXIT_FAILURE;
+  {
+    StreamRedirect redirect(fd, std::move(input));
+    if (::chdir(cwd.c_str()) != 0) {
+      std::cerr << "server couldn't change to directory '" << cwd << "': " << std::strerror(errno)
+                << std::endl;
+    } else {
+      std::vector<char *> argv;
+      for (auto &a : args)
+        argv.push_back(a.data());
+      argv.push_back(nullptr);
+      try {
+        status = handler(static_cast<int>(args.size()), argv.data());
+      } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+      }
+    }
+  }
+
+  std::string exit_status;
+  put_u32(exit_status, static_cast<std::uint32_t>(status));
+  write_message(fd, MSG_EXIT, exit_status);
+  return status;
+}
+} // namespace
+
+namespace LZN {
+int serve(const std::string &socket_path, RequestHandler handler) {
+  const int listener = listen_unix(socket_path);
+  if (listener < 0) {
+    std::perror(socket_path.c_str());
+    return EXIT_FAILURE;
+  }
+
+  // Children are never waited for, and a client that goes away must not take the server with it.
+  struct sigaction ignore = {};
+  ignore.sa_handler = SIG_IGN;
+  ::sigaction(SIGCHLD, &ignore, nullptr);
+  ::sigaction(SIGPIPE, &ignore, nullptr);
+  // Without SA_RESTART, so that accept is interrupted.
+  struct sigaction stop = {};
+  stop.sa_handler = request_stop;
+  ::sigaction(SIGINT, &stop, nullptr);
+  ::sigaction(SIGTERM, &stop, nullptr);
+
+  std::cout.flush();
+  std::cerr.flush();
+
+  int status = EXIT_SUCCESS;
+  while (!stop_requested) {
+    const int conn = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+    if (conn < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      std::perror("accept");
+      status = EXIT_FAILURE;
+      break;
+    }
+
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+      std::perror("fork");
+    } else if (pid == 0) {
+      ::close(listener);
+      struct sigaction dfl = {};
+      dfl.sa_handler = SIG_DFL;
+      for (int sig : {SIGCHLD, SIGINT, SIGTERM})
+        ::sigaction(sig, &dfl, nullptr);
+      handle_request(conn, handler);
+      ::close(conn);
+      // Skip static destructors, they belong to the server.
+      ::_exit(EXIT_SUCCESS);
+    }
+    ::close(conn);
+  }
+
+  ::close(listener);
+  ::unlink(socket_path.c_str());
+  return status;
+}
+
+std::optional<int> run_on_server(const std::string &socket_path,
+                                 const std::vector<std::string> &args) {
+  const int fd = connect_unix(socket_path);
+  if (fd < 0)
+    return std::nullopt;
+
+  // Only read stdin if the model is to be read from it.
+  std::string input;
+  if (std::find(args.begin(), args.end(), "-") != args.end())
+    input.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+
+  std::string request;
+  put_u32(request, ::isatty(STDOUT_FILENO) == 1 ? 1 : 0);
+  put_string(request, std::filesystem::current_path().string());
+  put_string(request, input);
+  put_u32(request, static_cast<std::uint32_t>(args.size()));
+  for (const auto &a : args)
+    put_string(request, a);
+  if (!write_message(fd, MSG_REQUEST, request)) {
+    ::close(fd);
+    return std::nullopt;
+  }
+
+  Message msg;
+  while (read_message(fd, msg)) {
+    switch (msg.tag) {
+    case MSG_STDOUT: std::cout << msg.payload << std::flush; break;
+    case MSG_STDERR: std::cerr << msg.payload << std::flush; break;
+    case MSG_EXIT: {
+      ::close(fd);
+      std::string_view payload = msg.payload;
+      try {
+        return static_cast<int>(take_u32(payload));
+      } catch (const std::out_of_range &) {
+        return EXIT_FAILURE;
+      }
+    }
+    default: break;
+    }
+  }
+
+  ::close(fd);
+  std::cerr << "lost the connection to the server" << std::endl;
+  return EXIT_FAILURE;
+}
+} // namespace LZN
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace LZN {
+// Handles the command line of one request, as main would.
+using RequestHandler = int (*)(int argc, char *argv[]);
+
+// Serve lint requests on the Unix domain socket `socket_path` until interrupted. Every connection
+// is handled by a forked copy of the server, with the client's working directory, stdin, stdout and
+// stderr, by calling `handler` with the client's arguments. Forking keeps each request on one
+// thread as libminizinc requires. Nothing parsed outlives a request, so only the process start-up
+// is saved.
+// Returns an exit status for the process.
+int serve(const std::string &socket_path, RequestHandler handler);
+
+// Let the server on `socket_path` handle `args` and copy its output to stdout and stderr. Returns
+// the exit status of the request, or std::nullopt if no server could be reached.
+std::optional<int> run_on_server(const std::string &socket_path,
+                                 const std::vector<std::string> &args);
+} // namespace LZN
@@ -0,0 +1,82 @@
+#include "shard.hpp"
+#include "driver.hpp"
+#include "processpool.hpp"
+#include <iostream>
+#include <linter/file_utils.hpp>
+#include <linter/result_io.hpp>
+#include <set>
+#include <system_error>
+
+namespace LZN {
+int save_shard(const Arguments &args) {
+  const std::vector<LintedJob> linted =
+      lint_each(args.models, args.jobs, [&](std::uint32_t i, std::ostream &err) {
+        return lint_results(args, args.models[i], {}, err);
+      });
+
+  ShardResults shard;
+  if (args.shard_count > 0) {
+    shard.index = args.shard_index;
+    shard.count = args.shard_count;
+  }
+  for (std::size_t i = 0; i < linted.size(); ++i) {
+    std::cerr << linted[i].err << std::flush;
+    if (!linted[i].results) {
+      shard.failed.push_back(args.models[i]);
+      continue;
+    }
+    shard.results.insert(shard.results.end(), linted[i].results->begin(),
+                         linted[i].results->end());
+  }
+
+  if (!write_file_atomically(args.save_results, put_shard(shard))) {
+    std::cerr << "couldn't write results to " << args.save_results << std::endl;
+    return EXIT_FAILURE;
+  }
+  return shard.failed.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int merge_saved_shards(const Arguments &args) {
+  int status = EXIT_SUCCESS;
+  std::vector<ShardResults> shards;
+  for (const auto &filename : args.models) {
+    try {
+      shards.push_back(take_shard(read_file(filename)));
+    } catch (const std::system_error &e) {
+      std::cerr << filename << ": " << e.code().message() << std::endl;
+      status = EXIT_FAILURE;
+    } catch (const std::out_of_range &) {
+      std::cerr << filename << ": not results saved by this version of lzn" << std::endl;
+      status = EXIT_FAILURE;
+    }
+  }
+
+  std::set<unsigned int> counts;
+  std::set<unsigned int> present;
+  for (const auto &shard : shards) {
+    counts.insert(shard.count);
+    present.insert(shard.index);
+    for (const auto &model : shard.failed) {
+      std::cerr << "model " << model << " couldn't be linted in shard " << shard.index << "/"
+                << shard.count << std::endl;
+      status = EXIT_FAILURE;
+    }
+  }
+  if (counts.size() > 1) {
+    std::cerr << "shards of runs split in different ways can't be merged" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!counts.empty()) {
+    for (unsigned int i = 1; i <= *counts.begin(); ++i) {
+      if (present.count(i) == 0) {
+        std::cerr << "shard " << i << "/" << *counts.begin() << " is missing" << std::endl;
+        status = EXIT_FAILURE;
+      }
+    }
+  }
+
+  CachedFileReader reader;
+  print_results(args, merge_shards(std::move(shards)), std::cout, reader);
+  return status;
+}
+} // namespace LZN
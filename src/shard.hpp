@@ -0,0 +1,16 @@
+#pragma once
+
+#include "argparse.hpp"
+
+namespace LZN {
+// Lint every model of `args.models`, in `args.jobs` worker processes if given, and write the
+// results to `args.save_results` for lzn --merge, as shard `args.shard_index` of
+// `args.shard_count`. Errors are printed to stderr and the models that failed are recorded.
+// Returns an exit status for the process, which is a failure if any model failed.
+int save_shard(const Arguments &args);
+
+// Read the shards in `args.models`, written by save_shard, and print their results sorted and with
+// every result only once. Returns an exit status for the process, which is a failure if a shard
+// can't be read, is missing or has models that failed.
+int merge_saved_shards(const Arguments &args);
+} // namespace LZN
@@ -0,0 +1,282 @@
+#include "watch.hpp"
+#include "driver.hpp"
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <linter/file_utils.hpp>
+#include <linter/incremental.hpp>
+#include <linter/overload.hpp>
+#include <linter/result_cache.hpp>
+#include <linter/searcher.hpp>
+#include <linter/stdoutprinter.hpp>
+#include <map>
+#include <poll.h>
+#include <set>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+using namespace LZN;
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+// Changes that arrive within this long of each other are handled by a single run.
+constexpr int DEBOUNCE_MS = 100;
+
+// Editors often save by writing a new file and renaming it over the old one, which a watch on the
+// file itself doesn't survive. The directories of the files are watched instead.
+constexpr std::uint32_t DIR_EVENTS =
+    IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+
+std::string normalized(const std::string &path) {
+  std::error_code ec;
+  const fs::path abs = fs::absolute(path, ec);
+  return (ec ? fs::path(path) : abs).lexically_normal().string();
+}
+
+// The user files included by `model`, transitively.
+std::vector<std::string> included_files(const MiniZinc::Model *model,
+                                        const std::vector<std::string> &includePath) {
+  std::vector<std::string> files;
+  const auto s = SearchBuilder().only_user_defined(includePath).recursive().in_include().build();
+  auto ms = s.search(model);
+  while (ms.next()) {
+    const auto *inc = ms.cur_item()->cast<MiniZinc::IncludeI>();
+    if (s.is_user_defined_include(inc))
+      files.emplace_back(inc->m()->filepath().c_str());
+  }
+  return files;
+}
+
+// Identifies a result across runs. Lines are identified by their text rather than their number,
+// so that results that only moved because lines were added or removed above them are the same.
+std::string identity(const LintResult &r, CachedFileReader &reader) {
+  std::string id = std::to_string(r.rule->id) + '\0' + r.message + '\0' + r.content.filename;
+  auto add_lines = [&](unsigned int start, unsigned int end) {
+    try {
+      auto [it, last] = reader.read(r.content.filename, start, end);
+      for (; it != last; ++it)
+        id.append(1, '\0').append(*it);
+    } catch (const std::system_error &) {
+      id.append(1, '\0').append(std::to_string(start));
+    }
+  };
+  std::visit(overload{
+                 [](const std::monostate &) {},
+                 [&](const FileContents::OneLineMarked &olm) {
+                   add_lines(olm.line, olm.line);
+                   id += '\0' + std::to_string(olm.startcol) + ':' +
+                         std::to_string(olm.endcol.value_or(0));
+                 },
+                 [&](const FileContents::MultiLine &ml) { add_lines(ml.startline, ml.endline); },
+             },
+             r.content.region);
+  return id;
+}
+
+std::string first_line(const FileContents &content) {
+  return std::visit(
+      overload{
+          [](const std::monostate &) { return std::string("?"); },
+          [](const FileContents::OneLineMarked &olm) { return std::to_string(olm.line); },
+          [](const FileContents::MultiLine &ml) { return std::to_string(ml.startline); },
+      },
+      content.region);
+}
+
+class Watcher {
+  const Arguments &args;
+  const std::vector<std::string> includePath = stdlib_include_paths();
+  IncrementalLinter linter; // keeps the results of unchanged items between runs
+
+  int fd = -1;
+  std::map<std::string, int> dirs; // watched directory -> watch descriptor
+  std::map<int, std::string> wds;
+  std::set<std::string> files; // normalized paths of the files to lint again for
+
+  std::map<std::string, std::string> previous; // identity -> a description of the result
+  bool first_run = true;
+
+  // Watch exactly the directories of `new_files`.
+  bool watch_files(const std::vector<std::string> &new_files) {
+    files.clear();
+    std::set<std::string> new_dirs;
+    for (const auto &f : new_files) {
+      files.insert(normalized(f));
+      new_dirs.insert(fs::path(normalized(f)).parent_path().string());
+    }
+
+    for (auto it = dirs.begin(); it != dirs.end();) {
+      if (new_dirs.count(it->first) == 0) {
+        ::inotify_rm_watch(fd, it->second);
+        wds.erase(it->second);
+        it = dirs.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (const auto &dir : new_dirs) {
+      if (dirs.count(dir) > 0)
+        continue;
+      const int wd = ::inotify_add_watch(fd, dir.c_str(), DIR_EVENTS);
+      if (wd < 0) {
+        std::perror(dir.c_str());
+        continue;
+      }
+      dirs.emplace(dir, wd);
+      wds[wd] = dir;
+    }
+    return !dirs.empty();
+  }
+
+  // Lint once, print what changed and return the files to watch.
+  std::vector<std::string> run(const std::string &reason) {
+    std::vector<std::string> watched{args.model_filename};
+    watched.insert(watched.end(), args.datafiles.begin(), args.datafiles.end());
+
+    const auto start = Clock::now();
+    std::optional<std::vector<LintResult>> results;
+    {
+      MiniZinc::GCLock lock;
+      MiniZinc::Env env;
+      const auto rules = enabled_rules(args);
+      MiniZinc::Model *m = load_model(env, args.model_filename,
+                                      needed_datafiles(rules, args.datafiles), includePath,
+                                      std::cerr);
+      if (m != nullptr) {
+        const auto included = included_files(m, includePath);
+        watched.insert(watched.end(), included.begin(), included.end());
+        results = linter.lint(m, env, includePath, rules);
+      }
+    }
+    const auto ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+
+    if (!results) {
+      // Still follow the includes that can be found, one of them may be what's broken.
+      try {
+        const auto included = included_user_files(args.model_filename, includePath);
+        watched.insert(watched.end(), included.begin(), included.end());
+      } catch (const std::system_error &) {}
+      std::cout << "--- " << reason << ": failed after " << ms << " ms" << std::endl;
+      return watched;
+    }
+
+    CachedFileReader reader;
+    std::map<std::string, std::string> current;
+    std::vector<LintResult> fresh;
+    for (auto &r : *results) {
+      std::string id = identity(r, reader);
+      if (current.count(id) > 0)
+        continue;
+      const std::string where = r.content.filename + ":" + first_line(r.content);
+      current.emplace(id, r.rule->name + std::string(": ") + r.message + " (" + where + ")");
+      if (first_run || previous.count(id) == 0)
+        fresh.push_back(std::move(r));
+    }
+    std::size_t fixed = 0;
+    for (const auto &entry : previous)
+      fixed += current.count(entry.first) == 0 ? 1 : 0;
+
+    std::cout << "--- " << reason << ": linted in " << ms << " ms, " << current.size()
+              << " results";
+    if (!first_run)
+      std::cout << " (" << fresh.size() << " new, " << fixed << " fixed)";
+    std::cout << std::endl;
+    stdout_print(fresh, std::cout, reader);
+    for (const auto &[id, description] : previous) {
+      if (current.count(id) == 0)
+        std::cout << "fixed: " << description << '\n';
+    }
+    std::cout << std::flush;
+
+    previous = std::move(current);
+    first_run = false;
+    return watched;
+  }
+
+  // Reads the pending events and returns the first watched file that changed, if any.
+  std::optional<std::string> read_events() {
+    alignas(struct inotify_event) char buf[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+    std::optional<std::string> changed;
+    const ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n <= 0)
+      return changed;
+    for (const char *p = buf; p < buf + n;) {
+      const auto *ev = reinterpret_cast<const struct inotify_event *>(p);
+      p += sizeof(struct inotify_event) + ev->len;
+      if ((ev->mask & IN_Q_OVERFLOW) != 0 && !changed) {
+        changed = args.model_filename;
+        continue;
+      }
+      auto dir = wds.find(ev->wd);
+      if (dir == wds.end() || ev->len == 0)
+        continue;
+      const std::string path = (fs::path(dir->second) / ev->name).string();
+      if (!changed && files.count(path) > 0) {
+        std::error_code ec;
+        const fs::path relative = fs::relative(path, ec);
+        changed = ec ? path : relative.string();
+      }
+    }
+    return changed;
+  }
+
+  // Blocks until a watched file changes and no further change has arrived for a while. Returns
+  // nullopt if waiting failed.
+  std::optional<std::string> wait_for_change() {
+    std::optional<std::string> changed;
+    while (true) {
+      struct pollfd pfd = {fd, POLLIN, 0};
+      const int ready = ::poll(&pfd, 1, changed ? DEBOUNCE_MS : -1);
+      if (ready < 0 && errno == EINTR)
+        continue;
+      if (ready < 0)
+        return std::nullopt;
+      if (ready == 0)
+        return changed;
+      auto path = read_events();
+      if (!changed)
+        changed = std::move(path);
+    }
+  }
+
+public:
+  explicit Watcher(const Arguments &args) : args(args) {}
+  ~Watcher() {
+    if (fd >= 0)
+      ::close(fd);
+  }
+
+  int loop() {
+    fd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd < 0) {
+      std::perror("inotify");
+      return EXIT_FAILURE;
+    }
+
+    std::string reason = "initial run";
+    while (true) {
+      if (!watch_files(run(reason))) {
+        std::cerr << "nothing left to watch" << std::endl;
+        return EXIT_FAILURE;
+      }
+      auto changed = wait_for_change();
+      if (!changed) {
+        std::perror("watch");
+        return EXIT_FAILURE;
+      }
+      reason = *changed + " changed";
+    }
+  }
+};
+} // namespace
+
+namespace LZN {
+int watch(const Arguments &args) {
+  return Watcher(args).loop();
+}
+} // namespace LZN
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "argparse.hpp"
+
+namespace LZN {
+// Lint the model and data files of `args`, then watch them and every user file the model includes
+// and lint again whenever they change. After the first run only the results that are new or gone
+// are printed. Runs until it is interrupted or watching fails, returns an exit status for the
+// process.
+int watch(const Arguments &args);
+} // namespace LZN
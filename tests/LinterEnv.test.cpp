@@ -84,3 +84,60 @@ TEST_CASE("every_index_touched", "[lintenv]") {
 
   LZN_TEST_CASE_END;
 }
+
+TEST_CASE("budget", "[lintenv]") {
+  LZN_TEST_CASE_INIT(13);
+  LZN_ONLY_PARSE("var int: a;\n"
+                 "var int: b;\n"
+                 "var int: c;\n");
+  LZN::Budget budget;
+  lenv.budget(&budget);
+
+  SECTION("no limits") {
+    rule->run(lenv);
+    CHECK(lenv.results().size() == 3);
+    CHECK(budget.results == 3);
+    CHECK(budget.cut_short.empty());
+  }
+
+  SECTION("results") {
+    budget.max_results = 2;
+    rule->run(lenv);
+    CHECK(lenv.results().size() == 2);
+    REQUIRE(budget.cut_short.size() == 1);
+    CHECK(budget.cut_short[0] == rule);
+
+    // Later rules are stopped before they start.
+    rule->run(lenv);
+    CHECK(lenv.results().size() == 2);
+    CHECK(budget.cut_short.size() == 2);
+  }
+
+  SECTION("time") {
+    budget.rule_time = std::chrono::milliseconds(60000);
+    rule->run(lenv);
+    CHECK(lenv.results().size() == 3);
+    CHECK(budget.cut_short.empty());
+  }
+  LZN_TEST_CASE_END;
+}
+
+TEST_CASE("budget with rules that report what they didn't find", "[lintenv]") {
+  LZN_TEST_CASE_INIT(1);
+  // Long enough that a search looks at the clock before it gets to the uses of `a` and `b`.
+  std::string text = "var int: a;\n"
+                     "var int: b;\n"
+                     "constraint a = b";
+  for (int i = 0; i < 4096; ++i)
+    text += " + 0";
+  text += ";\n";
+  LZN_ONLY_PARSE(text);
+  LZN::Budget budget;
+  budget.rule_time = std::chrono::milliseconds(0);
+  lenv.budget(&budget);
+
+  rule->run(lenv);
+  REQUIRE(budget.cut_short.size() == 1);
+  CHECK(lenv.results().empty());
+  LZN_TEST_CASE_END;
+}
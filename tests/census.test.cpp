@@ -0,0 +1,47 @@
+#include "test_common.hpp"
+#include <linter/census.hpp>
+
+TEST_CASE("census", "[util]") {
+  LZN_MODEL_INIT
+  LZN_ONLY_PARSE("array[1..3] of int: a = [1, 2, 3];\n"
+                 "var 1..3: x;\n"
+                 "var bool: b;\n"
+                 "constraint sum(i in 1..3 where i > 1)(a[i] * x) > 2 \\/ b;\n"
+                 "solve satisfy;\n");
+
+  const LZN::Census census = LZN::take_census(model, includePaths);
+  CHECK(census.user_items == 5);
+  CHECK(census.stdlib_items > 0);
+  CHECK(census.items.at("declaration") == 3);
+  CHECK(census.items.at("constraint") == 1);
+  CHECK(census.items.at("solve") == 1);
+  CHECK(census.var_decls == 2);
+  CHECK(census.par_decls == 1);
+
+  CHECK(census.comprehensions == 1);
+  CHECK(census.generators == 1);
+  CHECK(census.expressions.at("comprehension") == 1);
+  CHECK(census.expressions.at("array access") == 1);
+  CHECK(census.expressions.at("call") >= 1);
+  bool counted_mult = false;
+  for (const auto &[op, n] : census.operators)
+    counted_mult = counted_mult || (op.find('*') != std::string::npos && n == 1);
+  CHECK(counted_mult);
+
+  CHECK(census.literal_arrays == 1);
+  CHECK(census.literal_array_elements == 3);
+  CHECK(census.largest_literal_array == 3);
+  CHECK(census.sized_arrays == 1);
+  CHECK(census.largest_sized_array == 3);
+
+  // \/, >, sum, the comprehension and * are above a[i].
+  CHECK(census.max_depth >= 6);
+  CHECK(census.average_depth() > 1);
+  CHECK(census.average_depth() <= census.max_depth);
+
+  std::ostringstream table;
+  census.print(table);
+  CHECK(table.str().find("comprehensions") != std::string::npos);
+  const LZN::Json j = census.to_json();
+  CHECK(j["user_items"].as_int() == 5);
+}
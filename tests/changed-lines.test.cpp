@@ -0,0 +1,74 @@
+#include "test_common.hpp"
+#include <filesystem>
+#include <linter/changed_lines.hpp>
+
+TEST_CASE("parse unified diff", "[changes]") {
+  const char *diff = "diff --git a/model.mzn b/model.mzn\n"
+                     "index 1111111..2222222 100644\n"
+                     "--- a/model.mzn\n"
+                     "+++ b/model.mzn\n"
+                     "@@ -3 +3 @@ var int: x;\n"
+                     "-constraint x > 1;\n"
+                     "+constraint x > 2;\n"
+                     "@@ -10,0 +11,3 @@\n"
+                     "+++ a\n"
+                     "+b\n"
+                     "+c\n"
+                     "@@ -20,2 +23,0 @@\n"
+                     "-gone\n"
+                     "-too\n"
+                     "diff --git a/old.mzn b/old.mzn\n"
+                     "deleted file mode 100644\n"
+                     "--- a/old.mzn\n"
+                     "+++ /dev/null\n"
+                     "@@ -1 +0,0 @@\n"
+                     "-old\n"
+                     "--- a/lib/my lib.mzn\n"
+                     "+++ b/lib/my lib.mzn\t\n"
+                     "@@ -0,0 +1 @@\n"
+                     "+new\n";
+
+  const auto ranges = LZN::parse_unified_diff(diff, "/repo");
+  REQUIRE(ranges.size() == 4);
+  CHECK(ranges[0].file == "/repo/model.mzn");
+  CHECK((ranges[0].first == 3 && ranges[0].last == 3));
+  CHECK((ranges[1].first == 11 && ranges[1].last == 13));
+  CHECK((ranges[2].first == 23 && ranges[2].last == 23));
+  CHECK(ranges[3].file == "/repo/lib/my lib.mzn");
+  CHECK((ranges[3].first == 1 && ranges[3].last == 1));
+}
+
+TEST_CASE("changed lines", "[changes]") {
+  const std::string absolute = (std::filesystem::current_path() / MODEL_FILENAME).string();
+  const LZN::ChangedLines changed({{MODEL_FILENAME, 3, 4}, {"other.mzn", 1, 100}});
+
+  CHECK(changed.overlaps(absolute, 4, 8));
+  CHECK(changed.overlaps(std::string("./") + MODEL_FILENAME, 1, 3));
+  CHECK_FALSE(changed.overlaps(MODEL_FILENAME, 5, 8));
+  CHECK_FALSE(changed.overlaps("unchanged.mzn", 1, 100));
+
+  LZN_MODEL_INIT
+  LZN_ONLY_PARSE("var int: x;\n"             // 1
+                 "var int: y;\n"             // 2
+                 "constraint x < y;\n"       // 3
+                 "constraint x > 1 /\\\n"    // 4
+                 "    y > 2;\n"              // 5
+                 "constraint x + y < 10;\n"  // 6
+                 "solve satisfy;\n");        // 7
+
+  const auto items = changed.items(model, includePaths);
+  REQUIRE(items.size() == 2);
+  std::vector<unsigned int> lines;
+  for (auto item : items)
+    lines.push_back(item->loc().firstLine());
+  std::sort(lines.begin(), lines.end());
+  CHECK(lines == std::vector<unsigned int>{3, 4});
+
+  const LZN::LintRule *rule = *LZN::Registry::iter().begin();
+  CHECK(changed.overlaps(LZN_ONELINE(3, 1, 5)));
+  CHECK_FALSE(changed.overlaps(LZN_ONELINE(6, 1, 5)));
+  CHECK(changed.overlaps(LZN::LintResult(LZN::FileContents::MultiLine{1, 3}, MODEL_FILENAME, rule,
+                                         "")));
+  CHECK(changed.overlaps(LZN::LintResult(LZN::FileContents::MultiLine{5, 7}, "other.mzn", rule,
+                                         "")));
+}
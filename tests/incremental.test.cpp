@@ -0,0 +1,93 @@
+#include "test_common.hpp"
+#include <linter/incremental.hpp>
+#include <memory>
+
+namespace {
+// One parsed and typechecked version of a model.
+struct Version {
+  std::unique_ptr<MiniZinc::Env> env = std::make_unique<MiniZinc::Env>();
+  MiniZinc::Model *model = nullptr;
+};
+
+Version parse(const std::string &text, const std::vector<std::string> &includePaths) {
+  Version v;
+  std::stringstream errstream;
+  v.model = MiniZinc::parse(*v.env, {}, {}, text, MODEL_FILENAME, includePaths, false, false, false,
+                            false, errstream);
+  REQUIRE(v.model != nullptr);
+  std::vector<MiniZinc::TypeError> typeErrors;
+  MiniZinc::typecheck(*v.env, v.model, typeErrors, true, false);
+  REQUIRE(typeErrors.empty());
+  return v;
+}
+
+std::vector<const LZN::LintRule *> all_rules() {
+  std::vector<const LZN::LintRule *> rules;
+  for (auto rule : LZN::Registry::iter())
+    rules.push_back(rule);
+  return rules;
+}
+
+std::vector<LZN::LintResult> lint_fully(Version &v, const std::vector<std::string> &includePaths) {
+  LZN::LintEnv lenv(v.model, *v.env, includePaths);
+  for (auto rule : LZN::Registry::iter())
+    rule->run(lenv);
+  return lenv.take_results();
+}
+
+// Checks that incremental results are the same as those of a full run.
+void check_same(std::vector<LZN::LintResult> incremental, std::vector<LZN::LintResult> full) {
+  REQUIRE(incremental.size() == full.size());
+  std::sort(incremental.begin(), incremental.end());
+  std::sort(full.begin(), full.end());
+  for (std::size_t i = 0; i < full.size(); ++i) {
+    CHECK(incremental[i] == full[i]);
+    CHECK(incremental[i].message == full[i].message);
+  }
+}
+
+const char *const MODEL = "var 0..1: b;\n"
+                          "var 0..9: x = if b then 3 else 0 endif;\n"
+                          "constraint x div 2 = 1;\n"
+                          "constraint b -> x > 2;\n"
+                          "solve satisfy;\n";
+} // namespace
+
+TEST_CASE("incremental linting", "[incremental]") {
+  const std::vector<std::string> includePaths = {"../../deps/libminizinc/share/minizinc/std/"};
+  LZN::IncrementalLinter linter;
+  const auto rules = all_rules();
+
+  Version first = parse(MODEL, includePaths);
+  check_same(linter.lint(first.model, *first.env, includePaths, rules),
+             lint_fully(first, includePaths));
+  CHECK(linter.stats().reused == 0);
+  const std::size_t items = linter.stats().items;
+
+  SECTION("moved items are reused") {
+    Version moved = parse(std::string("var 0..3: y;\n") + MODEL, includePaths);
+    check_same(linter.lint(moved.model, *moved.env, includePaths, rules),
+               lint_fully(moved, includePaths));
+    CHECK(linter.stats().items == items + 1);
+    CHECK(linter.stats().reused == items);
+  }
+
+  SECTION("only the edited item is relinted") {
+    std::string text = MODEL;
+    text.replace(text.find("x div 2"), 7, "x div 3");
+    Version edited = parse(text, includePaths);
+    check_same(linter.lint(edited.model, *edited.env, includePaths, rules),
+               lint_fully(edited, includePaths));
+    CHECK(linter.stats().items == items);
+    CHECK(linter.stats().reused == items - 1);
+  }
+
+  SECTION("a changed type makes users dirty") {
+    std::string text = MODEL;
+    text.replace(text.find("var 0..1: b"), 11, "bool: b = true");
+    Version edited = parse(text, includePaths);
+    check_same(linter.lint(edited.model, *edited.env, includePaths, rules),
+               lint_fully(edited, includePaths));
+    CHECK(linter.stats().reused < items - 1);
+  }
+}
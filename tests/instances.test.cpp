@@ -0,0 +1,60 @@
+#include "test_common.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+namespace fs = std::filesystem;
+
+const char *const MODEL = "int: n;\n"
+                          "array[0..n] of int: c;\n"
+                          "array[0..n] of var 0..1: b;\n"
+                          "var int: x;\n"
+                          "var 0..n: y = if b[0] == 1 then n else 0 endif;\n"
+                          "constraint forall(i in 1..n where b[i] > c[i])(b[i] = 1);\n"
+                          "constraint sum(i in 0..n)(bool2int(b[i] = 1)) <= x;\n"
+                          "solve satisfy;\n";
+
+std::vector<LZN::LintResult> lint(const std::vector<std::string> &datafiles, LZN::Data data) {
+  const std::vector<std::string> includePaths = {"../../deps/libminizinc/share/minizinc/std/"};
+  std::stringstream errstream;
+  MiniZinc::Env env;
+  MiniZinc::Model *model = MiniZinc::parse(env, {}, datafiles, MODEL, MODEL_FILENAME, includePaths,
+                                           false, false, false, false, errstream);
+  REQUIRE(model != nullptr);
+  std::vector<MiniZinc::TypeError> typeErrors;
+  MiniZinc::typecheck(env, model, typeErrors, true, false);
+  REQUIRE(typeErrors.empty());
+
+  LZN::LintEnv lenv(model, env, includePaths);
+  for (auto rule : LZN::Registry::iter()) {
+    if (rule->data == data)
+      rule->run(lenv);
+  }
+  auto results = lenv.take_results();
+  std::sort(results.begin(), results.end());
+  return results;
+}
+} // namespace
+
+TEST_CASE("rules that don't use the data", "[instances]") {
+  const fs::path dir = fs::temp_directory_path() / "lzn-test-instances";
+  fs::create_directories(dir);
+  const std::string small = (dir / "small.dzn").string();
+  const std::string large = (dir / "large.dzn").string();
+  std::ofstream(small) << "n = 1; c = array1d(0..1, [0, 1]); x = 2;\n";
+  std::ofstream(large) << "n = 3; c = array1d(0..3, [1, 0, 1, 0]);\n";
+
+  const auto without_data = lint({}, LZN::Data::UNUSED);
+  REQUIRE_FALSE(without_data.empty());
+  for (const auto &datafile : {small, large}) {
+    const auto with_data = lint({datafile}, LZN::Data::UNUSED);
+    REQUIRE(with_data.size() == without_data.size());
+    for (std::size_t i = 0; i < with_data.size(); ++i) {
+      CHECK(with_data[i] == without_data[i]);
+      CHECK(with_data[i].message == without_data[i].message);
+    }
+  }
+
+  // `x` is only assigned by the data of one instance.
+  CHECK(lint({small}, LZN::Data::USED) != lint({large}, LZN::Data::USED));
+}
@@ -0,0 +1,44 @@
+#include <catch2/catch.hpp>
+#include <linter/json.hpp>
+#include <sstream>
+#include <stdexcept>
+
+TEST_CASE("json round trip", "[util]") {
+  const char *text = R"({"a":1,"b":[true,false,null],"c":{"d":"e\n\"f\""},"g":-2.5})";
+  const LZN::Json j = LZN::Json::parse(text);
+  CHECK(j["a"].as_int() == 1);
+  CHECK(j["b"].as_array().size() == 3);
+  CHECK(j["b"].as_array()[2].is_null());
+  CHECK(j["c"]["d"].as_string() == "e\n\"f\"");
+  CHECK(j["g"].as_double() == -2.5);
+  CHECK(j["missing"].is_null());
+  CHECK(j["c"]["d"]["nested"].is_null());
+  CHECK(j.dump() == text);
+}
+
+TEST_CASE("json building", "[util]") {
+  LZN::Json j;
+  j.set("id", 3).set("name", "x").set("list", LZN::Json::Array{1, "two"});
+  j.set("id", 4);
+  CHECK(j.dump() == R"({"id":4,"name":"x","list":[1,"two"]})");
+
+  LZN::Json arr;
+  arr.push_back(LZN::Json::Object{{"k", 0.5}});
+  CHECK(arr.dump() == R"([{"k":0.5}])");
+}
+
+TEST_CASE("json strings", "[util]") {
+  CHECK(LZN::Json::parse(R"("å😀\t")").as_string() == "\xc3\xa5\xf0\x9f\x98\x80\t");
+  std::ostringstream os;
+  LZN::write_json_string(os, std::string("a\x01/", 3));
+  CHECK(os.str() == R"("a\u0001/")");
+}
+
+TEST_CASE("json errors", "[util]") {
+  CHECK_THROWS_AS(LZN::Json::parse(""), std::invalid_argument);
+  CHECK_THROWS_AS(LZN::Json::parse("{\"a\" 1}"), std::invalid_argument);
+  CHECK_THROWS_AS(LZN::Json::parse("[1,]"), std::invalid_argument);
+  CHECK_THROWS_AS(LZN::Json::parse("\"open"), std::invalid_argument);
+  CHECK_THROWS_AS(LZN::Json::parse("1 2"), std::invalid_argument);
+  CHECK_THROWS_AS(LZN::Json::parse(std::string(1000, '[')), std::invalid_argument);
+}
@@ -59,6 +59,22 @@ TEST_CASE("one based arrays", "[rule]") {
     LZN_EXPECTED(LZN_ONELINE(1, 7, 10), LZN_ONELINE(1, 13, 16), LZN_ONELINE(1, 19, 22));
   }
 
+  SECTION("okay array from data") {
+    LZN_MODEL_DATA("int: n;\n"
+                   "set of int: S;\n"
+                   "array[S] of var int: xs;",
+                   "n = 5; S = 1..n;");
+    LZN_EXPECTED();
+  }
+
+  SECTION("bad array from data") {
+    LZN_MODEL_DATA("int: n;\n"
+                   "set of int: S;\n"
+                   "array[S] of var int: xs;",
+                   "n = 5; S = 2..n;");
+    LZN_EXPECTED(LZN_ONELINE(3, 7, 7));
+  }
+
   SECTION("array with no explicit set") {
     LZN_MODEL("array[int] of var int: xs;");
     LZN_EXPECTED();
@@ -0,0 +1,167 @@
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <linter/file_utils.hpp>
+#include <linter/registry.hpp>
+#include <linter/result_cache.hpp>
+#include <linter/result_io.hpp>
+
+namespace {
+namespace fs = std::filesystem;
+using FC = LZN::FileContents;
+
+void write(const fs::path &p, const char *contents) {
+  fs::create_directories(p.parent_path());
+  std::ofstream(p) << contents;
+}
+
+// Writes a model with includes and a data file to `dir`.
+void make_project(const fs::path &dir) {
+  write(dir / "std" / "globals.mzn", "predicate foo(var int: x);\n");
+  write(dir / "model.mzn", "include \"globals.mzn\";\n"
+                           "include \"lib/a.mzn\";\n"
+                           "var 1..3: x;\n");
+  write(dir / "lib" / "a.mzn", "include \"b.mzn\";\n");
+  write(dir / "lib" / "b.mzn", "var 1..3: y;\n");
+  write(dir / "data.dzn", "n = 3;\n");
+}
+
+std::vector<LZN::LintResult> sample_results() {
+  const LZN::LintRule *rule = *LZN::Registry::iter().begin();
+  std::vector<LZN::LintResult> results;
+  results.emplace_back(FC::OneLineMarked(3, 1, 12), "model.mzn", rule, "first");
+  auto &second = results.emplace_back(FC::MultiLine(1, 2), "lib/b.mzn", rule, "second");
+  second.rewrite = "var 1..2: y;";
+  second.emplace_subresult("here", FC::OneLineMarked(4, 2), "model.mzn");
+  second.emplace_subresult("a note");
+  second.depends_on_instance = true;
+  results.emplace_back(std::monostate(), "", rule, "third");
+  return results;
+}
+
+void check_same(const std::vector<LZN::LintResult> &a, const std::vector<LZN::LintResult> &b) {
+  REQUIRE(a.size() == b.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    CHECK(a[i] == b[i]);
+    CHECK(a[i].message == b[i].message);
+    CHECK(a[i].rewrite == b[i].rewrite);
+    CHECK(a[i].depends_on_instance == b[i].depends_on_instance);
+    REQUIRE(a[i].sub_results.size() == b[i].sub_results.size());
+    for (std::size_t j = 0; j < a[i].sub_results.size(); ++j) {
+      CHECK(a[i].sub_results[j].message == b[i].sub_results[j].message);
+      CHECK(a[i].sub_results[j].content == b[i].sub_results[j].content);
+    }
+  }
+}
+} // namespace
+
+TEST_CASE("result serialization", "[util]") {
+  const auto results = sample_results();
+  std::string bytes;
+  LZN::put_results(bytes, results);
+
+  SECTION("round trip") {
+    std::string_view in = bytes;
+    check_same(LZN::take_results(in), results);
+    CHECK(in.empty());
+  }
+
+  SECTION("truncated") {
+    std::string_view in(bytes.data(), bytes.size() - 1);
+    CHECK_THROWS_AS(LZN::take_results(in), std::out_of_range);
+  }
+}
+
+TEST_CASE("shards", "[util]") {
+  LZN::ShardResults shard;
+  shard.index = 2;
+  shard.count = 3;
+  shard.failed = {"broken.mzn"};
+  shard.results = sample_results();
+  const std::string bytes = LZN::put_shard(shard);
+
+  SECTION("round trip") {
+    const LZN::ShardResults read = LZN::take_shard(bytes);
+    CHECK(read.index == 2);
+    CHECK(read.count == 3);
+    CHECK(read.failed == shard.failed);
+    check_same(read.results, shard.results);
+  }
+
+  SECTION("not a shard") {
+    std::string results;
+    LZN::put_results(results, sample_results());
+    CHECK_THROWS_AS(LZN::take_shard(results), std::out_of_range);
+    CHECK_THROWS_AS(LZN::take_shard(bytes + "x"), std::out_of_range);
+  }
+
+  SECTION("merge") {
+    LZN::ShardResults other;
+    other.results = sample_results();
+    other.results.pop_back();
+    other.results.emplace_back(FC::OneLineMarked(1, 1, 2), "lib/a.mzn", other.results[0].rule,
+                               "fourth");
+    const auto merged = LZN::merge_shards({shard, other});
+    REQUIRE(merged.size() == 4);
+    CHECK(std::is_sorted(merged.begin(), merged.end()));
+    CHECK(merged[0].message == "third");
+  }
+}
+
+TEST_CASE("result cache", "[util]") {
+  const LZN::TemporaryDirectory tmp;
+  const fs::path dir = tmp.path();
+  make_project(dir);
+  const std::vector<std::string> includePath{(dir / "std").string()};
+  const std::string model = (dir / "model.mzn").string();
+  const std::vector<std::string> data{(dir / "data.dzn").string()};
+  std::vector<const LZN::LintRule *> rules;
+  for (auto rule : LZN::Registry::iter())
+    rules.push_back(rule);
+
+  const LZN::ResultCache cache((dir / "cache").string());
+  const std::uint64_t key = cache.key(model, data, includePath, rules);
+  CHECK(key == cache.key(model, data, includePath, rules));
+
+  SECTION("store and load") {
+    CHECK_FALSE(cache.load(key));
+    REQUIRE(cache.store(key, sample_results()));
+    auto loaded = cache.load(key);
+    REQUIRE(loaded);
+    check_same(*loaded, sample_results());
+  }
+
+  SECTION("corrupt entries are misses") {
+    REQUIRE(cache.store(key, sample_results()));
+    fs::resize_file(cache.entry_path(key), fs::file_size(cache.entry_path(key)) - 1);
+    CHECK_FALSE(cache.load(key));
+  }
+
+  SECTION("included user files") {
+    auto files = LZN::included_user_files(model, includePath);
+    REQUIRE(files.size() == 2);
+    CHECK(fs::equivalent(files[0], dir / "lib" / "a.mzn"));
+    CHECK(fs::equivalent(files[1], dir / "lib" / "b.mzn"));
+  }
+
+  SECTION("invalidation") {
+    SECTION("transitive include") { write(dir / "lib" / "b.mzn", "var 1..4: y;\n"); }
+    SECTION("data file") { write(dir / "data.dzn", "n = 4;\n"); }
+    SECTION("model") { write(dir / "model.mzn", "include \"lib/a.mzn\";\n"); }
+    SECTION("standard library") { write(dir / "std" / "globals.mzn", "predicate bar();\n"); }
+    SECTION("include shadowing the standard library") {
+      write(dir / "globals.mzn", "predicate foo(var int: x);\n");
+    }
+    CHECK(cache.key(model, data, includePath, rules) != key);
+  }
+
+  SECTION("rules") {
+    rules.pop_back();
+    CHECK(cache.key(model, data, includePath, rules) != key);
+  }
+
+  SECTION("missing model") {
+    CHECK_THROWS_AS(cache.key((dir / "missing.mzn").string(), data, includePath, rules),
+                    std::system_error);
+  }
+}
@@ -0,0 +1,136 @@
+#include "test_common.hpp"
+#include <linter/result_formats.hpp>
+
+namespace {
+std::vector<LZN::LintResult> some_results(const LZN::LintRule *rule) {
+  std::vector<LZN::LintResult> results;
+  results.push_back(LZN_ONELINE(2, 3, 12));
+  results.back().message = "marked";
+  results.back().rewrite = "x > 1";
+  results.back().emplace_subresult("a note");
+  results.back().emplace_subresult("over there", LZN::FileContents::MultiLine{1, 1},
+                                   MODEL_FILENAME);
+  results.emplace_back(std::monostate(), "", rule, "nowhere");
+  results.back().set_depends_on_instance();
+  return results;
+}
+} // namespace
+
+TEST_CASE("result formats", "[util]") {
+  const LZN::LintRule *rule = *LZN::Registry::iter().begin();
+  const auto results = some_results(rule);
+  LZN::CachedFileReader reader;
+  reader.add(MODEL_FILENAME, "var int: x;\n"
+                             "  constraint x > 1;\n");
+
+  SECTION("json") {
+    std::ostringstream os;
+    LZN::json_print(results, os);
+    const LZN::Json j = LZN::Json::parse(os.str());
+    REQUIRE(j["results"].as_array().size() == 2);
+
+    const LZN::Json &first = j["results"].as_array()[0];
+    CHECK(first["rule"]["id"].as_int() == rule->id);
+    CHECK(first["rule"]["name"].as_string() == rule->name);
+    CHECK(first["rule"]["category"].as_string() ==
+          LZN::CATEGORY_NAMES[static_cast<std::size_t>(rule->category)]);
+    CHECK(first["file"].as_string() == MODEL_FILENAME);
+    CHECK(first["region"]["start_line"].as_int() == 2);
+    CHECK(first["region"]["start_column"].as_int() == 3);
+    CHECK(first["region"]["end_column"].as_int() == 12);
+    CHECK(first["message"].as_string() == "marked");
+    CHECK(first["rewrite"].as_string() == "x > 1");
+    CHECK_FALSE(first["depends_on_instance"].as_bool());
+    REQUIRE(first["sub_results"].as_array().size() == 2);
+    CHECK(first["sub_results"].as_array()[0]["file"].is_null());
+    CHECK(first["sub_results"].as_array()[1]["region"]["end_line"].as_int() == 1);
+    // No snippets unless asked for, the file isn't even known to the reader.
+    CHECK(first["snippet"].is_null());
+
+    const LZN::Json &second = j["results"].as_array()[1];
+    CHECK(second["file"].is_null());
+    CHECK(second["region"].is_null());
+    CHECK(second["rewrite"].is_null());
+    CHECK(second["depends_on_instance"].as_bool());
+  }
+
+  SECTION("snippets") {
+    const LZN::Json j = LZN::result_to_json(results[0], &reader);
+    CHECK(j["snippet"].as_string() == "  constraint x > 1;");
+    CHECK(j["sub_results"].as_array()[1]["snippet"].as_string() == "var int: x;");
+  }
+
+  SECTION("sarif") {
+    std::ostringstream os;
+    LZN::sarif_print(results, os, &reader);
+    const LZN::Json j = LZN::Json::parse(os.str());
+    CHECK(j["version"].as_string() == "2.1.0");
+    const LZN::Json &run = j["runs"].as_array().at(0);
+    REQUIRE(run["tool"]["driver"]["rules"].as_array().size() == 1);
+    CHECK(run["tool"]["driver"]["rules"].as_array()[0]["name"].as_string() == rule->name);
+    REQUIRE(run["results"].as_array().size() == 2);
+
+    const LZN::Json &first = run["results"].as_array()[0];
+    CHECK(first["ruleId"].as_string() == std::to_string(rule->id));
+    CHECK(first["ruleIndex"].as_int() == 0);
+    CHECK(first["message"]["text"].as_string() == "marked");
+    const LZN::Json &location = first["locations"].as_array().at(0)["physicalLocation"];
+    CHECK(location["artifactLocation"]["uri"].as_string() == MODEL_FILENAME);
+    CHECK(location["region"]["startColumn"].as_int() == 3);
+    // SARIF end columns are exclusive.
+    CHECK(location["region"]["endColumn"].as_int() == 13);
+    CHECK(location["region"]["snippet"]["text"].as_string() == "  constraint x > 1;");
+    CHECK(first["relatedLocations"].as_array().size() == 2);
+    const LZN::Json &fix = first["fixes"].as_array().at(0);
+    const LZN::Json &replacement =
+        fix["artifactChanges"].as_array().at(0)["replacements"].as_array().at(0);
+    CHECK(replacement["insertedContent"]["text"].as_string() == "x > 1");
+
+    const LZN::Json &second = run["results"].as_array()[1];
+    CHECK(second["locations"].is_null());
+    CHECK(second["properties"]["dependsOnInstance"].as_bool());
+  }
+
+  SECTION("ndjson") {
+    std::ostringstream os;
+    for (const auto &r : results)
+      LZN::ndjson_print(r, os);
+    std::istringstream lines(os.str());
+    std::string line;
+    std::size_t n = 0;
+    while (std::getline(lines, line)) {
+      CHECK(LZN::Json::parse(line) == LZN::result_to_json(results[n]));
+      ++n;
+    }
+    CHECK(n == results.size());
+  }
+
+  SECTION("cut short") {
+    const LZN::LintRule *other = *std::next(LZN::Registry::iter().begin());
+    const std::vector<const LZN::LintRule *> cut_short = {rule, other};
+
+    std::ostringstream json;
+    LZN::json_print(results, json, nullptr, cut_short);
+    const LZN::Json j = LZN::Json::parse(json.str());
+    REQUIRE(j["cut_short"].as_array().size() == 2);
+    CHECK(j["cut_short"].as_array()[1]["name"].as_string() == other->name);
+
+    std::ostringstream sarif;
+    LZN::sarif_print(results, sarif, nullptr, cut_short);
+    const LZN::Json log = LZN::Json::parse(sarif.str());
+    const LZN::Json &run = log["runs"].as_array().at(0);
+    // A rule without results is still described, so that the notification can refer to it.
+    CHECK(run["tool"]["driver"]["rules"].as_array().size() == 2);
+    const LZN::Json &invocation = run["invocations"].as_array().at(0);
+    CHECK(invocation["executionSuccessful"].as_bool());
+    const auto &notifications = invocation["toolExecutionNotifications"].as_array();
+    REQUIRE(notifications.size() == 2);
+    CHECK(notifications[0]["level"].as_string() == "warning");
+    CHECK(notifications[1]["associatedRule"]["id"].as_string() == std::to_string(other->id));
+    CHECK(notifications[1]["associatedRule"]["index"].as_int() == 1);
+
+    std::ostringstream ndjson;
+    LZN::ndjson_print_cut_short(*other, ndjson);
+    CHECK(LZN::Json::parse(ndjson.str())["cut_short"]["id"].as_int() == other->id);
+  }
+}
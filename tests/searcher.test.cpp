@@ -1,4 +1,8 @@
 #include <catch2/catch.hpp>
+#include <algorithm>
+#include <fstream>
+#include <linter/file_utils.hpp>
+#include <linter/item_costs.hpp>
 #include <linter/searcher.hpp>
 #include <minizinc/ast.hh>
 #include <minizinc/gc.hh>
@@ -319,3 +323,131 @@ TEST_CASE("model searcher local filters", "[util]") {
   }
   CHECK(results == 2);
 }
+
+TEST_CASE("model searcher skipped files", "[util]") {
+  const LZN::TemporaryDirectory dir;
+  const std::string datafile = dir.path() + "/data.dzn";
+  std::ofstream(datafile) << "n = 5; a = [1, 2, 3];\n";
+  std::stringstream errstream;
+  MiniZinc::Env env;
+  MiniZinc::Model *m = MiniZinc::parse(env, {}, {datafile},
+                                       "int: n; array[1..3] of int: a; constraint n = 1;",
+                                       "model_name", {}, false, true, false, false, errstream);
+  REQUIRE(m != nullptr);
+  const std::vector<std::string> skipped = {datafile};
+
+  SearchBuilder b;
+  b.in_everywhere().under(ExpressionId::E_INTLIT);
+  SECTION("everything") {
+    Search s = b.build();
+    auto ms = s.search(m);
+    CHECK(number_of_results(ms) == 7);
+  }
+
+  SECTION("data skipped") {
+    Search s = b.skip_files(&skipped).build();
+    auto ms = s.search(m);
+    CHECK(number_of_results(ms) == 3);
+  }
+}
+
+TEST_CASE("model searcher cancellation", "[util]") {
+  MiniZinc::Model *m = parse("constraint 1 = 2; constraint 3 = 4; constraint 5 = 6;");
+  LZN::CancellationToken token;
+  token.reset(std::nullopt);
+  Search s =
+      SearchBuilder().in_constraint().under(ExpressionId::E_INTLIT).cancel_on(&token).build();
+
+  SECTION("not cancelled") {
+    auto ms = s.search(m);
+    CHECK(number_of_results(ms) == 6);
+  }
+
+  SECTION("cancelled halfway") {
+    auto ms = s.search(m);
+    REQUIRE(ms.next());
+    REQUIRE(ms.next());
+    token.cancel();
+    CHECK_FALSE(ms.next());
+    CHECK_FALSE(ms.next());
+    CHECK(ms.cur_item() == nullptr);
+  }
+
+  SECTION("expression searches too") {
+    token.cancel();
+    auto es = s.search((*m)[0]->cast<MiniZinc::ConstraintI>()->e());
+    CHECK(number_of_results(es) == 0);
+  }
+
+  SECTION("deadline") {
+    token.reset(std::chrono::milliseconds(0));
+    // The clock is only read every so often.
+    bool cancelled = false;
+    for (int i = 0; i < 2048 && !cancelled; ++i)
+      cancelled = token.cancelled();
+    CHECK(cancelled);
+    token.reset(std::nullopt);
+    CHECK_FALSE(token.cancelled());
+  }
+}
+
+TEST_CASE("item costs", "[util]") {
+  MiniZinc::Model *m = parse("var int: x;\n"
+                             "constraint x = 1 + 2 + 3;\n"
+                             "constraint x > 0;\n");
+  LZN::ItemCosts costs;
+  {
+    Search s = SearchBuilder().in_vardecl().in_constraint().cost_items(&costs).build();
+    auto ms = s.search(m);
+    CHECK(number_of_results(ms) == 3);
+    Search e = SearchBuilder()
+                   .in_constraint()
+                   .under(ExpressionId::E_INTLIT)
+                   .cost_items(&costs)
+                   .build();
+    auto es = e.search(m);
+    REQUIRE(es.next());
+    // Left halfway, the item still counts.
+  }
+
+  const auto all = costs.top(10);
+  REQUIRE(all.size() == 3);
+  const auto first = std::find_if(all.begin(), all.end(), [](const LZN::ItemCosts::Cost &c) {
+    return c.item == "constraint at model_name:2";
+  });
+  REQUIRE(first != all.end());
+  CHECK(first->visits == 2);
+  CHECK(first->nodes >= 3);
+  CHECK(first->wall.count() >= 0);
+  CHECK(costs.top(1).size() == 1);
+  CHECK(costs.top(1)[0].wall >= all.back().wall);
+
+  std::ostringstream table;
+  costs.print(table, 2);
+  CHECK(table.str().find("model_name:") != std::string::npos);
+}
+
+#ifdef LZN_SEARCH_STATS
+TEST_CASE("search stats", "[util]") {
+  MiniZinc::Model *m = parse("var int: x; constraint 1 = 2; constraint 3 = 4; solve satisfy;");
+  LZN::SearchStats sink;
+  {
+    Search s =
+        SearchBuilder().in_constraint().under(ExpressionId::E_INTLIT).count_into(&sink).build();
+    auto ms = s.search(m);
+    CHECK(number_of_results(ms) == 4);
+
+    const LZN::SearchStats stats = s.stats();
+    CHECK(stats.matches == 4);
+    CHECK(stats.backtracks == 4);
+    CHECK(stats.items_skipped == 2);
+    CHECK(stats.nodes_expanded >= 2);
+    CHECK(stats.children_queued >= 4);
+    CHECK(stats.filter_calls == stats.children_queued);
+    // Only added to the sink when the search is gone.
+    CHECK(sink.searches == 0);
+  }
+  CHECK(sink.searches == 1);
+  CHECK(sink.matches == 4);
+}
+#endif
@@ -0,0 +1,113 @@
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <linter/file_utils.hpp>
+#include <linter/lexer.hpp>
+#include <linter/stdlib_snapshot.hpp>
+
+namespace {
+namespace fs = std::filesystem;
+
+void write(const fs::path &p, const char *contents) {
+  fs::create_directories(p.parent_path());
+  std::ofstream(p) << contents;
+}
+
+// Writes a tiny standard library to `dir`.
+void make_stdlib(const fs::path &dir) {
+  write(dir / "std" / "a.mzn", "include \"b.mzn\";\n"
+                               "include \"sub/c.mzn\";\n"
+                               "predicate foo(var int: x, array[int, int] of var int: y);\n"
+                               "function var int: bar(var int: x) = x;\n");
+  write(dir / "std" / "b.mzn", "% predicate commented(int: x);\n"
+                               "/* test also_commented(int: x) = true; */\n"
+                               "test baz() = true;\n"
+                               "annotation qux;\n");
+  write(dir / "std" / "sub" / "c.mzn", "include \"b.mzn\";\n"
+                                       "predicate foo(var bool: x);\n");
+}
+} // namespace
+
+TEST_CASE("tokenize", "[util]") {
+  auto tokens = LZN::tokenize("include \"x.mzn\"; % comment\n"
+                              "constraint 'not'(a) /\\ b[1..3];");
+  REQUIRE(tokens.size() == 18);
+  CHECK(tokens[0].is_ident("include"));
+  CHECK(tokens[1].is(LZN::Token::Kind::STRING, "x.mzn"));
+  CHECK(tokens[3].is_ident("constraint"));
+  CHECK(tokens[3].line == 2);
+  CHECK(tokens[4].is_ident("not"));
+  CHECK(tokens[12].is(LZN::Token::Kind::OTHER, "1"));
+  CHECK(tokens[13].is_punct('.'));
+
+  auto includes = LZN::included_files(tokens);
+  REQUIRE(includes.size() == 1);
+  CHECK(includes[0] == "x.mzn");
+}
+
+TEST_CASE("stdlib snapshot", "[util]") {
+  const LZN::TemporaryDirectory tmp;
+  const fs::path dir = tmp.path();
+  make_stdlib(dir);
+  const std::string stdlib = (dir / "std").string();
+  const std::string cache = (dir / "cache").string();
+
+  auto snap = LZN::StdlibSnapshot::load_or_build(stdlib, cache);
+  CHECK(fs::exists(LZN::StdlibSnapshot::snapshot_path(cache, snap.stat_key())));
+
+  SECTION("files and includes") {
+    REQUIRE(snap.num_files() == 3);
+    auto a = snap.find_file("a.mzn");
+    auto b = snap.find_file("b.mzn");
+    auto c = snap.find_file("sub/c.mzn");
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE(c);
+    CHECK(snap.includes(a.value()) == std::vector<std::uint32_t>{b.value(), c.value()});
+    CHECK(snap.includes(c.value()) == std::vector<std::uint32_t>{b.value()});
+    CHECK(!snap.find_file("d.mzn"));
+  }
+
+  SECTION("declarations") {
+    auto foo = snap.declarations("foo");
+    REQUIRE(foo.size() == 2);
+    std::sort(foo.begin(), foo.end(),
+              [](const auto &l, const auto &r) { return l.arity < r.arity; });
+    CHECK(snap.file(foo[0].file) == "sub/c.mzn");
+    CHECK(foo[1].arity == 2);
+    CHECK(foo[1].line == 3);
+    CHECK(foo[1].kind == LZN::StdlibSnapshot::DeclKind::PREDICATE);
+
+    auto bar = snap.declarations("bar");
+    REQUIRE(bar.size() == 1);
+    CHECK(bar[0].kind == LZN::StdlibSnapshot::DeclKind::FUNCTION);
+    CHECK(bar[0].arity == 1);
+
+    auto baz = snap.declarations("baz");
+    REQUIRE(baz.size() == 1);
+    CHECK(baz[0].arity == 0);
+    CHECK(snap.declarations("qux").size() == 1);
+    CHECK(snap.declarations("commented").empty());
+    CHECK(snap.declarations("also_commented").empty());
+  }
+
+  SECTION("reloaded from disk") {
+    auto again = LZN::StdlibSnapshot::load_or_build(stdlib, cache);
+    CHECK(again.stat_key() == snap.stat_key());
+    CHECK(again.declarations("foo").size() == 2);
+  }
+
+  SECTION("changes invalidate") {
+    write(dir / "std" / "b.mzn", "test baz(int: x) = true;\n");
+    auto changed = LZN::StdlibSnapshot::load_or_build(stdlib, cache);
+    CHECK(changed.stat_key() != snap.stat_key());
+    REQUIRE(changed.declarations("baz").size() == 1);
+    CHECK(changed.declarations("baz")[0].arity == 1);
+  }
+
+  SECTION("without a cache directory") {
+    auto mem = LZN::StdlibSnapshot::load_or_build(stdlib, "");
+    CHECK(mem.stat_key() == snap.stat_key());
+    CHECK(mem.declarations("bar").size() == 1);
+  }
+}
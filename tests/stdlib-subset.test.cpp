@@ -0,0 +1,137 @@
+#include "test_common.hpp"
+#include <filesystem>
+#include <fstream>
+#include <linter/file_utils.hpp>
+#include <linter/stdlib_subset.hpp>
+
+namespace {
+namespace fs = std::filesystem;
+
+void write(const fs::path &p, const char *contents) {
+  fs::create_directories(p.parent_path());
+  std::ofstream(p) << contents;
+}
+
+std::string read(const fs::path &p) {
+  std::ifstream f(p);
+  return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+}
+
+// Writes a tiny standard library to `dir`, with a `globals.mzn` that includes one file per global.
+void make_stdlib(const fs::path &dir) {
+  write(dir / "std" / "stdlib.mzn", "include \"builtins.mzn\";\n");
+  write(dir / "std" / "builtins.mzn", "predicate int_eq(var int: x, var int: y);\n");
+  write(dir / "std" / "globals.mzn", "include \"foo.mzn\";\n"
+                                     "include \"bar.mzn\";\n"
+                                     "include \"baz.mzn\";\n"
+                                     "include \"qux.mzn\";\n");
+  write(dir / "std" / "foo.mzn", "include \"fzn_foo.mzn\";\n"
+                                 "predicate foo(array[int] of var int: x) = fzn_foo(x);\n");
+  write(dir / "std" / "fzn_foo.mzn", "predicate fzn_foo(array[int] of var int: x) = baz(x[1]);\n");
+  write(dir / "std" / "bar.mzn", "predicate bar(var int: x);\n");
+  write(dir / "std" / "baz.mzn", "predicate baz(var int: x);\n");
+  write(dir / "std" / "qux.mzn", "test '++'(int: x, int: y) = true;\n");
+  write(dir / "std" / "only.mzn", "predicate only(var int: x);\n");
+}
+
+// The files of the standard library in `dir` that `model` needs.
+std::vector<std::string> reduce(const fs::path &dir, const char *model) {
+  write(dir / "model.mzn", model);
+  return LZN::reduced_include_path({(dir / "model.mzn").string()}, {(dir / "std/").string()},
+                                   (dir / "cache").string());
+}
+} // namespace
+
+TEST_CASE("reduced include path", "[util]") {
+  const LZN::TemporaryDirectory tmp;
+  const fs::path dir = tmp.path();
+  make_stdlib(dir);
+  const std::vector<std::string> full = {(dir / "std/").string()};
+
+  SECTION("keeps what is used, transitively, and operators") {
+    const auto path = reduce(dir, "include \"globals.mzn\";\n"
+                                  "array[1..2] of var int: x;\n"
+                                  "constraint foo(x);\n");
+    REQUIRE(path.size() == 2);
+    CHECK(path[1] == full[0]);
+    CHECK(read(fs::path(path[0]) / "globals.mzn") ==
+          "% globals.mzn reduced by lzn to what the model uses\n"
+          "include \"foo.mzn\";\n"
+          "include \"baz.mzn\";\n"
+          "include \"qux.mzn\";\n");
+  }
+
+  SECTION("the same model gets the same copies") {
+    const char *model = "include \"globals.mzn\";\n"
+                        "constraint bar(1);\n";
+    CHECK(reduce(dir, model) == reduce(dir, model));
+    CHECK(reduce(dir, model) != reduce(dir, "include \"globals.mzn\";\n"
+                                            "constraint baz(1);\n"));
+  }
+
+  SECTION("included user files count too") {
+    write(dir / "lib.mzn", "include \"globals.mzn\";\n"
+                           "predicate mine(var int: x) = bar(x);\n");
+    const auto path = reduce(dir, "include \"lib.mzn\";\n");
+    REQUIRE(path.size() == 2);
+    CHECK(read(fs::path(path[0]) / "globals.mzn").find("include \"bar.mzn\";") !=
+          std::string::npos);
+  }
+
+  SECTION("nothing to leave out") {
+    CHECK(reduce(dir, "constraint int_eq(1, 1);\n") == full);
+    // Files that declare something themselves are never copied.
+    CHECK(reduce(dir, "include \"only.mzn\";\n") == full);
+    // Everything is used.
+    CHECK(reduce(dir, "include \"globals.mzn\";\n"
+                      "constraint foo([1]) /\\ bar(1);\n") == full);
+    // A user file shadows the standard library.
+    write(dir / "globals.mzn", "include \"foo.mzn\";\n");
+    CHECK(reduce(dir, "include \"globals.mzn\";\n") == full);
+  }
+}
+
+TEST_CASE("reduced standard library gives the same results", "[util]") {
+  const LZN::TemporaryDirectory tmp;
+  const fs::path dir = tmp.path();
+  const std::string model = (dir / "model.mzn").string();
+  std::ofstream(model) << "include \"globals.mzn\";\n"
+                          "array[1..4] of var 0..1: x;\n"
+                          "var 1..4: i;\n"
+                          "constraint alldifferent(x) \\/ element(i, x, 1);\n"
+                          "constraint increasing(x);\n"
+                          "constraint forall(j in 1..4 where x[j] > 0)(x[j] = 1);\n"
+                          "solve satisfy;\n";
+
+  const std::vector<std::string> full = {"../../deps/libminizinc/share/minizinc/std/"};
+  const auto reduced = LZN::reduced_include_path({model}, full, (dir / "cache").string());
+  REQUIRE(reduced.size() == full.size() + 1);
+
+  auto lint = [&model](const std::vector<std::string> &includePaths) {
+    std::stringstream errstream;
+    MiniZinc::Env env;
+    MiniZinc::Model *m = MiniZinc::parse(env, {model}, {}, "", "", includePaths, false, false,
+                                         false, false, errstream);
+    REQUIRE(m != nullptr);
+    std::vector<MiniZinc::TypeError> typeErrors;
+    MiniZinc::typecheck(env, m, typeErrors, true, false);
+    REQUIRE(typeErrors.empty());
+
+    LZN::LintEnv lenv(m, env, includePaths);
+    for (auto rule : LZN::Registry::iter())
+      rule->run(lenv);
+    auto results = lenv.take_results();
+    std::sort(results.begin(), results.end());
+    return results;
+  };
+
+  const auto with_full = lint(full);
+  const auto with_reduced = lint(reduced);
+  REQUIRE_FALSE(with_full.empty());
+  REQUIRE(with_reduced.size() == with_full.size());
+  for (std::size_t i = 0; i < with_full.size(); ++i) {
+    CHECK(with_reduced[i] == with_full[i]);
+    CHECK(with_reduced[i].message == with_full[i].message);
+    CHECK(with_reduced[i].rewrite == with_full[i].rewrite);
+  }
+}
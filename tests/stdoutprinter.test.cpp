@@ -0,0 +1,66 @@
+#include "test_common.hpp"
+#include <fstream>
+#include <linter/file_utils.hpp>
+#include <linter/stdoutprinter.hpp>
+
+TEST_CASE("print results", "[util]") {
+  const LZN::LintRule *rule = *LZN::Registry::iter().begin();
+  LZN::CachedFileReader reader;
+  reader.add(MODEL_FILENAME, "var int: x;\n"
+                             "  constraint\tx > 1 /\\\n"
+                             "    x < 5;\n");
+
+  std::vector<LZN::LintResult> results;
+  results.push_back(LZN_ONELINE(2, 3, 12));
+  results.back().message = "marked";
+  results.back().rewrite = "constraint x > 1;\n  x < 5;";
+  results.back().emplace_subresult("a note");
+  results.emplace_back(LZN::FileContents::MultiLine{1, 3}, MODEL_FILENAME, rule, "lines");
+
+  std::ostringstream os;
+  LZN::stdout_print(results, os, reader);
+  const std::string name = std::string(rule->name) + '(' + std::to_string(rule->id) + ')';
+  CHECK(os.str() == std::string(MODEL_FILENAME) + ":2.3-2.12: marked [" + name + "]\n" +
+                        "   |     constraint x > 1 /\\\n"
+                        "   |     ^~~~~~~~~~\n"
+                        "rewrite as: \n"
+                        "   |     constraint x > 1;\n"
+                        "   |       x < 5;\n"
+                        "NOTE: a note\n" +
+                        MODEL_FILENAME + ":1-3: lines [" + name + "]\n" +
+                        "   |     var int: x;\n"
+                        "   |       constraint x > 1 /\\\n"
+                        "   |         x < 5;\n"
+                        "   |     \n");
+
+  // More results than fit in a block of the buffer.
+  const std::string last = os.str().substr(os.str().find(std::string(MODEL_FILENAME) + ":1-3:"));
+  std::ostringstream many;
+  LZN::stdout_print(std::vector<LZN::LintResult>(2000, results.back()), many, reader);
+  CHECK(many.str().size() == 2000 * last.size());
+  CHECK(many.str().substr(many.str().size() - last.size()) == last);
+}
+
+TEST_CASE("cached file reader", "[util]") {
+  const LZN::TemporaryDirectory dir;
+  const std::string file = dir.path() + "/model.mzn";
+  std::ofstream(file, std::ios::binary) << "a\r\nb\n\r\n  c\r\r\nlast";
+
+  LZN::CachedFileReader reader;
+  auto lines = [&reader](const std::string &filename, unsigned int start, unsigned int end) {
+    std::vector<std::string> v;
+    for (auto [it, last] = reader.read(filename, start, end); it != last; ++it)
+      v.emplace_back(*it);
+    return v;
+  };
+  CHECK(lines(file, 1, 2) == std::vector<std::string>{"a", "b"});
+  CHECK(lines(file, 3, 9) == std::vector<std::string>{"", "  c\r", "last"});
+  CHECK(lines(file, 6, 9).empty());
+  // The reader keeps a copy, so the file may be truncated while its lines are in use.
+  std::ofstream(file, std::ios::trunc);
+  CHECK(lines(file, 1, 2) == std::vector<std::string>{"a", "b"});
+  CHECK_THROWS_AS(reader.read(file + ".missing", 1, 1), std::system_error);
+
+  reader.add(file, "replaced\n\n");
+  CHECK(lines(file, 1, 3) == std::vector<std::string>{"replaced", ""});
+}
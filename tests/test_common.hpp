@@ -1,6 +1,8 @@
 #pragma once
 
 #include <catch2/catch.hpp>
+#include <fstream>
+#include <linter/file_utils.hpp>
 #include <linter/registry.hpp>
 #include <minizinc/astexception.hh>
 #include <minizinc/parser.hh>
@@ -41,9 +43,11 @@ inline constexpr const char *const MODEL_FILENAME = "testmodel";
   char buf;                                                                                        \
   REQUIRE(errstream.readsome(&buf, 1) == 0);
 
-#define LZN_ONLY_PARSE(s)                                                                          \
-  MiniZinc::Model *model = MiniZinc::parse(env, {}, {}, (s), MODEL_FILENAME, includePaths, false,  \
-                                           false, false, false, errstream);                        \
+#define LZN_ONLY_PARSE(s) LZN_ONLY_PARSE_WITH(s, {})
+
+#define LZN_ONLY_PARSE_WITH(s, datafiles)                                                          \
+  MiniZinc::Model *model = MiniZinc::parse(env, {}, datafiles, (s), MODEL_FILENAME, includePaths,  \
+                                           false, false, false, false, errstream);                 \
   if (model == nullptr)                                                                            \
     errstream >> std::cerr.rdbuf();                                                                \
   assert(model != nullptr);                                                                        \
@@ -58,5 +62,16 @@ inline constexpr const char *const MODEL_FILENAME = "testmodel";
   rule->run(lenv);                                                                                 \
   results = lenv.take_results();
 
+// Like LZN_MODEL, with `dzn` in a data file. The linter only loads data files for rules that use
+// the data, so the rule must say so.
+#define LZN_MODEL_DATA(s, dzn)                                                                     \
+  REQUIRE(rule->data == LZN::Data::USED);                                                          \
+  const LZN::TemporaryDirectory datadir;                                                           \
+  const std::string datafile = datadir.path() + "/data.dzn";                                       \
+  std::ofstream(datafile) << (dzn);                                                                \
+  LZN_ONLY_PARSE_WITH(s, {datafile});                                                              \
+  rule->run(lenv);                                                                                 \
+  results = lenv.take_results();
+
 #define LZN_ONELINE(...)                                                                           \
   LZN::LintResult(LZN::FileContents::OneLineMarked{__VA_ARGS__}, MODEL_FILENAME, rule, "")
@@ -0,0 +1,123 @@
+#include <catch2/catch.hpp>
+#include <linter/timings.hpp>
+#include <sstream>
+#include <vector>
+
+TEST_CASE("timings", "[util]") {
+  using Kind = LZN::Timings::Kind;
+  LZN::Timings timings;
+  { LZN::Timings::Scope scope(&timings, Kind::PHASE, "parse"); }
+  { LZN::Timings::Scope scope(&timings, Kind::CACHE, "constraints", "first-rule"); }
+  { LZN::Timings::Scope scope(&timings, Kind::CACHE, "constraints", "second-rule"); }
+  { LZN::Timings::Scope scope(nullptr, Kind::PHASE, "not measured"); }
+  timings.add(Kind::RULE, "parse", LZN::Timings::Stamp::now()).results = 2;
+
+  const auto &entries = timings.entries();
+  REQUIRE(entries.size() == 3);
+  CHECK(entries[0].name == "parse");
+  CHECK(entries[0].kind == Kind::PHASE);
+  CHECK(entries[0].wall.count() >= 0);
+  CHECK_FALSE(entries[0].results);
+  CHECK(entries[1].calls == 2);
+  CHECK(entries[1].first_used_by == "first-rule");
+  // A rule may have the name of a phase.
+  CHECK(entries[2].kind == Kind::RULE);
+  CHECK(entries[2].results == 2u);
+
+  const LZN::Json j = timings.to_json();
+  REQUIRE(j.as_array().size() == 3);
+  CHECK(j.as_array()[1]["kind"].as_string() == "cache");
+  CHECK(j.as_array()[1]["first_used_by"].as_string() == "first-rule");
+  CHECK(j.as_array()[2]["results"].as_int() == 2);
+  CHECK(j.as_array()[0]["results"].is_null());
+
+  std::ostringstream table;
+  timings.print(table);
+  CHECK(table.str().find("first-rule") != std::string::npos);
+}
+
+TEST_CASE("trace", "[util]") {
+  using Kind = LZN::Timings::Kind;
+  LZN::Trace trace;
+  LZN::Timings timings;
+  timings.trace(&trace);
+  { LZN::Timings::Scope scope(&timings, Kind::PHASE, "parse"); }
+  { LZN::Timings::Scope scope(&timings, Kind::PHASE, "parse"); }
+  trace.add("constraint at model.mzn:3", "item", LZN::Trace::Clock::now(), LZN::Json().set("n", 1));
+
+  // Every span is an event of its own, unlike the timings.
+  CHECK(timings.entries().size() == 1);
+  const LZN::Json j = trace.to_json();
+  const auto &events = j["traceEvents"].as_array();
+  REQUIRE(events.size() == 3);
+  CHECK(events[0]["name"].as_string() == "parse");
+  CHECK(events[0]["cat"].as_string() == "phase");
+  CHECK(events[0]["ph"].as_string() == "X");
+  CHECK(events[1]["ts"].as_double() >= events[0]["ts"].as_double());
+  CHECK(events[1]["dur"].as_double() >= 0);
+  CHECK(events[2]["cat"].as_string() == "item");
+  CHECK(events[2]["args"]["n"].as_int() == 1);
+  CHECK(events[2]["pid"] == events[0]["pid"]);
+  CHECK(events[2]["tid"] == events[0]["tid"]);
+  // The result can be read back.
+  CHECK(LZN::Json::parse(j.dump())["traceEvents"].as_array().size() == 3);
+}
+
+TEST_CASE("memory of spans", "[util]") {
+  using Kind = LZN::Timings::Kind;
+  LZN::Timings timings(true);
+  {
+    LZN::Timings::Scope outer(&timings, Kind::PHASE, "typecheck");
+    {
+      LZN::Timings::Scope inner(&timings, Kind::RULE, "allocates");
+      std::vector<char> v(1 << 20);
+      CHECK(v.size() == 1 << 20);
+    }
+  }
+  LZN::Timings::Scope not_measured(nullptr, Kind::PHASE, "print");
+
+  const auto &entries = timings.entries();
+  REQUIRE(entries.size() == 2);
+  CHECK(entries[0].name == "allocates");
+  REQUIRE(entries[0].memory);
+  REQUIRE(entries[1].memory);
+  CHECK(entries[0].memory->max_rss_kib >= 0);
+  if (LZN::counts_allocations) {
+    CHECK(entries[0].memory->allocations >= 1);
+    CHECK(entries[0].memory->bytes >= 1 << 20);
+    CHECK(entries[0].memory->peak >= 1 << 20);
+    // The enclosing span still sees the peak of the nested one.
+    CHECK(entries[1].memory->peak >= 1 << 20);
+  }
+
+  std::ostringstream table;
+  timings.print_memory(table);
+  CHECK(table.str().find("allocates") != std::string::npos);
+  CHECK(timings.to_json().as_array()[0]["memory"].is_object());
+}
+
+TEST_CASE("hardware counters of spans", "[util]") {
+  using Kind = LZN::Timings::Kind;
+  // Containers often don't allow the counters, which must not be an error.
+  LZN::PerfCounters counters;
+  if (!counters.any_available())
+    CHECK_FALSE(counters.unavailable_reason().empty());
+  LZN::Timings timings;
+  timings.counters(&counters);
+  {
+    LZN::Timings::Scope scope(&timings, Kind::RULE, "counted");
+    volatile unsigned long sum = 0;
+    for (unsigned long i = 0; i < 100000; ++i)
+      sum = sum + i;
+  }
+  const auto &entries = timings.entries();
+  REQUIRE(entries.size() == 1);
+  REQUIRE(entries[0].counters);
+  if (counters.available(LZN::PerfCounters::INSTRUCTIONS))
+    CHECK((*entries[0].counters)[LZN::PerfCounters::INSTRUCTIONS] > 100000);
+  else
+    CHECK((*entries[0].counters)[LZN::PerfCounters::INSTRUCTIONS] == 0);
+  std::ostringstream table;
+  timings.print_counters(table);
+  CHECK(table.str().find("counted") != std::string::npos);
+}
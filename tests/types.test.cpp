@@ -0,0 +1,87 @@
+#include "test_common.hpp"
+#include <linter/stdoutprinter.hpp>
+
+namespace {
+const char *const MODEL = "include \"globals.mzn\";\n"
+                          "array[1..3] of var 1..5: a;\n"
+                          "var 1..3: i;\n"
+                          "var 1..5: v;\n"
+                          "constraint element(i, a, v);\n"
+                          "constraint increasing(a);\n"
+                          "solve satisfy;\n";
+
+// Runs every rule with `types` on `model`, which is only typechecked if `typecheck` is set.
+std::vector<LZN::LintResult> lint(const char *model, LZN::Types types, bool typecheck) {
+  const std::vector<std::string> includePaths = {"../../deps/libminizinc/share/minizinc/std/"};
+  std::stringstream errstream;
+  MiniZinc::Env env;
+  MiniZinc::Model *m = MiniZinc::parse(env, {}, {}, model, MODEL_FILENAME, includePaths, false,
+                                       false, false, false, errstream);
+  REQUIRE(m != nullptr);
+  if (typecheck) {
+    std::vector<MiniZinc::TypeError> typeErrors;
+    MiniZinc::typecheck(env, m, typeErrors, true, false);
+    REQUIRE(typeErrors.empty());
+  }
+
+  LZN::LintEnv lenv(m, env, includePaths);
+  for (auto rule : LZN::Registry::iter()) {
+    if (rule->types == types)
+      rule->run(lenv);
+  }
+  auto results = lenv.take_results();
+  std::sort(results.begin(), results.end());
+  return results;
+}
+} // namespace
+
+TEST_CASE("rules that don't use types", "[types]") {
+  const auto typed = lint(MODEL, LZN::Types::UNUSED, true);
+  const auto parsed = lint(MODEL, LZN::Types::UNUSED, false);
+  REQUIRE(typed.size() == 2);
+  REQUIRE(parsed.size() == typed.size());
+  for (std::size_t i = 0; i < parsed.size(); ++i) {
+    CHECK(parsed[i] == typed[i]);
+    CHECK(parsed[i].message == typed[i].message);
+    CHECK(parsed[i].rewrite == typed[i].rewrite);
+  }
+
+  SECTION("on a model with type errors") {
+    std::string broken = MODEL;
+    broken += "constraint v = true;\n";
+    const auto results = lint(broken.c_str(), LZN::Types::UNUSED, false);
+    REQUIRE(results.size() == typed.size());
+    for (std::size_t i = 0; i < results.size(); ++i)
+      CHECK(results[i] == typed[i]);
+  }
+
+  SECTION("printed after typechecking") {
+    // As in the driver, the rules run on the parsed model, which is then typechecked before their
+    // results are printed.
+    const std::vector<std::string> includePaths = {"../../deps/libminizinc/share/minizinc/std/"};
+    std::stringstream errstream;
+    MiniZinc::Env env;
+    MiniZinc::Model *m = MiniZinc::parse(env, {}, {}, MODEL, MODEL_FILENAME, includePaths, false,
+                                         false, false, false, errstream);
+    REQUIRE(m != nullptr);
+    LZN::LintEnv lenv(m, env, includePaths);
+    for (auto rule : LZN::Registry::iter()) {
+      if (rule->types == LZN::Types::UNUSED)
+        rule->run(lenv);
+    }
+    auto results = lenv.take_results();
+    std::sort(results.begin(), results.end());
+    std::vector<MiniZinc::TypeError> typeErrors;
+    MiniZinc::typecheck(env, m, typeErrors, true, false);
+    REQUIRE(typeErrors.empty());
+
+    LZN::CachedFileReader reader;
+    reader.add(MODEL_FILENAME, MODEL);
+    std::ostringstream printed;
+    LZN::stdout_print(results, printed, reader);
+    std::ostringstream expected;
+    LZN::stdout_print(typed, expected, reader);
+    CHECK(printed.str() == expected.str());
+    CHECK(printed.str().find("rewrite as") != std::string::npos);
+  }
+}
@@ -47,6 +47,24 @@ TEST_CASE("0..1 variables", "[rule]") {
     LZN_EXPECTED();
   }
 
+  SECTION("simple imply domain from data") {
+    LZN_MODEL_DATA("int: n;\n"
+                   "var 0..n: a;\n"
+                   "var 0..1: b;\n"
+                   "constraint a = 1 -> b = 1;",
+                   "n = 1;");
+    LZN_EXPECTED(LZN_ONELINE(4, 12, 25));
+  }
+
+  SECTION("simple imply wrong domain from data") {
+    LZN_MODEL_DATA("int: n;\n"
+                   "var 0..n: a;\n"
+                   "var 0..1: b;\n"
+                   "constraint a = 1 -> b = 1;",
+                   "n = 2;");
+    LZN_EXPECTED();
+  }
+
   SECTION("simple imply offset domains") {
     LZN_MODEL("var 0..1: a;\n"
               "var 1..2: b;\n"